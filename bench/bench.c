@@ -0,0 +1,278 @@
+//////////////////////////////////////////////////////////////
+// nes-bench: headless throughput benchmark for libnescore
+//
+// Runs each ROM for a number of frames with no display and no
+// frame limiter, and reports frames/sec, ns per emulated CPU
+// cycle and ns per PPU dot (min/median over repetitions, and
+// p99 from 100 repetitions on).
+//
+// Usage: nes-bench [options] <rom.nes> [<rom.nes> ...]
+//////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/nes.h"
+
+#define DEFAULT_FRAMES  600
+#define DEFAULT_REPS    5
+#define DEFAULT_WARMUP  60
+#define P99_MIN_REPS    100 // below this the nearest-rank p99 is just the slowest repetition
+
+// make release compiles trace sites out of the core, record which kind of build was measured
+#ifdef NES_RELEASE
+#define BUILD_TYPE "release"
+#else
+#define BUILD_TYPE "default"
+#endif
+
+#define SAMPLES_PER_FRAME (AUDIO_SAMPLE_RATE / 60) // audio drained per frame, like the SDL frontend
+
+typedef struct Stats {
+    double min;
+    double median;
+    double p99;     // the slow tail: 99th percentile of times, its mirror rank for throughputs
+    int has_p99;    // 0 with fewer than P99_MIN_REPS repetitions (p99 is left out)
+} Stats;
+
+typedef struct BenchResult {
+    const char *rom;
+    uint64_t cpu_cycles;   // CPU cycles emulated in one repetition (last one)
+    Stats fps;
+    Stats ns_per_cycle;
+    Stats ns_per_dot;
+} BenchResult;
+
+int frames = DEFAULT_FRAMES;
+int reps = DEFAULT_REPS;
+int warmup = DEFAULT_WARMUP;
+int audio_enable = 1;
+int dot_accurate = 0;
+int idle_skip = 1;
+char *json_path = NULL;
+
+void usage(const char *prog);
+uint64_t now_ns();
+void run_frames(NES *nes, int count, int16_t *audio_buffer);
+void bench_rom(const char *rom, BenchResult *result);
+Stats compute_stats(double *values, int count, int higher_is_better);
+void write_json(FILE *out, BenchResult *results, int count);
+
+int main(int argc, char *argv[]) {
+    char **roms = (char **)malloc(sizeof(char *) * argc);
+    int rom_count = 0;
+
+    // parse cli arguments
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-audio") == 0) {
+            audio_enable = 0;
+        } else if (strcmp(argv[i], "--dot-accurate") == 0) {
+            dot_accurate = 1;
+        } else if (strcmp(argv[i], "--no-idle-skip") == 0) {
+            idle_skip = 0;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            usage(argv[0]);
+            exit(1);
+        } else {
+            roms[rom_count++] = argv[i];
+        }
+    }
+
+    if (rom_count == 0 || frames <= 0 || reps <= 0 || warmup < 0) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    // JSON on stdout keeps stdout to itself: everything else printed (the core's init messages,
+    // the summary) goes to stderr from here on
+    FILE *json_out = NULL;
+    if (json_path && strcmp(json_path, "-") == 0) {
+        fflush(stdout);
+        json_out = fdopen(dup(STDOUT_FILENO), "w");
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    } else if (json_path) {
+        json_out = fopen(json_path, "w");
+    }
+    if (json_path && !json_out) {
+        fprintf(stderr, "Failed to open %s for writing\n", json_path);
+        exit(1);
+    }
+
+    BenchResult *results = (BenchResult *)malloc(sizeof(BenchResult) * rom_count);
+    for (int i = 0; i < rom_count; i++) {
+        bench_rom(roms[i], &results[i]);
+    }
+
+    // human readable summary
+    printf("\nBuild: %s, PPU: %s, idle skip: %s\n", BUILD_TYPE, dot_accurate ? "dot-accurate" : "line-batched",
+           idle_skip ? "on" : "off");
+    printf("%-32s %10s %10s %10s %12s %12s\n", "ROM", "fps(min)", "fps(med)", "fps(p99)", "ns/cycle", "ns/dot");
+    for (int i = 0; i < rom_count; i++) {
+        const char *name = strrchr(results[i].rom, '/');
+        name = name ? name + 1 : results[i].rom;
+        char p99[16] = "-";
+        if (results[i].fps.has_p99) {
+            snprintf(p99, sizeof(p99), "%.1f", results[i].fps.p99);
+        }
+        printf("%-32.32s %10.1f %10.1f %10s %12.3f %12.3f\n", name,
+               results[i].fps.min, results[i].fps.median, p99,
+               results[i].ns_per_cycle.median, results[i].ns_per_dot.median);
+    }
+    if (reps < P99_MIN_REPS) {
+        printf("(p99 needs --reps %d or more)\n", P99_MIN_REPS);
+    }
+
+    // machine readable output
+    if (json_out) {
+        fflush(stdout);
+        write_json(json_out, results, rom_count);
+        fclose(json_out);
+        if (strcmp(json_path, "-") != 0) {
+            printf("\nResults written to %s\n", json_path);
+        }
+    }
+
+    free(results);
+    free(roms);
+    return 0;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--frames <n>] [--reps <n>] [--warmup <n>] [--no-audio] [--dot-accurate] [--no-idle-skip] [--json <file|->] <rom.nes> [<rom.nes> ...]\n", prog);
+}
+
+uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void run_frames(NES *nes, int count, int16_t *audio_buffer) {
+    for (int f = 0; f < count; f++) {
+        nes_run_frame(nes);
+        if (audio_enable) {
+            nes_read_audio(nes, audio_buffer, SAMPLES_PER_FRAME);
+        }
+    }
+}
+
+void bench_rom(const char *rom, BenchResult *result) {
+    int16_t audio_buffer[SAMPLES_PER_FRAME];
+    double *fps = (double *)malloc(sizeof(double) * reps);
+    double *ns_per_cycle = (double *)malloc(sizeof(double) * reps);
+    double *ns_per_dot = (double *)malloc(sizeof(double) * reps);
+
+    NES *nes = nes_init((char *)rom, NULL);
+    nes_set_dot_accurate(nes, dot_accurate);
+    nes_set_idle_skip(nes, idle_skip);
+
+    // let the game get past its boot sequence before timing
+    run_frames(nes, warmup, audio_buffer);
+
+    uint64_t cycles = 0;
+    for (int r = 0; r < reps; r++) {
+        uint64_t start_cycles = nes->cycles;
+        uint64_t start = now_ns();
+
+        run_frames(nes, frames, audio_buffer);
+
+        uint64_t elapsed = now_ns() - start;
+        cycles = nes->cycles - start_cycles;
+
+        // the PPU runs 3 dots per CPU cycle
+        fps[r] = (double)frames * 1e9 / (double)elapsed;
+        ns_per_cycle[r] = (double)elapsed / (double)cycles;
+        ns_per_dot[r] = (double)elapsed / (double)(cycles * 3);
+
+        fprintf(stderr, "[%s] rep %d/%d: %.1f fps, %.3f ns/cycle\n", rom, r + 1, reps, fps[r], ns_per_cycle[r]);
+    }
+
+    nes_free(nes);
+
+    result->rom = rom;
+    result->cpu_cycles = cycles;
+    result->fps = compute_stats(fps, reps, 1);
+    result->ns_per_cycle = compute_stats(ns_per_cycle, reps, 0);
+    result->ns_per_dot = compute_stats(ns_per_dot, reps, 0);
+
+    free(fps);
+    free(ns_per_cycle);
+    free(ns_per_dot);
+}
+
+int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+Stats compute_stats(double *values, int count, int higher_is_better) {
+    // percentiles are nearest-rank over the per-repetition values (ascending)
+    qsort(values, count, sizeof(double), compare_double);
+
+    Stats stats;
+    stats.min = values[0];
+    stats.median = (count % 2) ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+    // p99 is the slow tail, the low end for throughputs (fps) and the high end for times. With
+    // fewer than P99_MIN_REPS values it would only repeat the slowest one, so it is left out
+    stats.has_p99 = count >= P99_MIN_REPS;
+    stats.p99 = 0.0;
+    if (!stats.has_p99) {
+        return stats;
+    }
+    // (mirrored for throughputs, so both pick the same repetition when the rankings agree)
+    int p99_rank = (99 * count + 99) / 100; // ceil(0.99 * count)
+    stats.p99 = higher_is_better ? values[count - p99_rank] : values[p99_rank - 1];
+    return stats;
+}
+
+void write_stats(FILE *out, const char *name, Stats stats, int last) {
+    fprintf(out, "      \"%s\": {\"min\": %.6f, \"median\": %.6f, ", name, stats.min, stats.median);
+    if (stats.has_p99) {
+        fprintf(out, "\"p99\": %.6f}%s\n", stats.p99, last ? "" : ",");
+    } else {
+        fprintf(out, "\"p99\": null}%s\n", last ? "" : ",");
+    }
+}
+
+void write_json(FILE *out, BenchResult *results, int count) {
+    fprintf(out, "{\n");
+    fprintf(out, "  \"build\": \"%s\",\n", BUILD_TYPE);
+    fprintf(out, "  \"frames\": %d,\n", frames);
+    fprintf(out, "  \"reps\": %d,\n", reps);
+    fprintf(out, "  \"warmup\": %d,\n", warmup);
+    fprintf(out, "  \"audio\": %s,\n", audio_enable ? "true" : "false");
+    fprintf(out, "  \"dot_accurate\": %s,\n", dot_accurate ? "true" : "false");
+    fprintf(out, "  \"idle_skip\": %s,\n", idle_skip ? "true" : "false");
+    fprintf(out, "  \"results\": [\n");
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "    {\n");
+        fprintf(out, "      \"rom\": \"");
+        for (const char *c = results[i].rom; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                fputc('\\', out);
+            }
+            fputc(*c, out);
+        }
+        fprintf(out, "\",\n");
+        fprintf(out, "      \"cpu_cycles\": %llu,\n", (unsigned long long)results[i].cpu_cycles);
+        write_stats(out, "fps", results[i].fps, 0);
+        write_stats(out, "ns_per_cpu_cycle", results[i].ns_per_cycle, 0);
+        write_stats(out, "ns_per_ppu_dot", results[i].ns_per_dot, 1);
+        fprintf(out, "    }%s\n", (i == count - 1) ? "" : ",");
+    }
+    fprintf(out, "  ]\n");
+    fprintf(out, "}\n");
+}
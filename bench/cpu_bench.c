@@ -0,0 +1,270 @@
+//////////////////////////////////////////////////////////////
+// nes-cpu-bench: instruction throughput microbenchmark
+//
+// Runs small hand-assembled 6502 loops from a generated NROM
+// image with rendering and NMI off. Each loop is timed twice:
+// stepping the interpreter alone (cpu_run_cycle, the PPU and
+// master clock stand still) and running the whole console
+// (nes_run_until). Reports million instructions per second
+// (best/median) and ns per instruction.
+//
+// Usage: nes-cpu-bench [options]
+//////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/nes.h"
+
+#define DEFAULT_CYCLES      20000000 // CPU cycles per repetition (~11 emulated seconds)
+#define DEFAULT_REPS        5
+#define RESET_STEPS         16       // instructions run before timing (the reset code)
+
+// iNES image: 16KB PRG ROM (mirrored at 0x8000 and 0xC000) and 8KB CHR ROM
+#define PRG_SIZE            0x4000
+#define CHR_SIZE            0x2000
+#define RESET_ADDR          0xC000
+#define KERNEL_ADDR         0xC010
+#define RTI_ADDR            0xC0F0
+
+typedef struct Kernel {
+    const char *name;
+    const uint8_t *code;
+    int size;
+} Kernel;
+
+// every kernel is assembled at KERNEL_ADDR (0xC010) and loops forever
+
+// loads, transfers and ALU ops that set N and Z
+static const uint8_t kernel_alu[] = {
+    0xA5, 0x10,         // LDA $10
+    0x69, 0x01,         // ADC #$01
+    0xAA,               // TAX
+    0x49, 0x5A,         // EOR #$5A
+    0xA8,               // TAY
+    0x29, 0x3F,         // AND #$3F
+    0x05, 0x11,         // ORA $11
+    0x85, 0x10,         // STA $10
+    0xE8,               // INX
+    0x88,               // DEY
+    0xC9, 0x20,         // CMP #$20
+    0x4A,               // LSR A
+    0xE6, 0x12,         // INC $12
+    0x4C, 0x10, 0xC0,   // JMP $C010
+};
+
+// counted loop with a compare and a taken and a not taken branch per iteration
+static const uint8_t kernel_branch[] = {
+    0xA2, 0x10,         // LDX #$10
+    0xCA,               // DEX          (inner)
+    0xE0, 0x08,         // CPX #$08
+    0xB0, 0x01,         // BCS +1
+    0xEA,               // NOP
+    0xD0, 0xF8,         // BNE inner
+    0x4C, 0x10, 0xC0,   // JMP $C010
+};
+
+// indexed loads and stores over RAM
+static const uint8_t kernel_memory[] = {
+    0xA2, 0x00,         // LDX #$00
+    0xB5, 0x20,         // LDA $20,X    (inner)
+    0x7D, 0x00, 0x03,   // ADC $0300,X
+    0x95, 0x20,         // STA $20,X
+    0x9D, 0x00, 0x04,   // STA $0400,X
+    0xE8,               // INX
+    0xE0, 0x40,         // CPX #$40
+    0xD0, 0xF1,         // BNE inner
+    0x4C, 0x10, 0xC0,   // JMP $C010
+};
+
+static const Kernel kernels[] = {
+    { "alu", kernel_alu, sizeof(kernel_alu) },
+    { "branch", kernel_branch, sizeof(kernel_branch) },
+    { "memory", kernel_memory, sizeof(kernel_memory) },
+};
+
+#define KERNEL_COUNT (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+typedef struct CpuResult {
+    const char *kernel;
+    double cpi;             // CPU cycles per instruction
+    double step_max;        // MIPS stepping the interpreter alone
+    double step_median;
+    double run_max;         // MIPS running the whole console
+    double run_median;
+} CpuResult;
+
+uint64_t cycles_per_rep = DEFAULT_CYCLES;
+int reps = DEFAULT_REPS;
+
+void usage(const char *prog);
+uint64_t now_ns();
+NES *load_kernel(const Kernel *kernel);
+void bench_kernel(const Kernel *kernel, CpuResult *result);
+int compare_double(const void *a, const void *b);
+
+int main(int argc, char *argv[]) {
+    const char *only = NULL;
+
+    // parse cli arguments
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycles_per_rep = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+
+    if (cycles_per_rep == 0 || reps <= 0) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    CpuResult results[KERNEL_COUNT];
+    int count = 0;
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        if (only && strcmp(only, kernels[k].name) != 0) {
+            continue;
+        }
+        bench_kernel(&kernels[k], &results[count++]);
+    }
+
+    if (count == 0) {
+        fprintf(stderr, "Unknown kernel: %s\n", only);
+        exit(1);
+    }
+
+    printf("\n%-10s %6s %11s %11s %11s %11s %11s %11s\n", "kernel", "CPI", "step(max)", "step(med)",
+           "ns/instr", "run(max)", "run(med)", "ns/instr");
+    for (int i = 0; i < count; i++) {
+        printf("%-10s %6.2f %11.1f %11.1f %11.3f %11.1f %11.1f %11.3f\n", results[i].kernel, results[i].cpi,
+               results[i].step_max, results[i].step_median, 1e3 / results[i].step_median,
+               results[i].run_max, results[i].run_median, 1e3 / results[i].run_median);
+    }
+    return 0;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--cycles <n>] [--reps <n>] [--kernel <alu|branch|memory>]\n", prog);
+}
+
+uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// writes an NROM image that turns rendering and NMI off and jumps to the kernel, then loads it
+NES *load_kernel(const Kernel *kernel) {
+    static const uint8_t header[16] = { 'N', 'E', 'S', 0x1A, PRG_SIZE / 0x4000, CHR_SIZE / 0x2000 };
+    static const uint8_t reset[] = {
+        0x78,               // SEI
+        0xD8,               // CLD
+        0xA2, 0xFF,         // LDX #$FF
+        0x9A,               // TXS
+        0xA9, 0x00,         // LDA #$00
+        0x8D, 0x00, 0x20,   // STA $2000
+        0x8D, 0x01, 0x20,   // STA $2001
+        0x4C, 0x10, 0xC0,   // JMP $C010
+    };
+
+    uint8_t *prg = (uint8_t *)calloc(PRG_SIZE + CHR_SIZE, 1);
+    memcpy(prg + (RESET_ADDR & (PRG_SIZE - 1)), reset, sizeof(reset));
+    memcpy(prg + (KERNEL_ADDR & (PRG_SIZE - 1)), kernel->code, kernel->size);
+    prg[RTI_ADDR & (PRG_SIZE - 1)] = 0x40; // RTI
+
+    // NMI, reset and IRQ vectors
+    uint16_t vectors[3] = { RTI_ADDR, RESET_ADDR, RTI_ADDR };
+    for (int i = 0; i < 3; i++) {
+        prg[PRG_SIZE - 6 + i * 2] = vectors[i] & 0xFF;
+        prg[PRG_SIZE - 6 + i * 2 + 1] = vectors[i] >> 8;
+    }
+
+    char path[] = "/tmp/nes-cpu-bench-XXXXXX";
+    int fd = mkstemp(path);
+    FILE *file = fd < 0 ? NULL : fdopen(fd, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to create %s\n", path);
+        exit(1);
+    }
+    fwrite(header, 1, sizeof(header), file);
+    fwrite(prg, 1, PRG_SIZE + CHR_SIZE, file);
+    fclose(file);
+    free(prg);
+
+    NES *nes = nes_init(path, NULL);
+    unlink(path);
+    return nes;
+}
+
+void bench_kernel(const Kernel *kernel, CpuResult *result) {
+    double *step = (double *)malloc(sizeof(double) * reps);
+    double *run = (double *)malloc(sizeof(double) * reps);
+    uint64_t instructions = 0;
+    uint64_t cycles = 0;
+
+    NES *nes = load_kernel(kernel);
+    CPU *cpu = nes->cpu;
+    nes_set_idle_skip(nes, 0); // time every instruction
+    for (int i = 0; i < RESET_STEPS; i++) {
+        nes_cycle(nes);
+    }
+
+    // interpreter only: cpu_run_cycle leaves the master clock alone, so the PPU never catches up
+    for (int r = 0; r < reps; r++) {
+        instructions = 0;
+        cycles = 0;
+        uint64_t start = now_ns();
+        while (cycles < cycles_per_rep) {
+            cpu_run_cycle(cpu);
+            cycles += cpu->cycles;
+            instructions++;
+        }
+        step[r] = (double)instructions * 1e3 / (double)(now_ns() - start);
+    }
+    double cpi = (double)cycles / (double)instructions;
+
+    // whole console, the PPU keeps running with rendering off
+    for (int r = 0; r < reps; r++) {
+        uint64_t target = nes->cycles + cycles_per_rep;
+        uint64_t start_cycles = nes->cycles;
+        uint64_t start = now_ns();
+
+        // nes_run_until also returns at the end of every frame
+        while (nes->cycles < target) {
+            nes_run_until(nes, target);
+        }
+
+        double elapsed = (double)(now_ns() - start);
+        run[r] = (double)(nes->cycles - start_cycles) / cpi * 1e3 / elapsed;
+    }
+
+    nes_free(nes);
+
+    qsort(step, reps, sizeof(double), compare_double);
+    qsort(run, reps, sizeof(double), compare_double);
+    result->kernel = kernel->name;
+    result->cpi = cpi;
+    result->step_max = step[reps - 1];
+    result->step_median = step[reps / 2];
+    result->run_max = run[reps - 1];
+    result->run_median = run[reps / 2];
+
+    free(step);
+    free(run);
+}
+
+int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
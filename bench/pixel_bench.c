@@ -0,0 +1,152 @@
+//////////////////////////////////////////////////////////////
+// nes-pixel-bench: microbenchmark for the frame conversion kernels
+//
+// Converts one indexed frame to packed 32-bit pixels with every
+// kernel the host CPU supports, checks each against the scalar
+// kernel and reports ns per frame and per pixel (min/median).
+// The frame is rendered from a ROM when one is given, otherwise
+// it is filled with pseudo-random color indices.
+//
+// Usage: nes-pixel-bench [options] [<rom.nes>]
+//////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "../include/nes.h"
+#include "../include/pixel.h"
+
+#define DEFAULT_ITERATIONS  2000
+#define DEFAULT_FRAMES      120 // frames run before a ROM frame is sampled
+#define FRAME_PIXELS        (NES_WIDTH * NES_HEIGHT)
+
+int iterations = DEFAULT_ITERATIONS;
+int format = PIXEL_FORMAT_RGBA8888;
+
+void usage(const char *prog);
+uint64_t now_ns();
+void fill_random(uint8_t *frame);
+int compare_u64(const void *a, const void *b);
+
+int main(int argc, char *argv[]) {
+    char *rom = NULL;
+    int frames = DEFAULT_FRAMES;
+    int emphasis = 0;
+
+    // parse cli arguments
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            format = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--emphasis") == 0 && i + 1 < argc) {
+            emphasis = atoi(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            usage(argv[0]);
+            exit(1);
+        } else {
+            rom = argv[i];
+        }
+    }
+
+    if (iterations <= 0 || frames < 0 || format < 0 || format >= PIXEL_FORMAT_COUNT) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    pixel_init();
+    int default_kernel = pixel_get_kernel();
+
+    uint8_t *frame = (uint8_t *)malloc(FRAME_PIXELS);
+    uint32_t *expected = (uint32_t *)malloc(sizeof(uint32_t) * FRAME_PIXELS);
+    uint32_t *pixels = (uint32_t *)malloc(sizeof(uint32_t) * FRAME_PIXELS);
+    uint64_t *times = (uint64_t *)malloc(sizeof(uint64_t) * iterations);
+
+    if (rom) {
+        NES *nes = nes_init(rom, NULL);
+        for (int f = 0; f < frames; f++) {
+            nes_run_frame(nes);
+        }
+        memcpy(frame, nes_get_indexed_framebuffer(nes), FRAME_PIXELS);
+        nes_free(nes);
+    } else {
+        fill_random(frame);
+    }
+
+    const uint32_t *lut = pixel_lut(format, emphasis);
+
+    // reference output
+    pixel_set_kernel(PIXEL_KERNEL_SCALAR);
+    pixel_convert(frame, expected, FRAME_PIXELS, lut);
+
+    printf("\nSource: %s, format %d, emphasis %d, %d iterations\n", rom ? rom : "random indices", format, emphasis, iterations);
+    printf("%-10s %12s %12s %10s %10s  %s\n", "kernel", "ns/frame", "ns(med)", "ns/pixel", "speedup", "check");
+
+    double scalar_ns = 0.0;
+    for (int kernel = 0; kernel < PIXEL_KERNEL_COUNT; kernel++) {
+        if (!pixel_set_kernel(kernel)) {
+            printf("%-10s %12s\n", pixel_kernel_name(kernel), "unsupported");
+            continue;
+        }
+
+        memset(pixels, 0, sizeof(uint32_t) * FRAME_PIXELS);
+        pixel_convert(frame, pixels, FRAME_PIXELS, lut);
+        int match = memcmp(pixels, expected, sizeof(uint32_t) * FRAME_PIXELS) == 0;
+
+        for (int i = 0; i < iterations; i++) {
+            uint64_t start = now_ns();
+            pixel_convert(frame, pixels, FRAME_PIXELS, lut);
+            times[i] = now_ns() - start;
+        }
+        qsort(times, iterations, sizeof(uint64_t), compare_u64);
+
+        double min_ns = (double)times[0];
+        double median_ns = (double)times[iterations / 2];
+        if (kernel == PIXEL_KERNEL_SCALAR) {
+            scalar_ns = min_ns;
+        }
+
+        printf("%-10s %12.0f %12.0f %10.3f %9.2fx  %s%s\n", pixel_kernel_name(kernel), min_ns, median_ns,
+               min_ns / FRAME_PIXELS, scalar_ns / min_ns, match ? "ok" : "MISMATCH",
+               kernel == default_kernel ? " (default)" : "");
+    }
+
+    free(frame);
+    free(expected);
+    free(pixels);
+    free(times);
+    return 0;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--iterations <n>] [--frames <n>] [--format <0-%d>] [--emphasis <0-7>] [<rom.nes>]\n",
+            prog, PIXEL_FORMAT_COUNT - 1);
+}
+
+uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void fill_random(uint8_t *frame) {
+    // fixed xorshift seed so runs are comparable
+    uint32_t state = 0x12345678;
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        frame[i] = state & (PIXEL_GREYSCALE | PIXEL_COLOR_MASK);
+    }
+}
+
+int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
@@ -2,12 +2,35 @@
 #define APU_H
 
 #include <stdint.h>
+#include <stdatomic.h>
 
-#define APU_SAMPLE_RATE 88000
-#define CPU_CLOCK 1789773
+typedef struct NES NES;
 
-typedef struct MEM MEM;
-typedef struct PPU PPU;
+#define AUDIO_SAMPLE_RATE 44100 // rate of the samples apu_catch_up queues
+#define CPU_CLOCK 1789773
+#define APU_RING_SIZE 4096 // queued samples (power of 2, ~93ms)
+#define DMC_FETCH_STALL 4 // CPU cycles a DMC sample fetch halts the CPU for
+
+// Band-limited synthesis (see apu_add_delta)
+#define BLIP_TAPS   16      // output samples a single output change is spread over (power of 2)
+#define BLIP_PHASES 32      // sub-sample positions the step kernel is tabulated for
+#define BLIP_SHIFT  14      // kernel taps of one phase add up to 1 << BLIP_SHIFT
+
+// Mixer (see apu_init_mixer)
+#define APU_MIX_SCALE       30000   // sample value of a mixer output of 1.0 (all channels at full level)
+#define APU_PULSE_LEVELS    31      // pulse1 + pulse2 (0-30)
+#define APU_TND_LEVELS      203     // 3 * triangle + 2 * noise + DMC (0-202)
+#define APU_HIGHPASS        32351   // pole of the DC blocking filter, ~90Hz at 44.1kHz (1.15 fixed point)
+
+// Single producer / single consumer queue of output samples. The emulation thread pushes
+// (apu_catch_up) and the audio thread pops (apu_read_samples) without locks: each side only
+// stores its own position, and reads the other one with acquire ordering
+typedef struct SampleRing {
+    int16_t samples[APU_RING_SIZE];
+    _Atomic uint32_t write; // samples pushed so far (wraps)
+    _Atomic uint32_t read;  // samples popped so far (wraps)
+    int16_t last;           // last sample popped, repeated when the queue runs dry (audio thread only)
+} SampleRing;
 
 typedef struct PulseChannel {
     // 0x4000 | 0x4004
@@ -27,7 +50,8 @@ typedef struct PulseChannel {
     uint8_t length; // duration timer
 
     // state variables
-    uint16_t timer_counter;
+    uint64_t next_clock;     // CPU cycle the timer next expires at
+    int quiet;               // 1 while timer expiries cannot change the output (see apu_catch_up)
     uint8_t seq_pos;         
     uint8_t envelope_divider;
     uint8_t envelope_counter;
@@ -36,7 +60,7 @@ typedef struct PulseChannel {
     uint8_t sweep_reload;
     uint8_t sweep_mute;
     uint8_t length_counter;
-    int16_t output; // holds the most recent output value for audio_callback
+    uint8_t output; // current level (0-15) fed to the mixer
 } PulseChannel;
 
 typedef struct TriangleChannel {
@@ -49,12 +73,13 @@ typedef struct TriangleChannel {
     uint8_t length; // duration timer
 
     // state variables
-    uint16_t timer_counter;
+    uint64_t next_clock;    // CPU cycle the timer next expires at
+    int quiet;              // 1 while timer expiries cannot change the output (see apu_catch_up)
     uint8_t seq_pos;        
     uint8_t linear_counter;
     uint8_t linear_reload;
     uint8_t length_counter;
-    int16_t output; // holds the most recent output value for audio_callback
+    uint8_t output; // current level (0-15) fed to the mixer
 } TriangleChannel;
 
 typedef struct NoiseChannel {
@@ -65,24 +90,47 @@ typedef struct NoiseChannel {
 
     // 0x400E
     int mode; // LFSR mode
-    uint16_t period; // frequency timer
+    uint16_t period; // frequency timer (CPU cycles, from noise_length)
 
     // 0x400F
     uint8_t length; // duration timer
 
     // state variables
-    uint16_t timer_counter;
+    uint64_t next_clock; // CPU cycle the timer next expires at
+    int quiet;           // 1 while timer expiries cannot change the output (see apu_catch_up)
     uint16_t lfsr; // shift register
     uint8_t envelope_divider;
     uint8_t envelope_counter;
     uint8_t envelope_start;
     uint8_t length_counter;
-    int16_t output; // holds the most recent output value for audio_callback
+    uint8_t output; // current level (0-15) fed to the mixer
 } NoiseChannel;
 
-typedef struct APU {
-    SDL_AudioDeviceID audio_dev;
+typedef struct DMCChannel {
+    // 0x4010
+    int irq_en;
+    int loop;
+    uint16_t rate; // timer period (CPU cycles)
 
+    // 0x4012 & 0x4013
+    uint16_t sample_addr;
+    uint16_t sample_length;
+
+    // state variables
+    uint64_t next_clock;     // CPU cycle the timer next expires at
+    int quiet;               // 1 while timer expiries cannot change the output (see apu_catch_up)
+    uint16_t address;        // address of the next sample byte
+    uint16_t bytes_remaining;
+    uint8_t buffer;          // sample byte waiting for the output unit
+    uint8_t buffer_full;
+    uint8_t shift;           // bits of the byte being played
+    uint8_t bits_remaining;
+    uint8_t silence;
+    uint8_t irq_flag;        // status bit 7 of 0x4015, held until 0x4015 is written or 0x4010 disables the IRQ
+    uint8_t output; // current level (0-127) fed to the mixer, also loaded by 0x4011
+} DMCChannel;
+
+typedef struct APU {
     // 0x4015
     int DMC_en;
     int noise_en;
@@ -91,20 +139,45 @@ typedef struct APU {
     int pulse2_en;
 
     // 0x4017
-    int mode;
+    int mode; // 0: 4-step sequence, 1: 5-step sequence
     int IRQ_inhibit;
-
-    int frame_counter; 
+    int frame_irq; // frame interrupt flag, status bit 6 of 0x4015
+
+    // events, as CPU cycles (APU cycles are the even ones)
+    uint64_t cycles;        // CPU cycle the APU has been clocked up to (see apu_catch_up)
+    uint64_t frame_start;   // CPU cycle the current frame sequence started at
+    int frame_step;         // next step of the frame sequence (see frame_steps)
+    uint64_t update_cycle;  // APU cycle after the last register write (UINT64_MAX: none)
+    int irq;                // IRQ line to the CPU, held while frame_irq or the DMC's irq_flag is set
+    SampleRing ring;
+
+    // nonlinear mixer, in sample units
+    int16_t pulse_table[APU_PULSE_LEVELS];
+    int16_t tnd_table[APU_TND_LEVELS];
+    int32_t highpass_in;    // last sample into the DC blocking filter
+    int32_t highpass_out;   // last sample out of it
+
+    // band-limited synthesis: output changes are added as steps into the next BLIP_TAPS samples
+    int32_t blip_level;                             // mixed output the last delta was taken from
+    int64_t blip_sum;                               // running sum of finished samples' deltas
+    int64_t blip_pending[BLIP_TAPS];                // deltas of the next samples (circular)
+    uint64_t blip_pos;                              // index of the next sample to finish
+    int16_t blip_kernel[BLIP_PHASES][BLIP_TAPS];    // band-limited step (as per-sample deltas) by phase
 
     PulseChannel pulse1;
     PulseChannel pulse2;
     TriangleChannel triangle;
     NoiseChannel noise;
+    DMCChannel dmc;
+
+    NES *nes; // console this APU belongs to (DMC sample fetches)
 } APU;
 
-APU *apu_init();
+APU *apu_init(NES *nes);
 void apu_free(APU *apu);
-void apu_run_cycle(APU *apu);
+void apu_catch_up(APU *apu, uint64_t cycle);
+uint64_t apu_next_event(APU *apu);
+int apu_read_samples(APU *apu, int16_t *buffer, int samples);
 uint8_t apu_register_read(APU *apu, uint16_t reg);
 void apu_register_write(APU *apu, uint16_t reg, uint8_t value);
 
@@ -0,0 +1,17 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <SDL.h>
+#include "nes.h"
+
+// SDL audio output for the frontend. The device callback only drains the
+// samples the emulation core queued, with nes_read_audio().
+typedef struct AUDIO {
+    SDL_AudioDeviceID audio_dev;
+    NES *nes; // console the samples are pulled from
+} AUDIO;
+
+AUDIO *audio_init(NES *nes);
+void audio_free(AUDIO *audio);
+
+#endif
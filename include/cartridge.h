@@ -3,22 +3,37 @@
 
 #include <stdint.h> 
 
+// PRG ROM byte decoded as the first byte of an instruction (see cart_decode_prg)
+typedef struct DecodedOp {
+    uint8_t opcode;
+    uint8_t length;     // bytes the instruction takes (0: operand runs into the next 1KB page, not cached)
+    uint16_t operand;   // operand bytes (little endian)
+} DecodedOp;
+
 typedef struct Cartridge {
     char *rom_filename;  // ROM file path
     char *save_filename; // save file path (can be NULL)
     // Cartridge memory (dynamically allocated because sizes vary)
     uint8_t *prg_rom;
     uint8_t *chr_rom;  // could be ROM or RAM
+    uint16_t *chr_tiles; // chr_rom pre-decoded, one entry per tile row: 8 pixels of 2 bits, leftmost pixel in the top bits
+    DecodedOp *prg_ops; // prg_rom pre-decoded, one entry per byte
     uint8_t *prg_ram; // battery-backed RAM (if any)
+    int *rom_refs;    // number of cartridges sharing prg_rom/prg_ops (and chr_rom/chr_tiles when it is ROM)
     int prg_size;
     int chr_size;
     int prg_ram_size;
     int mapper_id;
     int mirroring; // initial mirroring mode set in header (can be changed by mapper)
     int battery;
+    int chr_ram; // 1 if chr_rom is CHR RAM (owned by each cartridge, never shared)
 } Cartridge;
 
 Cartridge *cart_init(const char *rom_filename, const char *save_filename);
+Cartridge *cart_share(const Cartridge *src);
 void cart_free(Cartridge *cart);
+void cart_decode_prg(Cartridge *cart);
+void cart_decode_chr(Cartridge *cart);
+void cart_chr_write(Cartridge *cart, uint32_t addr, uint8_t value);
 
 #endif
\ No newline at end of file
@@ -4,8 +4,7 @@
 #include <stdint.h>
 #include <stddef.h>
 
-typedef struct MEM MEM;
-typedef struct PPU PPU;
+typedef struct NES NES;
 
 // NES STACK starts at 0x01FF and grows down to 0x0100
 #define STACK_BASE 0x0100
@@ -20,23 +19,50 @@ typedef struct PPU PPU;
 #define FLAG_OVERFLOW       0x40 // Bit 7 (V)
 #define FLAG_NEGATIVE       0x80 // Bit 8 (N)
 
+// N and Z are kept as the last result instead of in P (see update_zero_and_negative_flags).
+// Z is set when its low byte is 0, N when bit 7 of either byte is set (the high byte lets
+// BIT and PLP set N and Z independently)
+#define NZ_ZERO(nz)         (((nz) & 0xFF) == 0)
+#define NZ_NEGATIVE(nz)     (((nz) & 0x8080) != 0)
+
+// Idle loops (see cpu_idle_check)
+#define IDLE_LOOP_MAX_BYTES 16 // longest loop body (head to closing branch) that is analyzed
+#define IDLE_LOOP_NONE      0  // writes, has side effects or reads I/O
+#define IDLE_LOOP_MEMORY    1  // only reads memory that nothing but the CPU changes
+#define IDLE_LOOP_STATUS    2  // also polls PPUSTATUS (once per iteration)
+
 typedef struct CPU {
     uint8_t A;          // Accumulator
     uint8_t X;          // X Register
     uint8_t Y;          // Y Register
     uint16_t PC;        // Program Counter
     uint8_t S;          // Stack Pointer
-    uint8_t P;          // Status Register
+    uint8_t P;          // Status Register (N and Z are in nz, use cpu_get_status for all of it)
+    uint16_t nz;        // result the N and Z flags are evaluated from (see NZ_ZERO / NZ_NEGATIVE)
     int cycles;         // Cycle counter --> important to synchronize with PPU and APU
     int page_crossed;   // 1 if page was crossed during instruction
     int service_int;    // if 1, then an interrupt is being serviced
+
+    // idle loop detection
+    int idle_skip;          // 1 while cpu_run runs freely and idle loops may be fast-forwarded
+    int idle_head;          // address the last backward branch or jump went to (-1: none)
+    uint16_t idle_tail;     // address of that branch or jump
+    int idle_kind;          // IDLE_LOOP_* of the loop between them
+    uint64_t idle_cycles;   // nes->cycles when the loop was last closed
+    uint8_t idle_state[5];  // A, X, Y, P, S when the loop was last closed
+
+    NES *nes;           // console this CPU belongs to (bus access)
 } CPU;
 
-CPU *cpu_init();
+CPU *cpu_init(NES *nes);
 void cpu_free(CPU *cpu);
 void cpu_run_cycle(CPU *cpu);
+int cpu_run(CPU *cpu, uint64_t deadline);
 void cpu_irq(CPU *cpu);
 void cpu_nmi(CPU *cpu);
+void cpu_idle_check(CPU *cpu, uint16_t head, uint16_t tail);
+uint8_t cpu_get_status(CPU *cpu);
+void cpu_set_status(CPU *cpu, uint8_t status);
 void stack_push(CPU *cpu, uint8_t value);
 uint8_t stack_pop(CPU *cpu);
 
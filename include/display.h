@@ -5,6 +5,7 @@
 #include <SDL_ttf.h>
 #include "ppu.h"
 #include "cpu.h"
+#include "nes.h"
 
 #define SCALE_FACTOR 2.8
 
@@ -35,11 +36,19 @@ typedef struct DISPLAY {
     SDL_Renderer *renderer;
     SDL_Texture *game_texture;
     TTF_Font *font;
+    SDL_Texture *nt_texture; // nametable viewer (debug display)
+    SDL_Texture *pt_texture; // pattern table viewer (debug display)
+    int nt_frame_counter; // nametables are only redrawn every few frames
     int debug_enable; // shows pattern tables, name tables and CPU/PPU info when enabled
+
+    // FPS tracking
+    int frames; // frames presented since last FPS update
+    int FPS;
+    uint32_t last_time;
 } DISPLAY;
 
 DISPLAY *window_init(int debug_enable);
 void free_display(DISPLAY *display);
-void render_display(DISPLAY *display);
+void render_display(DISPLAY *display, NES *nes);
 
 #endif
\ No newline at end of file
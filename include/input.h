@@ -1,7 +1,6 @@
 #ifndef CNTRL_H
 #define CNTRL_H
 
-#include <SDL.h>
 #include <stdint.h>
 
 // Memory-Mapped register locations
@@ -25,8 +24,6 @@ typedef struct CNTRL {
 
 CNTRL *cntrl_init();
 void cntrl_free(CNTRL *cntrl);
-void cntrl1_handle_input(CNTRL *cntrl, SDL_Event *event);
-void cntrl2_handle_input(CNTRL *cntrl, SDL_Event *event);
 uint8_t cntrl_read(CNTRL *cntrl);
 void cntrl_write(CNTRL *cntrl, uint8_t value);
 
@@ -0,0 +1,13 @@
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#include <SDL.h>
+#include <stdint.h>
+
+// Keyboard -> controller button mapping used by the SDL frontend.
+// Each function updates a button state byte (NES_BUTTON_* bits) that is
+// then handed to the emulation core with nes_set_controller().
+void keyboard1_handle_input(uint8_t *button_state, SDL_Event *event);
+void keyboard2_handle_input(uint8_t *button_state, SDL_Event *event);
+
+#endif
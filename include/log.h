@@ -27,6 +27,16 @@ extern int debug_enable;
     } while (0)
 
 // Debugging Macros
+// Release builds (make release) compile every trace site out, including the debug_enable test
+#ifdef NES_RELEASE
+
+#define DEBUG_MSG_CPU(msg, ...) do { } while (0)
+#define DEBUG_MSG_PPU(msg, ...) do { } while (0)
+#define DEBUG_MSG_MEM(msg, ...) do { } while (0)
+#define DEBUG_MSG_CNTRL(msg, ...) do { } while (0)
+
+#else
+
 #define DEBUG_MSG_CPU(msg, ...) \
     if (debug_enable) { \
         fprintf(stdout, COLOR_BLUE "[CPU] " msg COLOR_RESET "\n", ##__VA_ARGS__); \
@@ -48,3 +58,5 @@ extern int debug_enable;
     }
 
 #endif
+
+#endif
@@ -10,6 +10,17 @@
 #define MIRROR_SINGLE_LOWER 2
 #define MIRROR_SINGLE_UPPER 3
 
+// CPU memory map: the 64KB CPU address space split into 1KB pages
+#define CPU_PAGE_SHIFT  10
+#define CPU_PAGE_SIZE   0x400
+#define CPU_PAGE_COUNT  64
+
+// PPU memory map: eight 1KB pattern table pages (0x0000-0x1FFF) and four 1KB nametables (0x2000-0x2FFF)
+#define PPU_PAGE_SHIFT  10
+#define PPU_PAGE_SIZE   0x400
+#define CHR_PAGE_COUNT  8
+#define NAMETABLE_COUNT 4
+
 typedef struct Mapper {
     // reference to the cartridge this mapper is associated with
     Cartridge *cart;
@@ -18,15 +29,26 @@ typedef struct Mapper {
     uint8_t (*cpu_read)(struct Mapper *m, uint16_t addr);
     void    (*cpu_write)(struct Mapper *m, uint16_t addr, uint8_t value);
 
-    uint8_t (*ppu_read)(struct Mapper *m, uint16_t addr);
-    void    (*ppu_write)(struct Mapper *m, uint16_t addr, uint8_t value);
-
     // pointer to mapper register struct (each mapper uses its own set of registers)
     void *regs;
 
-    // current mirroring mode and function (can be changed by mapper)
+    // current mirroring mode (changed by the mapper through mapper_set_mirroring)
     int mirroring; 
-    uint16_t (*mirror_nametable)(struct Mapper *m, uint16_t address); // mapper specific nametable mirroring function
+    uint8_t *vram; // console nametable RAM (2KB) the nametable pages point into
+
+    // direct read/write pointers for each 1KB CPU page, published by the mapper for PRG RAM/ROM
+    // (and by the console for internal RAM). NULL pages go through nes_cpu_read_slow/nes_cpu_write_slow,
+    // which handle I/O registers and call cpu_read/cpu_write (mapper registers, disabled PRG RAM)
+    uint8_t *cpu_read_map[CPU_PAGE_COUNT];
+    uint8_t *cpu_write_map[CPU_PAGE_COUNT];
+    DecodedOp *cpu_decode_map[CPU_PAGE_COUNT]; // same pages in the decoded instruction cache (cart->prg_ops), PRG ROM only
+
+    // direct pointers for each 1KB pattern table page and each nametable, republished by the mapper on
+    // bank and mirroring writes. CHR pages are never NULL for reads, a NULL write page ignores the write (CHR ROM)
+    uint8_t *chr_read_map[CHR_PAGE_COUNT];
+    uint8_t *chr_write_map[CHR_PAGE_COUNT];
+    uint16_t *chr_tile_map[CHR_PAGE_COUNT]; // same pages in the decoded tile row cache (cart->chr_tiles)
+    uint8_t *nametable_map[NAMETABLE_COUNT];
 
     // IRQ flag (set by mapper, checked and cleared by CPU)
     int irq;
@@ -34,7 +56,13 @@ typedef struct Mapper {
 
 } Mapper;
 
-Mapper *mapper_init(Cartridge *cart);
+Mapper *mapper_init(Cartridge *cart, uint8_t *vram);
 void mapper_free(Mapper *mapper);
+void mapper_map_cpu(Mapper *m, uint16_t addr, uint32_t size, uint8_t *read, uint8_t *write);
+void mapper_map_prg_rom(Mapper *m, uint16_t addr, uint32_t size, uint32_t prg_offset);
+void mapper_map_prg_ram(Mapper *m, int readable, int writable);
+void mapper_map_chr(Mapper *m, uint16_t addr, uint32_t size, uint32_t chr_offset, int writable);
+void mapper_set_mirroring(Mapper *m, int mirroring);
+void mapper_chr_write(Mapper *m, uint16_t addr, uint8_t value);
 
 #endif
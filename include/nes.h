@@ -1,6 +1,11 @@
 //////////////////////////////////////////////////////////////
 // This file contains NES-specific definitions and constants
 // It also implements the NES bus and memory map
+//
+// It is the public interface of the emulation core library
+// (libnescore), which has no SDL dependency. Frontends load a
+// ROM with nes_init, step it with nes_run_frame / nes_cycle and
+// read back the framebuffer and audio samples.
 //////////////////////////////////////////////////////////////
 
 #ifndef NES_H
@@ -12,9 +17,6 @@
 #include "input.h"
 #include "mapper.h"
 #include "cartridge.h"
-#include "display.h"
-#include <SDL.h>
-#include <SDL_ttf.h>
 
 #define NES_CPU_CLOCK 1789773 // 1.789773 MHz
 #define CYCLES_PER_FRAME (NES_CPU_CLOCK / 60) // ~29829.55 cycles per 1/60th second
@@ -70,17 +72,112 @@ typedef struct NES {
     uint8_t ram[RAM_SIZE];      // 2KB CPU RAM
     uint8_t vram[VRAM_SIZE];    // 2KB PPU VRAM 
 
-    DISPLAY *display;
+    uint64_t cycles;            // total CPU cycles executed since power on (including DMA stalls)
+    uint64_t next_event;        // cycles value at which the run loop leaves its fast path (see nes_schedule)
+    uint64_t deadline;          // cycles value the current run stops at (UINT64_MAX between runs)
+
+    uint32_t *rgba_frame;       // nes_get_framebuffer conversion of the indexed PPU framebuffer (allocated on first use)
+    uint64_t rgba_frame_cycles; // value of cycles when rgba_frame was last converted
+
+    int idle_skip;              // 1 (default): fast-forward idle loops while running freely (see nes_idle_skip)
+
+    uint16_t breakpoint;        // nes_run_until stops when PC reaches this address
+    int breakpoint_set;
+    int at_breakpoint;          // set while stopped at the breakpoint so the next run can step past it
 } NES;
 
-void nes_init(char *rom_filename, char *save_filename, int display_flag);
-void nes_free();
-int nes_cycle(uint32_t *last_time, int debug_enable);
-uint8_t nes_cpu_read(uint16_t address);
-void nes_cpu_write(uint16_t address, uint8_t value);
-uint8_t nes_ppu_read(uint16_t address);
-void nes_ppu_write(uint16_t address, uint8_t value);
+// reasons for nes_run_until / nes_run_frame to return
+#define NES_RUN_FRAME       0 // the PPU completed a frame
+#define NES_RUN_DEADLINE    1 // the requested cycle was reached
+#define NES_RUN_BREAKPOINT  2 // PC reached the breakpoint (the instruction there has not run yet)
+
+// ==================== Core API ====================
+
+NES *nes_init(char *rom_filename, char *save_filename);
+NES *nes_init_shared(NES *source); // new console running the same cartridge, sharing its ROM data
+void nes_free(NES *nes);
+int nes_cycle(NES *nes); // runs one CPU instruction, returns 1 if a frame was completed
+int nes_run_until(NES *nes, uint64_t cycle); // runs until a frame completes, nes->cycles reaches cycle or a breakpoint hits
+int nes_run_frame(NES *nes); // runs until a frame completes or a breakpoint hits
+void nes_set_dot_accurate(NES *nes, int enable); // 1: step the PPU dot by dot, 0 (default): batch whole lines
+void nes_set_idle_skip(NES *nes, int enable); // 1 (default): fast-forward idle loops, 0: run every iteration
+void nes_set_breakpoint(NES *nes, uint16_t address);
+void nes_clear_breakpoint(NES *nes);
+const uint32_t *nes_get_framebuffer(NES *nes); // NES_WIDTH * NES_HEIGHT pixels (RGBA8888), converted on request
+const uint8_t *nes_get_indexed_framebuffer(NES *nes); // NES_WIDTH * NES_HEIGHT PPU pixels (PIXEL_COLOR_MASK / PIXEL_GREYSCALE bits)
+void nes_convert_framebuffer(NES *nes, uint32_t *dst, int format); // NES_WIDTH * NES_HEIGHT pixels in PIXEL_FORMAT_*
+int nes_read_audio(NES *nes, int16_t *buffer, int samples); // pops mono 16-bit samples at AUDIO_SAMPLE_RATE queued by the run calls (safe from an audio thread), returns how many were queued
+void nes_set_controller(NES *nes, int port, uint8_t button_state); // port 0 or 1, NES_BUTTON_* bits
+
+// ==================== Bus ====================
+
+uint8_t nes_cpu_read_slow(NES *nes, uint16_t address);
+void nes_cpu_write_slow(NES *nes, uint16_t address, uint8_t value);
+int nes_run_events(NES *nes); // catches the PPU up and reschedules, returns 1 if a frame was completed
+void nes_schedule(NES *nes);
+void nes_idle_skip(NES *nes, uint64_t iteration, int reads_status);
+
+// advances the master clock by cycles CPU cycles, the PPU only catches up once an event is due
+// returns 1 if a frame was completed
+static inline int nes_tick(NES *nes, int cycles) {
+    nes->cycles += cycles;
+    if (nes->cycles < nes->next_event) {
+        return 0;
+    }
+    return nes_run_events(nes);
+}
+
+// CPU accesses use the mapper's 1KB page map, only unmapped pages (I/O registers,
+// mapper registers, disabled PRG RAM) go through the slow path
+static inline uint8_t nes_cpu_read(NES *nes, uint16_t address) {
+    uint8_t *page = nes->mapper->cpu_read_map[address >> CPU_PAGE_SHIFT];
+    if (page) {
+        return page[address & (CPU_PAGE_SIZE - 1)];
+    }
+    return nes_cpu_read_slow(nes, address);
+}
+
+static inline void nes_cpu_write(NES *nes, uint16_t address, uint8_t value) {
+    uint8_t *page = nes->mapper->cpu_write_map[address >> CPU_PAGE_SHIFT];
+    if (page) {
+        page[address & (CPU_PAGE_SIZE - 1)] = value;
+        return;
+    }
+    nes_cpu_write_slow(nes, address, value);
+}
+
+// PPU accesses use the mapper's pattern table and nametable pages
+static inline uint8_t nes_ppu_read(NES *nes, uint16_t address) {
+    // pattern tables
+    if (address < 0x2000) {
+        return nes->mapper->chr_read_map[address >> PPU_PAGE_SHIFT][address & (PPU_PAGE_SIZE - 1)];
+    }
+    // nametables and mirrors (0x3000-0x3EFF mirrors 0x2000-0x2EFF)
+    else if (address < 0x3F00) {
+        return nes->mapper->nametable_map[(address >> PPU_PAGE_SHIFT) & 0x03][address & (PPU_PAGE_SIZE - 1)];
+    }
+    return 0; // palette RAM is handled internally by the PPU
+}
+
+#define TILE_ROW_PLANE0 0x5555 // bits of a decoded tile row that come from bitplane 0
+#define TILE_ROW_PLANE1 0xAAAA // bits of a decoded tile row that come from bitplane 1
+
+// decoded pattern row (8 pixels of 2 bits, leftmost pixel in the top bits) for the tile row at
+// pattern table address (the plane select bit 3 is ignored)
+static inline uint16_t nes_ppu_read_tile_row(NES *nes, uint16_t address) {
+    uint16_t *page = nes->mapper->chr_tile_map[(address >> PPU_PAGE_SHIFT) & (CHR_PAGE_COUNT - 1)];
+    return page[((address >> 1) & 0x1F8) | (address & 0x07)];
+}
 
-extern NES *nes; // global NES instance for simplicity
+static inline void nes_ppu_write(NES *nes, uint16_t address, uint8_t value) {
+    // pattern tables (writes to CHR ROM are ignored)
+    if (address < 0x2000) {
+        mapper_chr_write(nes->mapper, address, value);
+    }
+    // nametables and mirrors
+    else if (address < 0x3F00) {
+        nes->mapper->nametable_map[(address >> PPU_PAGE_SHIFT) & 0x03][address & (PPU_PAGE_SIZE - 1)] = value;
+    }
+}
 
 #endif
\ No newline at end of file
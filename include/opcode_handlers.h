@@ -1,263 +0,0 @@
-#include <stdint.h>
-
-typedef struct CPU CPU;
-typedef struct PPU PPU;
-
-typedef void (*InstructionHandler)(CPU *cpu, uint8_t opcode); // Jump table for opcodes
-
-void handle_0x00(CPU *cpu, uint8_t opcode);
-void handle_0x01(CPU *cpu, uint8_t opcode);
-void handle_0x02(CPU *cpu, uint8_t opcode);
-void handle_0x03(CPU *cpu, uint8_t opcode);
-void handle_0x04(CPU *cpu, uint8_t opcode);
-void handle_0x05(CPU *cpu, uint8_t opcode);
-void handle_0x06(CPU *cpu, uint8_t opcode);
-void handle_0x07(CPU *cpu, uint8_t opcode);
-void handle_0x08(CPU *cpu, uint8_t opcode);
-void handle_0x09(CPU *cpu, uint8_t opcode);
-void handle_0x0A(CPU *cpu, uint8_t opcode);
-void handle_0x0B(CPU *cpu, uint8_t opcode);
-void handle_0x0C(CPU *cpu, uint8_t opcode);
-void handle_0x0D(CPU *cpu, uint8_t opcode);
-void handle_0x0E(CPU *cpu, uint8_t opcode);
-void handle_0x0F(CPU *cpu, uint8_t opcode);
-void handle_0x10(CPU *cpu, uint8_t opcode);
-void handle_0x11(CPU *cpu, uint8_t opcode);
-void handle_0x12(CPU *cpu, uint8_t opcode);
-void handle_0x13(CPU *cpu, uint8_t opcode);
-void handle_0x14(CPU *cpu, uint8_t opcode);
-void handle_0x15(CPU *cpu, uint8_t opcode);
-void handle_0x16(CPU *cpu, uint8_t opcode);
-void handle_0x17(CPU *cpu, uint8_t opcode);
-void handle_0x18(CPU *cpu, uint8_t opcode);
-void handle_0x19(CPU *cpu, uint8_t opcode);
-void handle_0x1A(CPU *cpu, uint8_t opcode);
-void handle_0x1B(CPU *cpu, uint8_t opcode);
-void handle_0x1C(CPU *cpu, uint8_t opcode);
-void handle_0x1D(CPU *cpu, uint8_t opcode);
-void handle_0x1E(CPU *cpu, uint8_t opcode);
-void handle_0x1F(CPU *cpu, uint8_t opcode);
-void handle_0x20(CPU *cpu, uint8_t opcode);
-void handle_0x21(CPU *cpu, uint8_t opcode);
-void handle_0x22(CPU *cpu, uint8_t opcode);
-void handle_0x23(CPU *cpu, uint8_t opcode);
-void handle_0x24(CPU *cpu, uint8_t opcode);
-void handle_0x25(CPU *cpu, uint8_t opcode);
-void handle_0x26(CPU *cpu, uint8_t opcode);
-void handle_0x27(CPU *cpu, uint8_t opcode);
-void handle_0x28(CPU *cpu, uint8_t opcode);
-void handle_0x29(CPU *cpu, uint8_t opcode);
-void handle_0x2A(CPU *cpu, uint8_t opcode);
-void handle_0x2B(CPU *cpu, uint8_t opcode);
-void handle_0x2C(CPU *cpu, uint8_t opcode);
-void handle_0x2D(CPU *cpu, uint8_t opcode);
-void handle_0x2E(CPU *cpu, uint8_t opcode);
-void handle_0x2F(CPU *cpu, uint8_t opcode);
-void handle_0x30(CPU *cpu, uint8_t opcode);
-void handle_0x31(CPU *cpu, uint8_t opcode);
-void handle_0x32(CPU *cpu, uint8_t opcode);
-void handle_0x33(CPU *cpu, uint8_t opcode);
-void handle_0x34(CPU *cpu, uint8_t opcode);
-void handle_0x35(CPU *cpu, uint8_t opcode);
-void handle_0x36(CPU *cpu, uint8_t opcode);
-void handle_0x37(CPU *cpu, uint8_t opcode);
-void handle_0x38(CPU *cpu, uint8_t opcode);
-void handle_0x39(CPU *cpu, uint8_t opcode);
-void handle_0x3A(CPU *cpu, uint8_t opcode);
-void handle_0x3B(CPU *cpu, uint8_t opcode);
-void handle_0x3C(CPU *cpu, uint8_t opcode);
-void handle_0x3D(CPU *cpu, uint8_t opcode);
-void handle_0x3E(CPU *cpu, uint8_t opcode);
-void handle_0x3F(CPU *cpu, uint8_t opcode);
-void handle_0x40(CPU *cpu, uint8_t opcode);
-void handle_0x41(CPU *cpu, uint8_t opcode);
-void handle_0x42(CPU *cpu, uint8_t opcode);
-void handle_0x43(CPU *cpu, uint8_t opcode);
-void handle_0x44(CPU *cpu, uint8_t opcode);
-void handle_0x45(CPU *cpu, uint8_t opcode);
-void handle_0x46(CPU *cpu, uint8_t opcode);
-void handle_0x47(CPU *cpu, uint8_t opcode);
-void handle_0x48(CPU *cpu, uint8_t opcode);
-void handle_0x49(CPU *cpu, uint8_t opcode);
-void handle_0x4A(CPU *cpu, uint8_t opcode);
-void handle_0x4B(CPU *cpu, uint8_t opcode);
-void handle_0x4C(CPU *cpu, uint8_t opcode);
-void handle_0x4D(CPU *cpu, uint8_t opcode);
-void handle_0x4E(CPU *cpu, uint8_t opcode);
-void handle_0x4F(CPU *cpu, uint8_t opcode);
-void handle_0x50(CPU *cpu, uint8_t opcode);
-void handle_0x51(CPU *cpu, uint8_t opcode);
-void handle_0x52(CPU *cpu, uint8_t opcode);
-void handle_0x53(CPU *cpu, uint8_t opcode);
-void handle_0x54(CPU *cpu, uint8_t opcode);
-void handle_0x55(CPU *cpu, uint8_t opcode);
-void handle_0x56(CPU *cpu, uint8_t opcode);
-void handle_0x57(CPU *cpu, uint8_t opcode);
-void handle_0x58(CPU *cpu, uint8_t opcode);
-void handle_0x59(CPU *cpu, uint8_t opcode);
-void handle_0x5A(CPU *cpu, uint8_t opcode);
-void handle_0x5B(CPU *cpu, uint8_t opcode);
-void handle_0x5C(CPU *cpu, uint8_t opcode);
-void handle_0x5D(CPU *cpu, uint8_t opcode);
-void handle_0x5E(CPU *cpu, uint8_t opcode);
-void handle_0x5F(CPU *cpu, uint8_t opcode);
-void handle_0x60(CPU *cpu, uint8_t opcode);
-void handle_0x61(CPU *cpu, uint8_t opcode);
-void handle_0x62(CPU *cpu, uint8_t opcode);
-void handle_0x63(CPU *cpu, uint8_t opcode);
-void handle_0x64(CPU *cpu, uint8_t opcode);
-void handle_0x65(CPU *cpu, uint8_t opcode);
-void handle_0x66(CPU *cpu, uint8_t opcode);
-void handle_0x67(CPU *cpu, uint8_t opcode);
-void handle_0x68(CPU *cpu, uint8_t opcode);
-void handle_0x69(CPU *cpu, uint8_t opcode);
-void handle_0x6A(CPU *cpu, uint8_t opcode);
-void handle_0x6B(CPU *cpu, uint8_t opcode);
-void handle_0x6C(CPU *cpu, uint8_t opcode);
-void handle_0x6D(CPU *cpu, uint8_t opcode);
-void handle_0x6E(CPU *cpu, uint8_t opcode);
-void handle_0x6F(CPU *cpu, uint8_t opcode);
-void handle_0x70(CPU *cpu, uint8_t opcode);
-void handle_0x71(CPU *cpu, uint8_t opcode);
-void handle_0x72(CPU *cpu, uint8_t opcode);
-void handle_0x73(CPU *cpu, uint8_t opcode);
-void handle_0x74(CPU *cpu, uint8_t opcode);
-void handle_0x75(CPU *cpu, uint8_t opcode);
-void handle_0x76(CPU *cpu, uint8_t opcode);
-void handle_0x77(CPU *cpu, uint8_t opcode);
-void handle_0x78(CPU *cpu, uint8_t opcode);
-void handle_0x79(CPU *cpu, uint8_t opcode);
-void handle_0x7A(CPU *cpu, uint8_t opcode);
-void handle_0x7B(CPU *cpu, uint8_t opcode);
-void handle_0x7C(CPU *cpu, uint8_t opcode);
-void handle_0x7D(CPU *cpu, uint8_t opcode);
-void handle_0x7E(CPU *cpu, uint8_t opcode);
-void handle_0x7F(CPU *cpu, uint8_t opcode);
-void handle_0x80(CPU *cpu, uint8_t opcode);
-void handle_0x81(CPU *cpu, uint8_t opcode);
-void handle_0x82(CPU *cpu, uint8_t opcode);
-void handle_0x83(CPU *cpu, uint8_t opcode);
-void handle_0x84(CPU *cpu, uint8_t opcode);
-void handle_0x85(CPU *cpu, uint8_t opcode);
-void handle_0x86(CPU *cpu, uint8_t opcode);
-void handle_0x87(CPU *cpu, uint8_t opcode);
-void handle_0x88(CPU *cpu, uint8_t opcode);
-void handle_0x89(CPU *cpu, uint8_t opcode);
-void handle_0x8A(CPU *cpu, uint8_t opcode);
-void handle_0x8B(CPU *cpu, uint8_t opcode);
-void handle_0x8C(CPU *cpu, uint8_t opcode);
-void handle_0x8D(CPU *cpu, uint8_t opcode);
-void handle_0x8E(CPU *cpu, uint8_t opcode);
-void handle_0x8F(CPU *cpu, uint8_t opcode);
-void handle_0x90(CPU *cpu, uint8_t opcode);
-void handle_0x91(CPU *cpu, uint8_t opcode);
-void handle_0x92(CPU *cpu, uint8_t opcode);
-void handle_0x93(CPU *cpu, uint8_t opcode);
-void handle_0x94(CPU *cpu, uint8_t opcode);
-void handle_0x95(CPU *cpu, uint8_t opcode);
-void handle_0x96(CPU *cpu, uint8_t opcode);
-void handle_0x97(CPU *cpu, uint8_t opcode);
-void handle_0x98(CPU *cpu, uint8_t opcode);
-void handle_0x99(CPU *cpu, uint8_t opcode);
-void handle_0x9A(CPU *cpu, uint8_t opcode);
-void handle_0x9B(CPU *cpu, uint8_t opcode);
-void handle_0x9C(CPU *cpu, uint8_t opcode);
-void handle_0x9D(CPU *cpu, uint8_t opcode);
-void handle_0x9E(CPU *cpu, uint8_t opcode);
-void handle_0x9F(CPU *cpu, uint8_t opcode);
-void handle_0xA0(CPU *cpu, uint8_t opcode);
-void handle_0xA1(CPU *cpu, uint8_t opcode);
-void handle_0xA2(CPU *cpu, uint8_t opcode);
-void handle_0xA3(CPU *cpu, uint8_t opcode);
-void handle_0xA4(CPU *cpu, uint8_t opcode);
-void handle_0xA5(CPU *cpu, uint8_t opcode);
-void handle_0xA6(CPU *cpu, uint8_t opcode);
-void handle_0xA7(CPU *cpu, uint8_t opcode);
-void handle_0xA8(CPU *cpu, uint8_t opcode);
-void handle_0xA9(CPU *cpu, uint8_t opcode);
-void handle_0xAA(CPU *cpu, uint8_t opcode);
-void handle_0xAB(CPU *cpu, uint8_t opcode);
-void handle_0xAC(CPU *cpu, uint8_t opcode);
-void handle_0xAD(CPU *cpu, uint8_t opcode);
-void handle_0xAE(CPU *cpu, uint8_t opcode);
-void handle_0xAF(CPU *cpu, uint8_t opcode);
-void handle_0xB0(CPU *cpu, uint8_t opcode);
-void handle_0xB1(CPU *cpu, uint8_t opcode);
-void handle_0xB2(CPU *cpu, uint8_t opcode);
-void handle_0xB3(CPU *cpu, uint8_t opcode);
-void handle_0xB4(CPU *cpu, uint8_t opcode);
-void handle_0xB5(CPU *cpu, uint8_t opcode);
-void handle_0xB6(CPU *cpu, uint8_t opcode);
-void handle_0xB7(CPU *cpu, uint8_t opcode);
-void handle_0xB8(CPU *cpu, uint8_t opcode);
-void handle_0xB9(CPU *cpu, uint8_t opcode);
-void handle_0xBA(CPU *cpu, uint8_t opcode);
-void handle_0xBB(CPU *cpu, uint8_t opcode);
-void handle_0xBC(CPU *cpu, uint8_t opcode);
-void handle_0xBD(CPU *cpu, uint8_t opcode);
-void handle_0xBE(CPU *cpu, uint8_t opcode);
-void handle_0xBF(CPU *cpu, uint8_t opcode);
-void handle_0xC0(CPU *cpu, uint8_t opcode);
-void handle_0xC1(CPU *cpu, uint8_t opcode);
-void handle_0xC2(CPU *cpu, uint8_t opcode);
-void handle_0xC3(CPU *cpu, uint8_t opcode);
-void handle_0xC4(CPU *cpu, uint8_t opcode);
-void handle_0xC5(CPU *cpu, uint8_t opcode);
-void handle_0xC6(CPU *cpu, uint8_t opcode);
-void handle_0xC7(CPU *cpu, uint8_t opcode);
-void handle_0xC8(CPU *cpu, uint8_t opcode);
-void handle_0xC9(CPU *cpu, uint8_t opcode);
-void handle_0xCA(CPU *cpu, uint8_t opcode);
-void handle_0xCB(CPU *cpu, uint8_t opcode);
-void handle_0xCC(CPU *cpu, uint8_t opcode);
-void handle_0xCD(CPU *cpu, uint8_t opcode);
-void handle_0xCE(CPU *cpu, uint8_t opcode);
-void handle_0xCF(CPU *cpu, uint8_t opcode);
-void handle_0xD0(CPU *cpu, uint8_t opcode);
-void handle_0xD1(CPU *cpu, uint8_t opcode);
-void handle_0xD2(CPU *cpu, uint8_t opcode);
-void handle_0xD3(CPU *cpu, uint8_t opcode);
-void handle_0xD4(CPU *cpu, uint8_t opcode);
-void handle_0xD5(CPU *cpu, uint8_t opcode);
-void handle_0xD6(CPU *cpu, uint8_t opcode);
-void handle_0xD7(CPU *cpu, uint8_t opcode);
-void handle_0xD8(CPU *cpu, uint8_t opcode);
-void handle_0xD9(CPU *cpu, uint8_t opcode);
-void handle_0xDA(CPU *cpu, uint8_t opcode);
-void handle_0xDB(CPU *cpu, uint8_t opcode);
-void handle_0xDC(CPU *cpu, uint8_t opcode);
-void handle_0xDD(CPU *cpu, uint8_t opcode);
-void handle_0xDE(CPU *cpu, uint8_t opcode);
-void handle_0xDF(CPU *cpu, uint8_t opcode);
-void handle_0xE0(CPU *cpu, uint8_t opcode);
-void handle_0xE1(CPU *cpu, uint8_t opcode);
-void handle_0xE2(CPU *cpu, uint8_t opcode);
-void handle_0xE3(CPU *cpu, uint8_t opcode);
-void handle_0xE4(CPU *cpu, uint8_t opcode);
-void handle_0xE5(CPU *cpu, uint8_t opcode);
-void handle_0xE6(CPU *cpu, uint8_t opcode);
-void handle_0xE7(CPU *cpu, uint8_t opcode);
-void handle_0xE8(CPU *cpu, uint8_t opcode);
-void handle_0xE9(CPU *cpu, uint8_t opcode);
-void handle_0xEA(CPU *cpu, uint8_t opcode);
-void handle_0xEB(CPU *cpu, uint8_t opcode);
-void handle_0xEC(CPU *cpu, uint8_t opcode);
-void handle_0xED(CPU *cpu, uint8_t opcode);
-void handle_0xEE(CPU *cpu, uint8_t opcode);
-void handle_0xEF(CPU *cpu, uint8_t opcode);
-void handle_0xF0(CPU *cpu, uint8_t opcode);
-void handle_0xF1(CPU *cpu, uint8_t opcode);
-void handle_0xF2(CPU *cpu, uint8_t opcode);
-void handle_0xF3(CPU *cpu, uint8_t opcode);
-void handle_0xF4(CPU *cpu, uint8_t opcode);
-void handle_0xF5(CPU *cpu, uint8_t opcode);
-void handle_0xF6(CPU *cpu, uint8_t opcode);
-void handle_0xF7(CPU *cpu, uint8_t opcode);
-void handle_0xF8(CPU *cpu, uint8_t opcode);
-void handle_0xF9(CPU *cpu, uint8_t opcode);
-void handle_0xFA(CPU *cpu, uint8_t opcode);
-void handle_0xFB(CPU *cpu, uint8_t opcode);
-void handle_0xFC(CPU *cpu, uint8_t opcode);
-void handle_0xFD(CPU *cpu, uint8_t opcode);
-void handle_0xFE(CPU *cpu, uint8_t opcode);
-void handle_0xFF(CPU *cpu, uint8_t opcode);
\ No newline at end of file
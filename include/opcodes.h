@@ -0,0 +1,309 @@
+#ifndef OPCODES_H
+#define OPCODES_H
+
+#include <stdint.h>
+
+// Addressing modes
+#define ADDR_IMP 0  // Implied / Accumulator
+#define ADDR_IMM 1  // #Immediate
+#define ADDR_ZP  2  // Zero Page
+#define ADDR_ZPX 3  // Zero Page, X
+#define ADDR_ZPY 4  // Zero Page, Y
+#define ADDR_ABS 5  // Absolute
+#define ADDR_ABX 6  // Absolute, X
+#define ADDR_ABY 7  // Absolute, Y
+#define ADDR_IZX 8  // (Indirect, X)
+#define ADDR_IZY 9  // (Indirect), Y
+#define ADDR_REL 10 // Relative (branches)
+#define ADDR_IND 11 // (Indirect) (JMP only)
+
+// Instruction length in bytes (opcode and operand) for each addressing mode
+#define ADDR_LENGTH_IMP 1
+#define ADDR_LENGTH_IMM 2
+#define ADDR_LENGTH_ZP  2
+#define ADDR_LENGTH_ZPX 2
+#define ADDR_LENGTH_ZPY 2
+#define ADDR_LENGTH_ABS 3
+#define ADDR_LENGTH_ABX 3
+#define ADDR_LENGTH_ABY 3
+#define ADDR_LENGTH_IZX 2
+#define ADDR_LENGTH_IZY 2
+#define ADDR_LENGTH_REL 2
+#define ADDR_LENGTH_IND 3
+
+// Static description of an opcode
+typedef struct OpcodeInfo {
+    const char *name;       // mnemonic of the operation
+    uint8_t mode;           // addressing mode (ADDR_*)
+    uint8_t length;         // instruction length in bytes (ADDR_LENGTH_*)
+    uint8_t cycles;         // base cycle count
+    uint8_t page_penalty;   // 1 if crossing a page while indexing costs an extra cycle
+} OpcodeInfo;
+
+extern const OpcodeInfo opcode_info[256];
+
+// Opcode table: X(opcode, mnemonic, operation, addressing mode, base cycles, page-cross penalty)
+//
+// The operation column names the function in cpu.c that implements the instruction.
+// Both opcode_info[] and the CPU dispatcher are generated from this list, so it is the
+// only place where cycle counts live. Branches add their own taken/page-cross cycles.
+// KIL opcodes skip their operand byte and take no cycles.
+#define OPCODE_TABLE(X) \
+    X(0x00, BRK, brk,     IMP, 7, 0) \
+    X(0x01, ORA, ora,     IZX, 6, 0) \
+    X(0x02, KIL, kil,     IMM, 0, 0) \
+    X(0x03, SLO, slo,     IZX, 8, 0) \
+    X(0x04, NOP, nop,     ZP,  3, 0) \
+    X(0x05, ORA, ora,     ZP,  3, 0) \
+    X(0x06, ASL, asl,     ZP,  5, 0) \
+    X(0x07, SLO, slo,     ZP,  5, 0) \
+    X(0x08, PHP, php,     IMP, 3, 0) \
+    X(0x09, ORA, ora,     IMM, 2, 0) \
+    X(0x0A, ASL, asl_acc, IMP, 2, 0) \
+    X(0x0B, ANC, anc,     IMM, 2, 0) \
+    X(0x0C, NOP, nop,     ABS, 4, 0) \
+    X(0x0D, ORA, ora,     ABS, 4, 0) \
+    X(0x0E, ASL, asl,     ABS, 6, 0) \
+    X(0x0F, SLO, slo,     ABS, 6, 0) \
+    X(0x10, BPL, bpl,     REL, 2, 0) \
+    X(0x11, ORA, ora,     IZY, 5, 1) \
+    X(0x12, KIL, kil,     IMM, 0, 0) \
+    X(0x13, SLO, slo,     IZY, 8, 0) \
+    X(0x14, NOP, nop,     ZPX, 4, 0) \
+    X(0x15, ORA, ora,     ZPX, 4, 0) \
+    X(0x16, ASL, asl,     ZPX, 6, 0) \
+    X(0x17, SLO, slo,     ZPX, 6, 0) \
+    X(0x18, CLC, clc,     IMP, 2, 0) \
+    X(0x19, ORA, ora,     ABY, 4, 1) \
+    X(0x1A, NOP, nop,     IMP, 2, 0) \
+    X(0x1B, SLO, slo,     ABY, 7, 0) \
+    X(0x1C, NOP, nop,     ABX, 4, 1) \
+    X(0x1D, ORA, ora,     ABX, 4, 1) \
+    X(0x1E, ASL, asl,     ABX, 7, 0) \
+    X(0x1F, SLO, slo,     ABX, 7, 0) \
+    X(0x20, JSR, jsr,     ABS, 6, 0) \
+    X(0x21, AND, and,     IZX, 6, 0) \
+    X(0x22, KIL, kil,     IMM, 0, 0) \
+    X(0x23, RLA, rla,     IZX, 8, 0) \
+    X(0x24, BIT, bit,     ZP,  3, 0) \
+    X(0x25, AND, and,     ZP,  3, 0) \
+    X(0x26, ROL, rol,     ZP,  5, 0) \
+    X(0x27, RLA, rla,     ZP,  5, 0) \
+    X(0x28, PLP, plp,     IMP, 4, 0) \
+    X(0x29, AND, and,     IMM, 2, 0) \
+    X(0x2A, ROL, rol_acc, IMP, 2, 0) \
+    X(0x2B, ANC, anc,     IMM, 2, 0) \
+    X(0x2C, BIT, bit,     ABS, 4, 0) \
+    X(0x2D, AND, and,     ABS, 4, 0) \
+    X(0x2E, ROL, rol,     ABS, 6, 0) \
+    X(0x2F, RLA, rla,     ABS, 6, 0) \
+    X(0x30, BMI, bmi,     REL, 2, 0) \
+    X(0x31, AND, and,     IZY, 5, 1) \
+    X(0x32, KIL, kil,     IMM, 0, 0) \
+    X(0x33, RLA, rla,     IZY, 8, 0) \
+    X(0x34, NOP, nop,     ZPX, 4, 0) \
+    X(0x35, AND, and,     ZPX, 4, 0) \
+    X(0x36, ROL, rol,     ZPX, 6, 0) \
+    X(0x37, RLA, rla,     ZPX, 6, 0) \
+    X(0x38, SEC, sec,     IMP, 2, 0) \
+    X(0x39, AND, and,     ABY, 4, 1) \
+    X(0x3A, NOP, nop,     IMP, 2, 0) \
+    X(0x3B, RLA, rla,     ABY, 7, 0) \
+    X(0x3C, NOP, nop,     ABX, 4, 1) \
+    X(0x3D, AND, and,     ABX, 4, 1) \
+    X(0x3E, ROL, rol,     ABX, 7, 0) \
+    X(0x3F, RLA, rla,     ABX, 7, 0) \
+    X(0x40, RTI, rti,     IMP, 6, 0) \
+    X(0x41, EOR, eor,     IZX, 6, 0) \
+    X(0x42, KIL, kil,     IMM, 0, 0) \
+    X(0x43, SRE, sre,     IZX, 8, 0) \
+    X(0x44, NOP, nop,     ZP,  3, 0) \
+    X(0x45, EOR, eor,     ZP,  3, 0) \
+    X(0x46, LSR, lsr,     ZP,  5, 0) \
+    X(0x47, SRE, sre,     ZP,  5, 0) \
+    X(0x48, PHA, pha,     IMP, 3, 0) \
+    X(0x49, EOR, eor,     IMM, 2, 0) \
+    X(0x4A, LSR, lsr_acc, IMP, 2, 0) \
+    X(0x4B, ALR, alr,     IMM, 2, 0) \
+    X(0x4C, JMP, jmp,     ABS, 3, 0) \
+    X(0x4D, EOR, eor,     ABS, 4, 0) \
+    X(0x4E, LSR, lsr,     ABS, 6, 0) \
+    X(0x4F, SRE, sre,     ABS, 6, 0) \
+    X(0x50, BVC, bvc,     REL, 2, 0) \
+    X(0x51, EOR, eor,     IZY, 5, 1) \
+    X(0x52, KIL, kil,     IMM, 0, 0) \
+    X(0x53, SRE, sre,     IZY, 8, 0) \
+    X(0x54, NOP, nop,     ZPX, 4, 0) \
+    X(0x55, EOR, eor,     ZPX, 4, 0) \
+    X(0x56, LSR, lsr,     ZPX, 6, 0) \
+    X(0x57, SRE, sre,     ZPX, 6, 0) \
+    X(0x58, CLI, cli,     IMP, 2, 0) \
+    X(0x59, EOR, eor,     ABY, 4, 1) \
+    X(0x5A, NOP, nop,     IMP, 2, 0) \
+    X(0x5B, SRE, sre,     ABY, 7, 0) \
+    X(0x5C, NOP, nop,     ABX, 4, 1) \
+    X(0x5D, EOR, eor,     ABX, 4, 1) \
+    X(0x5E, LSR, lsr,     ABX, 7, 0) \
+    X(0x5F, SRE, sre,     ABX, 7, 0) \
+    X(0x60, RTS, rts,     IMP, 6, 0) \
+    X(0x61, ADC, adc,     IZX, 6, 0) \
+    X(0x62, KIL, kil,     IMM, 0, 0) \
+    X(0x63, RRA, rra,     IZX, 8, 0) \
+    X(0x64, NOP, nop,     ZP,  3, 0) \
+    X(0x65, ADC, adc,     ZP,  3, 0) \
+    X(0x66, ROR, ror,     ZP,  5, 0) \
+    X(0x67, RRA, rra,     ZP,  5, 0) \
+    X(0x68, PLA, pla,     IMP, 4, 0) \
+    X(0x69, ADC, adc,     IMM, 2, 0) \
+    X(0x6A, ROR, ror_acc, IMP, 2, 0) \
+    X(0x6B, ARR, arr,     IMM, 2, 0) \
+    X(0x6C, JMP, jmp,     IND, 5, 0) \
+    X(0x6D, ADC, adc,     ABS, 4, 0) \
+    X(0x6E, ROR, ror,     ABS, 6, 0) \
+    X(0x6F, RRA, rra,     ABS, 6, 0) \
+    X(0x70, BVS, bvs,     REL, 2, 0) \
+    X(0x71, ADC, adc,     IZY, 5, 1) \
+    X(0x72, KIL, kil,     IMM, 0, 0) \
+    X(0x73, RRA, rra,     IZY, 8, 0) \
+    X(0x74, NOP, nop,     ZPX, 4, 0) \
+    X(0x75, ADC, adc,     ZPX, 4, 0) \
+    X(0x76, ROR, ror,     ZPX, 6, 0) \
+    X(0x77, RRA, rra,     ZPX, 6, 0) \
+    X(0x78, SEI, sei,     IMP, 2, 0) \
+    X(0x79, ADC, adc,     ABY, 4, 1) \
+    X(0x7A, NOP, nop,     IMP, 2, 0) \
+    X(0x7B, RRA, rra,     ABY, 7, 0) \
+    X(0x7C, NOP, nop,     ABX, 4, 1) \
+    X(0x7D, ADC, adc,     ABX, 4, 1) \
+    X(0x7E, ROR, ror,     ABX, 7, 0) \
+    X(0x7F, RRA, rra,     ABX, 7, 0) \
+    X(0x80, NOP, nop,     IMM, 2, 0) \
+    X(0x81, STA, sta,     IZX, 6, 0) \
+    X(0x82, NOP, nop,     IMM, 2, 0) \
+    X(0x83, SAX, sax,     IZX, 6, 0) \
+    X(0x84, STY, sty,     ZP,  3, 0) \
+    X(0x85, STA, sta,     ZP,  3, 0) \
+    X(0x86, STX, stx,     ZP,  3, 0) \
+    X(0x87, SAX, sax,     ZP,  3, 0) \
+    X(0x88, DEY, dey,     IMP, 2, 0) \
+    X(0x89, NOP, nop,     IMM, 2, 0) \
+    X(0x8A, TXA, txa,     IMP, 2, 0) \
+    X(0x8B, XAA, xaa,     IMM, 2, 0) \
+    X(0x8C, STY, sty,     ABS, 4, 0) \
+    X(0x8D, STA, sta,     ABS, 4, 0) \
+    X(0x8E, STX, stx,     ABS, 4, 0) \
+    X(0x8F, SAX, sax,     ABS, 4, 0) \
+    X(0x90, BCC, bcc,     REL, 2, 0) \
+    X(0x91, STA, sta,     IZY, 6, 0) \
+    X(0x92, KIL, kil,     IMM, 0, 0) \
+    X(0x93, AHX, ahx,     IZY, 8, 0) \
+    X(0x94, STY, sty,     ZPX, 4, 0) \
+    X(0x95, STA, sta,     ZPX, 4, 0) \
+    X(0x96, STX, stx,     ZPY, 4, 0) \
+    X(0x97, SAX, sax,     ZPY, 4, 0) \
+    X(0x98, TYA, tya,     IMP, 2, 0) \
+    X(0x99, STA, sta,     ABY, 5, 0) \
+    X(0x9A, TXS, txs,     IMP, 2, 0) \
+    X(0x9B, TAS, tas,     ABY, 5, 0) \
+    X(0x9C, SHY, shy,     ABX, 5, 0) \
+    X(0x9D, STA, sta,     ABX, 5, 0) \
+    X(0x9E, SHX, shx,     ABY, 5, 0) \
+    X(0x9F, AHX, ahx,     ABY, 5, 0) \
+    X(0xA0, LDY, ldy,     IMM, 2, 0) \
+    X(0xA1, LDA, lda,     IZX, 6, 0) \
+    X(0xA2, LDX, ldx,     IMM, 2, 0) \
+    X(0xA3, LAX, lax,     IZX, 6, 0) \
+    X(0xA4, LDY, ldy,     ZP,  3, 0) \
+    X(0xA5, LDA, lda,     ZP,  3, 0) \
+    X(0xA6, LDX, ldx,     ZP,  3, 0) \
+    X(0xA7, LAX, lax,     ZP,  3, 0) \
+    X(0xA8, TAY, tay,     IMP, 2, 0) \
+    X(0xA9, LDA, lda,     IMM, 2, 0) \
+    X(0xAA, TAX, tax,     IMP, 2, 0) \
+    X(0xAB, LAX, lax,     IMM, 2, 0) \
+    X(0xAC, LDY, ldy,     ABS, 4, 0) \
+    X(0xAD, LDA, lda,     ABS, 4, 0) \
+    X(0xAE, LDX, ldx,     ABS, 4, 0) \
+    X(0xAF, LAX, lax,     ABS, 4, 0) \
+    X(0xB0, BCS, bcs,     REL, 2, 0) \
+    X(0xB1, LDA, lda,     IZY, 5, 1) \
+    X(0xB2, KIL, kil,     IMM, 0, 0) \
+    X(0xB3, LAX, lax,     IZY, 5, 1) \
+    X(0xB4, LDY, ldy,     ZPX, 4, 0) \
+    X(0xB5, LDA, lda,     ZPX, 4, 0) \
+    X(0xB6, LDX, ldx,     ZPY, 4, 0) \
+    X(0xB7, LAX, lax,     ZPY, 4, 0) \
+    X(0xB8, CLV, clv,     IMP, 2, 0) \
+    X(0xB9, LDA, lda,     ABY, 4, 1) \
+    X(0xBA, TSX, tsx,     IMP, 2, 0) \
+    X(0xBB, LAS, las,     ABY, 4, 0) \
+    X(0xBC, LDY, ldy,     ABX, 4, 1) \
+    X(0xBD, LDA, lda,     ABX, 4, 1) \
+    X(0xBE, LDX, ldx,     ABY, 4, 1) \
+    X(0xBF, LAX, lax,     ABY, 4, 1) \
+    X(0xC0, CPY, cpy,     IMM, 2, 0) \
+    X(0xC1, CMP, cmp,     IZX, 6, 0) \
+    X(0xC2, NOP, nop,     IMM, 2, 0) \
+    X(0xC3, DCP, dcp,     IZX, 8, 0) \
+    X(0xC4, CPY, cpy,     ZP,  3, 0) \
+    X(0xC5, CMP, cmp,     ZP,  3, 0) \
+    X(0xC6, DEC, dec,     ZP,  5, 0) \
+    X(0xC7, DCP, dcp,     ZP,  5, 0) \
+    X(0xC8, INY, iny,     IMP, 2, 0) \
+    X(0xC9, CMP, cmp,     IMM, 2, 0) \
+    X(0xCA, DEX, dex,     IMP, 2, 0) \
+    X(0xCB, AXS, axs,     IMM, 2, 0) \
+    X(0xCC, CPY, cpy,     ABS, 4, 0) \
+    X(0xCD, CMP, cmp,     ABS, 4, 0) \
+    X(0xCE, DEC, dec,     ABS, 6, 0) \
+    X(0xCF, DCP, dcp,     ABS, 6, 0) \
+    X(0xD0, BNE, bne,     REL, 2, 0) \
+    X(0xD1, CMP, cmp,     IZY, 5, 1) \
+    X(0xD2, KIL, kil,     IMM, 0, 0) \
+    X(0xD3, DCP, dcp,     IZY, 8, 0) \
+    X(0xD4, NOP, nop,     ZPX, 4, 0) \
+    X(0xD5, CMP, cmp,     ZPX, 4, 0) \
+    X(0xD6, DEC, dec,     ZPX, 6, 0) \
+    X(0xD7, DCP, dcp,     ZPX, 6, 0) \
+    X(0xD8, CLD, cld,     IMP, 2, 0) \
+    X(0xD9, CMP, cmp,     ABY, 4, 1) \
+    X(0xDA, NOP, nop,     IMP, 2, 0) \
+    X(0xDB, DCP, dcp,     ABY, 7, 0) \
+    X(0xDC, NOP, nop,     ABX, 4, 1) \
+    X(0xDD, CMP, cmp,     ABX, 4, 1) \
+    X(0xDE, DEC, dec,     ABX, 7, 0) \
+    X(0xDF, DCP, dcp,     ABX, 7, 0) \
+    X(0xE0, CPX, cpx,     IMM, 2, 0) \
+    X(0xE1, SBC, sbc,     IZX, 6, 0) \
+    X(0xE2, NOP, nop,     IMM, 2, 0) \
+    X(0xE3, ISC, isc,     IZX, 8, 0) \
+    X(0xE4, CPX, cpx,     ZP,  3, 0) \
+    X(0xE5, SBC, sbc,     ZP,  3, 0) \
+    X(0xE6, INC, inc,     ZP,  5, 0) \
+    X(0xE7, ISC, isc,     ZP,  5, 0) \
+    X(0xE8, INX, inx,     IMP, 2, 0) \
+    X(0xE9, SBC, sbc,     IMM, 2, 0) \
+    X(0xEA, NOP, nop,     IMP, 2, 0) \
+    X(0xEB, SBC, sbc,     IMM, 2, 0) \
+    X(0xEC, CPX, cpx,     ABS, 4, 0) \
+    X(0xED, SBC, sbc,     ABS, 4, 0) \
+    X(0xEE, INC, inc,     ABS, 6, 0) \
+    X(0xEF, ISC, isc,     ABS, 6, 0) \
+    X(0xF0, BEQ, beq,     REL, 2, 0) \
+    X(0xF1, SBC, sbc,     IZY, 5, 1) \
+    X(0xF2, KIL, kil,     IMM, 0, 0) \
+    X(0xF3, ISC, isc,     IZY, 8, 0) \
+    X(0xF4, NOP, nop,     ZPX, 4, 0) \
+    X(0xF5, SBC, sbc,     ZPX, 4, 0) \
+    X(0xF6, INC, inc,     ZPX, 6, 0) \
+    X(0xF7, ISC, isc,     ZPX, 6, 0) \
+    X(0xF8, SED, sed,     IMP, 2, 0) \
+    X(0xF9, SBC, sbc,     ABY, 4, 1) \
+    X(0xFA, NOP, nop,     IMP, 2, 0) \
+    X(0xFB, ISC, isc,     ABY, 7, 0) \
+    X(0xFC, NOP, nop,     ABX, 4, 1) \
+    X(0xFD, SBC, sbc,     ABX, 4, 1) \
+    X(0xFE, INC, inc,     ABX, 7, 0) \
+    X(0xFF, ISC, isc,     ABX, 7, 0)
+
+#endif
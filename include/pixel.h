@@ -0,0 +1,28 @@
+#ifndef PIXEL_H
+#define PIXEL_H
+
+#include <stdint.h>
+
+// Converts indexed framebuffer pixels (see PIXEL_* in ppu.h) to packed 32-bit pixels through a lookup table.
+// The kernel is picked once at startup from what the host CPU supports (CPUID), with a scalar fallback.
+
+#define PIXEL_LUT_SIZE          128 // table entries per emphasis setting: 64 colors, then their greyscale versions
+#define PIXEL_EMPHASIS_COUNT    8   // PPUMASK_R/G/B combinations (PPUMASK >> 5)
+#define PIXEL_FORMAT_COUNT      3
+
+// Conversion kernels
+#define PIXEL_KERNEL_SCALAR     0
+#define PIXEL_KERNEL_AVX2       1 // 8 pixels per vpgatherdd
+#define PIXEL_KERNEL_COUNT      2
+
+void pixel_init();
+const uint32_t *pixel_lut(int format, int emphasis);
+void pixel_convert(const uint8_t *src, uint32_t *dst, int count, const uint32_t *lut);
+
+// kernel selection (pixel_init picks the fastest supported one)
+int pixel_kernel_supported(int kernel);
+int pixel_set_kernel(int kernel); // returns 0 if the host CPU cannot run it
+int pixel_get_kernel();
+const char *pixel_kernel_name(int kernel);
+
+#endif
@@ -2,11 +2,21 @@
 #define PPU_H
 
 #include <stdint.h>
-#include <SDL.h>
+
+typedef struct NES NES;
 
 #define NES_WIDTH           256
 #define NES_HEIGHT          240
 
+// Indexed framebuffer pixels: bits 0-5 are the NES color index, bit 6 marks pixels drawn with PPUMASK_Gr set
+#define PIXEL_COLOR_MASK    0x3F
+#define PIXEL_GREYSCALE     0x40
+
+// Pixel formats for ppu_convert_frame (packed 32-bit pixels, named from the most significant byte)
+#define PIXEL_FORMAT_RGBA8888   0
+#define PIXEL_FORMAT_ARGB8888   1
+#define PIXEL_FORMAT_BGRA8888   2
+
 // Size of Object Attribute Memory (OAM) for sprites
 // Each sprite takes 4 bytes, total 64 sprites, 256 bytes
 // Byte 0: Y position
@@ -16,6 +26,15 @@
 #define OAM_SIZE            256
 #define PALETTE_SIZE        32
 
+// Sprites are evaluated once per scanline, at most 8 of them are copied into secondary OAM
+#define MAX_LINE_SPRITES    8
+#define SECONDARY_OAM_SIZE  (MAX_LINE_SPRITES * 4)
+
+// ppu_run_dots results
+#define PPU_RUN_DONE        0 // all requested dots ran
+#define PPU_RUN_FRAME       1 // stopped after the last dot of a frame
+#define PPU_RUN_NMI         2 // stopped after the dot that raised the vblank NMI
+
 // ====================== Memory-Mapped Registers ======================
 
 #define PPUCTRL_REG         0x2000 // Sets up rendering settings
@@ -56,7 +75,12 @@
 
 // NES master palette
 #define PALETTE_BASE        0x3F00
-extern SDL_Color nes_palette[64];
+
+typedef struct PaletteColor {
+    uint8_t r, g, b, a;
+} PaletteColor;
+
+extern PaletteColor nes_palette[64];
 
 typedef struct PPU {
     uint8_t oam[OAM_SIZE]; // Object Attribute Memory (OAM) for sprites
@@ -85,39 +109,59 @@ typedef struct PPU {
     // Background rendering
 	uint8_t bg_next_tile_id; // name table id
 	uint8_t bg_next_tile_attrib; // attribute table byte
-	uint8_t bg_next_tile_lsb; // pattern table low byte
-	uint8_t bg_next_tile_msb; // pattern table high byte
-	uint16_t bg_shifter_pattern_lo;
-	uint16_t bg_shifter_pattern_hi;
+	uint16_t bg_next_tile_row; // decoded pattern table row (2 bits per pixel)
+	uint32_t bg_shifter_pattern; // two tiles of decoded pixels, current pixel in the top 2 bits at fine X 0
 	uint16_t bg_shifter_attrib_lo;
 	uint16_t bg_shifter_attrib_hi;
 
+    // Sprite rendering (evaluated at cycle 257 for the next scanline)
+    uint8_t secondary_oam[SECONDARY_OAM_SIZE]; // sprites selected for the next scanline, in OAM order
+    int sprite_count;                           // number of sprites in secondary OAM
+    int sprite_zero_selected;                   // secondary OAM slot 0 holds OAM sprite 0
+    uint16_t sprite_shifter_pattern[MAX_LINE_SPRITES]; // prefetched decoded pattern rows (already flipped)
+    uint8_t sprite_attrib[MAX_LINE_SPRITES];
+    uint8_t sprite_x_counter[MAX_LINE_SPRITES]; // pixels left until the sprite starts shifting out
+
     // write toggle
     uint8_t w;  // First or second write toggle (1 bit)
 
     // buffer
     uint8_t data_buffer; // buffers data read from PPU
+    uint8_t last_status; // value returned by the last PPUSTATUS read (idle loop detection)
 
     int nmi; // nmi interrupt flag
 
     int cycle;      // [0, 340]
     int scanline;   // [-1, 260], where -1 is the pre-render line, 0–239 are visible, 240 is post-render, 241–260 is VBlank
 
-    uint32_t frame_buffer[NES_WIDTH * NES_HEIGHT]; // PPU writes to framebuffer and display renders to screen
+    uint8_t frame_buffer[NES_WIDTH * NES_HEIGHT]; // indexed pixels (PIXEL_*), converted to RGB with ppu_convert_frame
+    uint8_t line_emphasis[NES_HEIGHT];            // PPUMASK_R/G/B (shifted down 5) latched at the start of each line
 
     int oam_dma_transfer; // flag to indicate OAM DMA transfer in progress
     uint8_t oam_dma_page; // high byte of source address for OAM DMA
     int oam_dma_cycle; // cycle counter for OAM DMA transfer (1-256 for entire page)
 
-    int frames; // keeps track of total frames to calculate FPS
-    int FPS;
+    int frames; // total number of frames rendered
+
+    int dot_accurate;   // 1: step every dot as it happens, 0: batch dots per line (see ppu_catch_up)
+    uint64_t dot_clock; // dots run since power on, 3 per CPU cycle of nes->cycles once caught up
+    int line_fallback;  // the current line was synced mid-line, the rest of it runs in lockstep with the CPU
+
+    NES *nes; // console this PPU belongs to (bus access, mapper IRQ clock)
 } PPU;
 
-PPU *ppu_init();
+PPU *ppu_init(NES *nes);
 void ppu_free(PPU *ppu);
 int ppu_run_cycle(PPU *ppu);
+void ppu_run_line(PPU *ppu, int last);
+int ppu_run_dots(PPU *ppu, int *dots);
+int ppu_catch_up(PPU *ppu, uint64_t cycle);
+uint64_t ppu_next_event(PPU *ppu);
+uint64_t ppu_status_stable_until(PPU *ppu, uint64_t until);
+void ppu_sync(PPU *ppu);
 uint8_t ppu_register_read(PPU *ppu, uint16_t reg);
 void ppu_register_write(PPU *ppu, uint16_t reg, uint8_t value);
 void ppu_oam_dma_transfer(PPU *ppu);
+void ppu_convert_frame(PPU *ppu, uint32_t *dst, int format);
 
 #endif
\ No newline at end of file
@@ -1,18 +1,70 @@
-#include <SDL.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "../include/nes.h"
 #include "../include/apu.h"
 
-void audio_callback(void *userdata, Uint8 *stream, int len);
-void pulse_channel(PulseChannel *ch, int quarter_frame, int half_frame);
-void triangle_channel(TriangleChannel *ch, int quarter_frame, int half_frame);
-void noise_channel(NoiseChannel *ch, int quarter_frame, int half_frame);
-
-#define QUARTER_FRAME_CYCLES 7457
-#define HALF_FRAME_CYCLES 14913
-
-static int apu_quarter_frame_counter = 0;
-static int apu_half_frame_counter = 0;
+void apu_run_event(APU *apu, uint64_t cycle);
+void apu_frame_step(APU *apu);
+void apu_quarter_frame(APU *apu);
+void apu_half_frame(APU *apu);
+void apu_update_irq(APU *apu);
+void apu_schedule_update(APU *apu);
+uint64_t apu_timer_reload(APU *apu, uint64_t period);
+void pulse_timer(PulseChannel *ch, uint64_t cycle);
+void pulse_quarter_frame(PulseChannel *ch);
+void pulse_half_frame(PulseChannel *ch);
+void pulse_output(APU *apu, PulseChannel *ch);
+void triangle_timer(TriangleChannel *ch, uint64_t cycle);
+void triangle_quarter_frame(TriangleChannel *ch);
+void triangle_half_frame(TriangleChannel *ch);
+void triangle_output(APU *apu, TriangleChannel *ch);
+void noise_timer(NoiseChannel *ch, uint64_t cycle);
+void noise_quarter_frame(NoiseChannel *ch);
+void noise_half_frame(NoiseChannel *ch);
+void noise_output(APU *apu, NoiseChannel *ch);
+void dmc_timer(APU *apu, DMCChannel *ch, uint64_t cycle);
+void dmc_fetch(APU *apu, DMCChannel *ch);
+void dmc_restart(DMCChannel *ch);
+void dmc_output(DMCChannel *ch);
+void apu_init_blip(APU *apu);
+void apu_init_mixer(APU *apu);
+void apu_add_delta(APU *apu, uint64_t cycle, int32_t delta);
+void apu_end_samples(APU *apu, uint64_t cycle);
+
+// frame sequencer actions
+#define FRAME_QUARTER   0x01 // envelopes and triangle linear counter
+#define FRAME_HALF      0x02 // length counters and sweep units
+#define FRAME_IRQ       0x04 // frame interrupt (4-step sequence only)
+
+typedef struct FrameStep {
+    uint16_t cycle; // CPU cycles after the sequence started
+    uint8_t actions;
+} FrameStep;
+
+// The 4-step and 5-step sequences (NTSC), in CPU cycles like the old counters. Each step
+// clocks its units once. The last step of each sequence ends it, and the next sequence
+// starts right there
+static const FrameStep frame_steps[2][6] = {
+    {
+        { 7457,  FRAME_QUARTER },
+        { 14913, FRAME_QUARTER | FRAME_HALF },
+        { 22371, FRAME_QUARTER },
+        { 29828, FRAME_IRQ },
+        { 29829, FRAME_QUARTER | FRAME_HALF | FRAME_IRQ },
+        { 29830, FRAME_IRQ }
+    },
+    {
+        { 7457,  FRAME_QUARTER },
+        { 14913, FRAME_QUARTER | FRAME_HALF },
+        { 22371, FRAME_QUARTER },
+        { 37281, FRAME_QUARTER | FRAME_HALF },
+        { 37282, 0 }
+    }
+};
+static const int frame_step_count[2] = { 6, 5 };
 
 static const uint8_t pulse_length[32] = {
     10, 254, 20, 2, 40, 4, 80, 6,
@@ -33,6 +85,12 @@ static const uint16_t noise_length[16] = {
     254, 380, 508, 762, 1016, 2034, 4068
 };
 
+// DMC timer periods in CPU cycles
+static const uint16_t dmc_rate[16] = {
+    428, 380, 340, 320, 286, 254, 226, 214,
+    190, 160, 142, 128, 106, 84, 72, 54
+};
+
 static const uint8_t duty_patterns[4][8] = {
     {0,0,0,0,0,0,0,1}, // 12.5% duty cycle
     {0,0,0,0,0,1,1,1}, // 25% duty cycle
@@ -40,7 +98,7 @@ static const uint8_t duty_patterns[4][8] = {
     {1,1,1,1,1,1,0,0}  // 75% duty cycle
 };
 
-APU *apu_init() {
+APU *apu_init(NES *nes) {
     APU *apu = (APU *)malloc(sizeof(APU));
     if (!apu) {
         fprintf(stderr, "Failed to allocate APU\n");
@@ -49,263 +107,557 @@ APU *apu_init() {
 
     // initialize all fields to zero
     memset(apu, 0, sizeof(APU));
+    apu->nes = nes;
+    apu_init_blip(apu);
+    apu_init_mixer(apu);
+
+    // timers start at 0, so they expire on the first cycle that clocks them (the triangle's runs
+    // on every CPU cycle, the others on APU cycles)
+    apu->pulse1.next_clock = 2;
+    apu->pulse2.next_clock = 2;
+    apu->triangle.next_clock = 1;
+    apu->noise.next_clock = 2;
+    apu->noise.period = noise_length[0];
+    apu->pulse1.quiet = apu->pulse2.quiet = apu->triangle.quiet = apu->noise.quiet = 1;
+    apu->dmc.rate = dmc_rate[0];
+    apu->dmc.sample_addr = 0xC000;
+    apu->dmc.sample_length = 1;
+    apu->dmc.next_clock = dmc_rate[0];
+    apu->dmc.bits_remaining = 8;
+    apu->dmc.silence = 1;
+    apu->dmc.quiet = 1;
+    apu->frame_start = 0; // as if 0x4017 was written with 0 right before power up
+    apu->frame_step = 0;
+    apu->update_cycle = UINT64_MAX;
 
-    // initialize SDL audio
-    if (SDL_Init(SDL_INIT_AUDIO) < 0) {
-        fprintf(stderr, "Failed to initialize SDL audio: %s\n", SDL_GetError());
-        exit(1);
+    return apu;
+}
+
+// Tabulates the band-limited step: for each sub-sample phase, how much of a unit step lands in
+// each of the BLIP_TAPS output samples from the next one on. The taps are a Blackman windowed
+// sinc, low-passed a little below the Nyquist frequency, so output changes do not alias. The
+// step is centered BLIP_TAPS / 2 samples later, which is the latency it adds
+void apu_init_blip(APU *apu) {
+    const double cutoff = 0.9; // fraction of the Nyquist frequency that passes
+
+    for (int phase = 0; phase < BLIP_PHASES; phase++) {
+        double taps[BLIP_TAPS];
+        double total = 0.0;
+        for (int k = 0; k < BLIP_TAPS; k++) {
+            // distance of the middle of sample k's interval from the step
+            double x = k + 0.5 - (double)phase / BLIP_PHASES - BLIP_TAPS / 2;
+            double sinc = (x == 0.0) ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            double window = 0.42 + 0.5 * cos(2.0 * M_PI * x / BLIP_TAPS) + 0.08 * cos(4.0 * M_PI * x / BLIP_TAPS);
+            taps[k] = sinc * window;
+            total += taps[k];
+        }
+
+        // scale to 1 << BLIP_SHIFT and put the rounding error in the middle, so a step always
+        // ends up exactly as high as the delta
+        int sum = 0;
+        for (int k = 0; k < BLIP_TAPS; k++) {
+            apu->blip_kernel[phase][k] = (int16_t)lround(taps[k] / total * (1 << BLIP_SHIFT));
+            sum += apu->blip_kernel[phase][k];
+        }
+        apu->blip_kernel[phase][BLIP_TAPS / 2] += (1 << BLIP_SHIFT) - sum;
     }
+}
 
-    SDL_AudioSpec want, have;
-    SDL_zero(want);
-    want.freq = 44100; // sample rate
-    want.format = AUDIO_S16SYS; // 16-bit signed audio
-    want.channels = 1; 
-    want.samples = 1024; // buffer size
-    want.callback = audio_callback;
-    want.userdata = apu;
+// Tabulates the NES's nonlinear mixer, so mixing is two lookups. The pulse channels share one
+// DAC, indexed by the sum of their levels, and so do triangle, noise and DMC, indexed by
+// 3 * triangle + 2 * noise + DMC. The formulas are the usual approximations of both DACs
+void apu_init_mixer(APU *apu) {
+    apu->pulse_table[0] = 0;
+    for (int n = 1; n < APU_PULSE_LEVELS; n++) {
+        apu->pulse_table[n] = (int16_t)lround(95.52 / (8128.0 / n + 100.0) * APU_MIX_SCALE);
+    }
 
-    apu->audio_dev = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
-    if (!apu->audio_dev) {
-        fprintf(stderr, "Failed to open audio device: %s\n", SDL_GetError());
-        exit(1);
+    apu->tnd_table[0] = 0;
+    for (int n = 1; n < APU_TND_LEVELS; n++) {
+        apu->tnd_table[n] = (int16_t)lround(163.67 / (24329.0 / n + 100.0) * APU_MIX_SCALE);
     }
+}
 
-    SDL_PauseAudioDevice(apu->audio_dev, 0); // 0 = start playing
+// Adds a change of the mixed output at the given CPU cycle: spreads the band-limited step over
+// the next BLIP_TAPS samples, at the phase of that cycle between the last sample and the next one
+void apu_add_delta(APU *apu, uint64_t cycle, int32_t delta) {
+    // samples that end before this cycle can no longer change
+    apu_end_samples(apu, cycle - 1);
 
-    return apu;
+    uint64_t position = (cycle - 1) * AUDIO_SAMPLE_RATE;
+    int phase = (int)(position % CPU_CLOCK * BLIP_PHASES / CPU_CLOCK);
+    const int16_t *kernel = apu->blip_kernel[phase];
+
+    for (int k = 0; k < BLIP_TAPS; k++) {
+        apu->blip_pending[(apu->blip_pos + k) & (BLIP_TAPS - 1)] += (int64_t)delta * kernel[k];
+    }
 }
 
-void audio_callback(void *userdata, Uint8 *stream, int len) {
-    APU *apu = (APU *)userdata;
-    if (!apu || len <= 0) {
-        memset(stream, 0, len);
-        return;
+// Finishes every sample that ends by the given CPU cycle (one every CPU_CLOCK / AUDIO_SAMPLE_RATE
+// cycles) and queues it for the audio thread
+void apu_end_samples(APU *apu, uint64_t cycle) {
+    SampleRing *ring = &apu->ring;
+    uint64_t end = cycle * AUDIO_SAMPLE_RATE / CPU_CLOCK;
+
+    while (apu->blip_pos < end) {
+        int64_t *slot = &apu->blip_pending[apu->blip_pos & (BLIP_TAPS - 1)];
+        apu->blip_sum += *slot;
+        *slot = 0;
+        apu->blip_pos++;
+
+        // the mixer only outputs positive levels, take the DC offset out like the NES's own
+        // output filter does (one pole high-pass)
+        int32_t level = (int32_t)(apu->blip_sum >> BLIP_SHIFT);
+        int32_t sample = level - apu->highpass_in + (int32_t)(((int64_t)apu->highpass_out * APU_HIGHPASS) >> 15);
+        apu->highpass_in = level;
+        apu->highpass_out = sample;
+
+        if (sample > INT16_MAX) {
+            sample = INT16_MAX;
+        } else if (sample < INT16_MIN) {
+            sample = INT16_MIN;
+        }
+
+        // if the audio thread falls behind and the ring fills up, samples are dropped
+        uint32_t write = atomic_load_explicit(&ring->write, memory_order_relaxed);
+        uint32_t read = atomic_load_explicit(&ring->read, memory_order_acquire);
+        if (write - read < APU_RING_SIZE) {
+            ring->samples[write & (APU_RING_SIZE - 1)] = (int16_t)sample;
+            atomic_store_explicit(&ring->write, write + 1, memory_order_release);
+        }
+    }
+}
+
+// Clocks the APU from where it stopped up to the given CPU cycle, called by the emulation thread
+// before APU registers are accessed and whenever the console catches up. The APU only runs at
+// its events (apu_run_event): timer expiries of channels whose output they can change, frame
+// sequencer steps, and the APU cycle after a register write. It never waits for audio
+void apu_catch_up(APU *apu, uint64_t cycle) {
+    while (1) {
+        uint64_t next = apu->frame_start + frame_steps[apu->mode][apu->frame_step].cycle;
+        if (apu->update_cycle < next) {
+            next = apu->update_cycle;
+        }
+        if (!apu->pulse1.quiet && apu->pulse1.next_clock < next) {
+            next = apu->pulse1.next_clock;
+        }
+        if (!apu->pulse2.quiet && apu->pulse2.next_clock < next) {
+            next = apu->pulse2.next_clock;
+        }
+        if (!apu->triangle.quiet && apu->triangle.next_clock < next) {
+            next = apu->triangle.next_clock;
+        }
+        if (!apu->noise.quiet && apu->noise.next_clock < next) {
+            next = apu->noise.next_clock;
+        }
+        if (!apu->dmc.quiet && apu->dmc.next_clock < next) {
+            next = apu->dmc.next_clock;
+        }
+        if (next > cycle) {
+            break;
+        }
+        apu_run_event(apu, next);
     }
 
-    int16_t *buffer = (int16_t *)stream;
-    int samples = len / sizeof(int16_t);
+    // quiet channels are brought up to date so register writes start from where they are
+    pulse_timer(&apu->pulse1, cycle);
+    pulse_timer(&apu->pulse2, cycle);
+    triangle_timer(&apu->triangle, cycle);
+    noise_timer(&apu->noise, cycle);
+    dmc_timer(apu, &apu->dmc, cycle);
+
+    apu->cycles = cycle;
+    apu_end_samples(apu, cycle);
+}
 
-    double cycles_per_sample = (double)CPU_CLOCK / (double)APU_SAMPLE_RATE;
-    static double cycle_accum = 0.0;
+// CPU cycle of the next event the CPU can notice (UINT64_MAX: none), which the console schedules
+// like its other events: a DMC sample fetch, which stalls the CPU and can raise an IRQ, or the
+// frame IRQ. The DMC buffer is refilled as soon as the output unit takes the byte in it, on the
+// timer expiry that ends the current output cycle
+uint64_t apu_next_event(APU *apu) {
+    DMCChannel *ch = &apu->dmc;
+    uint64_t next = UINT64_MAX;
+    if (ch->buffer_full && ch->bytes_remaining > 0) {
+        next = ch->next_clock + (uint64_t)(ch->bits_remaining - 1) * ch->rate;
+    }
 
-    for (int i = 0; i < samples; i++) {
-        cycle_accum += cycles_per_sample;
-        while (cycle_accum >= 1.0) {
-            apu_run_cycle(apu);
-            cycle_accum -= 1.0;
+    if (apu->mode == 0 && !apu->IRQ_inhibit && !apu->frame_irq) {
+        int step = apu->frame_step;
+        while (!(frame_steps[0][step].actions & FRAME_IRQ)) {
+            step++;
+        }
+        uint64_t irq = apu->frame_start + frame_steps[0][step].cycle;
+        if (irq < next) {
+            next = irq;
         }
+    }
+    return next;
+}
+
+// Pops up to samples queued samples into buffer, called by the audio thread. If fewer are queued
+// the rest of buffer repeats the last one. Returns the number of samples that were queued
+int apu_read_samples(APU *apu, int16_t *buffer, int samples) {
+    SampleRing *ring = &apu->ring;
+    if (samples <= 0) {
+        return 0;
+    }
+
+    uint32_t read = atomic_load_explicit(&ring->read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&ring->write, memory_order_acquire);
+    int count = (int)(write - read);
+    if (count > samples) {
+        count = samples;
+    }
 
-        // simple linear mix of channels (also used to control volume of each channel)
-        int32_t mixed = (int32_t)apu->pulse1.output / 2
-                        + (int32_t)apu->pulse2.output / 2
-                        + (int32_t)apu->triangle.output
-                        + (int32_t)apu->noise.output / 3;
+    for (int i = 0; i < count; i++) {
+        buffer[i] = ring->samples[(read + i) & (APU_RING_SIZE - 1)];
+    }
+    atomic_store_explicit(&ring->read, read + count, memory_order_release);
 
-        buffer[i] = (int16_t)mixed;
+    if (count > 0) {
+        ring->last = buffer[count - 1];
+    }
+    for (int i = count; i < samples; i++) {
+        buffer[i] = ring->last;
     }
+    return count;
 }
 
-void apu_run_cycle(APU *apu) {
-    // increment frame counters
-    apu_quarter_frame_counter++;
-    apu_half_frame_counter++;
+// Runs the APU cycle at the given CPU cycle, in the order a real APU cycle has: timers first,
+// then frame ticks, then the channel outputs. Channels whose timer is not due are left alone
+void apu_run_event(APU *apu, uint64_t cycle) {
+    pulse_timer(&apu->pulse1, cycle);
+    pulse_timer(&apu->pulse2, cycle);
+    triangle_timer(&apu->triangle, cycle);
+    noise_timer(&apu->noise, cycle);
+    dmc_timer(apu, &apu->dmc, cycle);
+
+    if (apu->frame_start + frame_steps[apu->mode][apu->frame_step].cycle == cycle) {
+        apu_frame_step(apu);
+    }
+    if (apu->update_cycle == cycle) {
+        apu->update_cycle = UINT64_MAX;
+    }
 
-    int quarter_frame = 0; // quarter-frame flag
-    int half_frame = 0; // half-frame flag
+    pulse_output(apu, &apu->pulse1);
+    pulse_output(apu, &apu->pulse2);
+    triangle_output(apu, &apu->triangle);
+    noise_output(apu, &apu->noise);
+    dmc_output(&apu->dmc);
+
+    int32_t mixed = apu->pulse_table[apu->pulse1.output + apu->pulse2.output]
+                    + apu->tnd_table[3 * apu->triangle.output + 2 * apu->noise.output + apu->dmc.output];
+    if (mixed != apu->blip_level) {
+        apu_add_delta(apu, cycle, mixed - apu->blip_level);
+        apu->blip_level = mixed;
+    }
+}
+
+// Runs the due step of the frame sequence and moves on to the next one
+void apu_frame_step(APU *apu) {
+    const FrameStep *step = &frame_steps[apu->mode][apu->frame_step];
 
-    // check if it is time to run updates in channels
-    if (apu_quarter_frame_counter >= QUARTER_FRAME_CYCLES) {
-        apu_quarter_frame_counter -= QUARTER_FRAME_CYCLES;
-        quarter_frame = 1;
+    if (step->actions & FRAME_QUARTER) {
+        apu_quarter_frame(apu);
+    }
+    if (step->actions & FRAME_HALF) {
+        apu_half_frame(apu);
+    }
+    // the flag is set on three cycles in a row, the line stays up until it is acknowledged
+    if ((step->actions & FRAME_IRQ) && !apu->IRQ_inhibit) {
+        apu->frame_irq = 1;
+        apu_update_irq(apu);
     }
-    if (apu_half_frame_counter >= HALF_FRAME_CYCLES) {
-        apu_half_frame_counter -= HALF_FRAME_CYCLES;
-        half_frame = 1;
+
+    apu->frame_step++;
+    if (apu->frame_step == frame_step_count[apu->mode]) {
+        apu->frame_start += step->cycle;
+        apu->frame_step = 0;
     }
+}
 
-    // update pulse channel 1
-    PulseChannel *pulse1 = &apu->pulse1;
-    pulse_channel(pulse1, quarter_frame, half_frame);
+// envelopes and the triangle's linear counter
+void apu_quarter_frame(APU *apu) {
+    pulse_quarter_frame(&apu->pulse1);
+    pulse_quarter_frame(&apu->pulse2);
+    triangle_quarter_frame(&apu->triangle);
+    noise_quarter_frame(&apu->noise);
+}
 
-    // update pulse channel 2
-    PulseChannel *pulse2 = &apu->pulse2;
-    pulse_channel(pulse2, quarter_frame, half_frame);
-    // update triangle channel
-    TriangleChannel *triangle = &apu->triangle;
-    triangle_channel(triangle, quarter_frame, half_frame);
+// length counters and sweep units
+void apu_half_frame(APU *apu) {
+    pulse_half_frame(&apu->pulse1);
+    pulse_half_frame(&apu->pulse2);
+    triangle_half_frame(&apu->triangle);
+    noise_half_frame(&apu->noise);
+}
 
-    // update noise channel
-    NoiseChannel *noise = &apu->noise;
-    noise_channel(noise, quarter_frame, half_frame);
+// The IRQ line is a level, up while either interrupt flag is set. Servicing the IRQ does not
+// drop it, only acknowledging the flags through the registers does
+void apu_update_irq(APU *apu) {
+    apu->irq = apu->frame_irq || apu->dmc.irq_flag;
 }
 
-void pulse_channel(PulseChannel *ch, int quarter_frame, int half_frame) {
-    // timer and sequencer
-    if (ch->timer_counter == 0) {
-        ch->timer_counter = ch->timer + 1;
-        ch->seq_pos = (ch->seq_pos + 1) & 0x07;
-    } else {
-        ch->timer_counter--;
+// Schedules an event at the next APU cycle, where a register write shows up in the outputs
+void apu_schedule_update(APU *apu) {
+    apu->update_cycle = (apu->cycles + 2) & ~(uint64_t)1; // APU cycles are the even CPU cycles
+}
+
+// CPU cycle at which an APU-clocked timer reloaded now expires, given its period in CPU cycles
+uint64_t apu_timer_reload(APU *apu, uint64_t period) {
+    return (apu->cycles & ~(uint64_t)1) + period;
+}
+
+// ==================== Pulse ====================
+
+// Runs the timer expiries up to the given CPU cycle (one for an audible channel, any number at once
+// for a quiet one), each steps the sequencer. Expiries are timer + 1 APU cycles apart
+void pulse_timer(PulseChannel *ch, uint64_t cycle) {
+    if (ch->next_clock > cycle) {
+        return;
     }
+    uint64_t period = 2 * ((uint64_t)ch->timer + 1);
+    uint64_t count = 1 + (cycle - ch->next_clock) / period;
+    ch->seq_pos = (ch->seq_pos + count) & 0x07;
+    ch->next_clock += count * period;
+}
 
-    // envelope (run at quarter-frame) 
-    if (quarter_frame) {
-        for (int i = 0; i < 2; i++) {
-            if (ch->envelope_start) {
+// envelope (run at quarter-frame)
+void pulse_quarter_frame(PulseChannel *ch) {
+    if (ch->envelope_start) {
+        ch->envelope_counter = 15;
+        ch->envelope_divider = ch->volume;
+        ch->envelope_start = 0;
+    } else {
+        if (ch->envelope_divider == 0) {
+            if (ch->envelope_counter > 0) {
+                ch->envelope_counter--;
+            } else if (ch->env_loop) {
                 ch->envelope_counter = 15;
-                ch->envelope_divider = ch->volume;
-                ch->envelope_start = 0;
-            } else {
-                if (ch->envelope_divider == 0) {
-                    if (ch->envelope_counter > 0) {
-                        ch->envelope_counter--;
-                    } else if (ch->env_loop) {
-                        ch->envelope_counter = 15;
-                    }
-                    ch->envelope_divider = ch->volume;
-                } else {
-                    ch->envelope_divider--;
-                }
             }
+            ch->envelope_divider = ch->volume;
+        } else {
+            ch->envelope_divider--;
         }
     }
+}
 
-    // length counter (run at half-frame)
-    if (half_frame) {
-        if (!ch->env_loop && ch->length_counter > 0) {
-            ch->length_counter = (ch->length_counter - 2 >= 0) ? ch->length_counter - 2 : 0;
-        }
+// length counter and sweep unit (run at half-frame)
+void pulse_half_frame(PulseChannel *ch) {
+    if (!ch->env_loop && ch->length_counter > 0) {
+        ch->length_counter--;
     }
 
-    // sweep unit (run at half-frame)
-    if (half_frame) {
-        // loop twice (not sure why but it works)
-        for (int i = 0; i < 2; i++) {
-            if (ch->sweep_reload) {
-                ch->sweep_divider = ch->period;
-                ch->sweep_reload = 0;
-            } else if (ch->sweep_divider > 0) {
-                ch->sweep_divider--;
+    if (ch->sweep_reload) {
+        ch->sweep_divider = ch->period;
+        ch->sweep_reload = 0;
+    } else if (ch->sweep_divider > 0) {
+        ch->sweep_divider--;
+    } else {
+        ch->sweep_divider = ch->period;
+        if (ch->sweep_en && ch->shift > 0 && ch->timer > 7) {
+            uint16_t delta = ch->timer >> ch->shift;
+            if (ch->negate) {
+                ch->timer -= delta;
             } else {
-                ch->sweep_divider = ch->period;
-                if (ch->sweep_en && ch->shift > 0 && ch->timer > 7) {
-                    uint16_t delta = ch->timer >> ch->shift;
-                    if (ch->negate) {
-                        ch->timer -= delta;
-                    } else {
-                        ch->timer += delta;
-                    }
-                }
+                ch->timer += delta;
             }
         }
     }
+}
 
-    // calculate output
+// calculate output, the channel is quiet while its timer cannot change it
+void pulse_output(APU *apu, PulseChannel *ch) {
+    int enabled = (ch == &apu->pulse1) ? apu->pulse1_en : apu->pulse2_en;
     int duty = ch->duty & 0x03;
     int seq = ch->seq_pos & 0x07;
     int envelope = ch->constant_vol ? ch->volume : ch->envelope_counter;
-    double amplitude = (envelope / 15.0) * 8000.0;
-    if (nes->apu->pulse1_en && ch->length_counter > 0 && ch->timer > 7) {
-        ch->output = duty_patterns[duty][seq] ? amplitude : -amplitude;
+    if (enabled && ch->length_counter > 0 && ch->timer > 7) {
+        ch->output = duty_patterns[duty][seq] ? envelope : 0;
     } else {
         ch->output = 0;
     }
+    ch->quiet = !(enabled && ch->length_counter > 0 && ch->timer > 7 && envelope > 0);
 }
 
-void triangle_channel(TriangleChannel *ch, int quarter_frame, int half_frame) {
-    // timer and sequencer
-    if (ch->timer_counter == 0) {
-        ch->timer_counter = ch->timer + 1;
-        if (ch->linear_counter > 0 && ch->length_counter > 0) {
-            ch->seq_pos = (ch->seq_pos + 1) & 0x1F; // 32-step sequence
-        }
-    } else {
-        ch->timer_counter--;
+// ==================== Triangle ====================
+
+// Runs the timer expiries up to the given CPU cycle, each steps the sequencer while both counters
+// are non-zero. The triangle's timer is clocked by the CPU clock, expiries are timer + 1 CPU cycles
+// apart
+void triangle_timer(TriangleChannel *ch, uint64_t cycle) {
+    if (ch->next_clock > cycle) {
+        return;
     }
+    uint64_t period = (uint64_t)ch->timer + 1;
+    uint64_t count = 1 + (cycle - ch->next_clock) / period;
+    if (ch->linear_counter > 0 && ch->length_counter > 0) {
+        ch->seq_pos = (ch->seq_pos + count) & 0x1F; // 32-step sequence
+    }
+    ch->next_clock += count * period;
+}
 
-    // length counter (run at quarter-frame)
-    if (quarter_frame) {
-        if (ch->linear_reload) {
-            ch->linear_counter = ch->counter_value;
-        } else if (ch->linear_counter > 0) {
-            ch->linear_counter--;
-        }
-        // clear reload flag if control flag is clear
-        if (!ch->counter_halt) {
-            ch->linear_reload = 0;
-        }
+// linear counter (run at quarter-frame)
+void triangle_quarter_frame(TriangleChannel *ch) {
+    if (ch->linear_reload) {
+        ch->linear_counter = ch->counter_value;
+    } else if (ch->linear_counter > 0) {
+        ch->linear_counter--;
+    }
+    // clear reload flag if control flag is clear
+    if (!ch->counter_halt) {
+        ch->linear_reload = 0;
     }
+}
 
-    // length counter (run at half-frame)
-    if (half_frame) {
-        if (!ch->counter_halt && ch->length_counter > 0) {
-            ch->length_counter = (ch->length_counter - 2 >= 0) ? ch->length_counter - 2 : 0;
-        }
+// length counter (run at half-frame)
+void triangle_half_frame(TriangleChannel *ch) {
+    if (!ch->counter_halt && ch->length_counter > 0) {
+        ch->length_counter--;
     }
+}
 
-    // calculate output
-    if (nes->apu->triangle_en && ch->length_counter > 0 && ch->linear_counter > 0 && ch->timer > 7) {
-        ch->output = triangle_sequence[ch->seq_pos] * 256; // Scale to 16-bit range
+// calculate output, the channel is quiet while its timer cannot change it
+void triangle_output(APU *apu, TriangleChannel *ch) {
+    if (apu->triangle_en && ch->length_counter > 0 && ch->linear_counter > 0 && ch->timer > 7) {
+        ch->output = triangle_sequence[ch->seq_pos];
+        ch->quiet = 0;
     } else {
         ch->output = 0;
+        ch->quiet = 1;
     }
 }
 
-void noise_channel(NoiseChannel *ch, int quarter_frame, int half_frame) {
-    // timer
-    if (ch->timer_counter == 0) {
-        ch->timer_counter = ch->period + 1;
+// ==================== Noise ====================
 
-        // LFSR shift
-        uint16_t feedback;
-        if (ch->mode) {
-            feedback = ((ch->lfsr & 0x0001) ^ ((ch->lfsr >> 6) & 0x0001)) & 0x0001;
-        } else {
-            feedback = ((ch->lfsr & 0x0001) ^ ((ch->lfsr >> 1) & 0x0001)) & 0x0001;
-        }
+// Runs the timer expiries up to the given CPU cycle, each shifts the LFSR. Expiries are period CPU
+// cycles apart (noise_length is in CPU cycles). Without a length count the LFSR is not shifted at
+// all, only a write to 0x400F (which resets it) can make the channel audible again
+void noise_timer(NoiseChannel *ch, uint64_t cycle) {
+    if (ch->next_clock > cycle) {
+        return;
+    }
+    uint64_t period = ch->period;
+    uint64_t count = 1 + (cycle - ch->next_clock) / period;
+    ch->next_clock += count * period;
+    if (ch->length_counter == 0) {
+        return;
+    }
+
+    int tap = ch->mode ? 6 : 1;
+    for (uint64_t i = 0; i < count; i++) {
+        uint16_t feedback = ((ch->lfsr & 0x0001) ^ ((ch->lfsr >> tap) & 0x0001)) & 0x0001;
         ch->lfsr = (ch->lfsr >> 1) | (feedback << 14);
-    } else {
-        ch->timer_counter--;
     }
+}
 
-    // envelope (run at quarter frame)
-    if (quarter_frame) {
-        for (int i = 0; i < 2; i++) {
-            if (ch->envelope_start) {
+// envelope (run at quarter frame)
+void noise_quarter_frame(NoiseChannel *ch) {
+    if (ch->envelope_start) {
+        ch->envelope_counter = 15;
+        ch->envelope_divider = ch->volume;
+        ch->envelope_start = 0;
+    } else {
+        if (ch->envelope_divider == 0) {
+            if (ch->envelope_counter > 0) {
+                ch->envelope_counter--;
+            } else if (ch->env_loop) {
                 ch->envelope_counter = 15;
-                ch->envelope_divider = ch->volume;
-                ch->envelope_start = 0;
-            } else {
-                if (ch->envelope_divider == 0) {
-                    if (ch->envelope_counter > 0) {
-                        ch->envelope_counter--;
-                    } else if (ch->env_loop) {
-                        ch->envelope_counter = 15;
-                    }
-                    ch->envelope_divider = ch->volume;
-                } else {
-                    ch->envelope_divider--;
-                }
             }
+            ch->envelope_divider = ch->volume;
+        } else {
+            ch->envelope_divider--;
         }
     }
+}
 
-    // length counter (run at half-frame)
-    if (half_frame) {
-        if (!ch->env_loop && ch->length_counter > 0) {
-            ch->length_counter = (ch->length_counter - 2 >= 0) ? ch->length_counter - 2 : 0;
-        }
+// length counter (run at half-frame)
+void noise_half_frame(NoiseChannel *ch) {
+    if (!ch->env_loop && ch->length_counter > 0) {
+        ch->length_counter--;
     }
+}
 
-    // calculate output
+// calculate output, the channel is quiet while its timer cannot change it
+void noise_output(APU *apu, NoiseChannel *ch) {
     int envelope = ch->constant_vol ? ch->volume : ch->envelope_counter;
-    double amplitude = (envelope / 15.0) * 8000.0;
-    if (nes->apu->noise_en && ch->length_counter > 0 && (ch->lfsr & 0x0001) == 0) {
-        ch->output = amplitude;
+    if (apu->noise_en && ch->length_counter > 0 && (ch->lfsr & 0x0001) == 0) {
+        ch->output = envelope;
     } else {
         ch->output = 0;
-    }   
+    }
+    ch->quiet = !(apu->noise_en && ch->length_counter > 0 && envelope > 0);
+}
+
+// ==================== DMC ====================
+
+// Runs the timer expiries up to the given CPU cycle, each plays one bit of the shift register by
+// moving the level up or down by 2. After 8 bits the output unit takes the sample buffer, and the
+// buffer is refilled right away. A quiet channel (silenced, buffer empty) only counts its bits
+void dmc_timer(APU *apu, DMCChannel *ch, uint64_t cycle) {
+    if (ch->next_clock > cycle) {
+        return;
+    }
+    if (ch->quiet) {
+        uint64_t count = 1 + (cycle - ch->next_clock) / ch->rate;
+        ch->bits_remaining = 8 - (uint8_t)((8 - ch->bits_remaining + count) % 8);
+        ch->next_clock += count * ch->rate;
+        return;
+    }
+
+    ch->next_clock += ch->rate;
+    if (!ch->silence) {
+        if (ch->shift & 0x01) {
+            if (ch->output <= 125) {
+                ch->output += 2;
+            }
+        } else if (ch->output >= 2) {
+            ch->output -= 2;
+        }
+    }
+    ch->shift >>= 1;
+
+    if (--ch->bits_remaining == 0) {
+        ch->bits_remaining = 8;
+        ch->silence = !ch->buffer_full;
+        if (ch->buffer_full) {
+            ch->shift = ch->buffer;
+            ch->buffer_full = 0;
+            if (ch->bytes_remaining > 0) {
+                dmc_fetch(apu, ch);
+            }
+        }
+    }
+}
+
+// Reads the next sample byte into the buffer through the CPU memory map. The CPU is halted while
+// the DMA has the bus, so the stall is charged to the master clock
+void dmc_fetch(APU *apu, DMCChannel *ch) {
+    ch->buffer = nes_cpu_read(apu->nes, ch->address);
+    ch->buffer_full = 1;
+    ch->quiet = 0;
+    apu->nes->cycles += DMC_FETCH_STALL;
+
+    ch->address = (ch->address == 0xFFFF) ? 0x8000 : ch->address + 1;
+    if (--ch->bytes_remaining == 0) {
+        if (ch->loop) {
+            dmc_restart(ch);
+        } else if (ch->irq_en) {
+            ch->irq_flag = 1;
+            apu_update_irq(apu);
+        }
+    }
+}
+
+// starts playing the sample from the beginning
+void dmc_restart(DMCChannel *ch) {
+    ch->address = ch->sample_addr;
+    ch->bytes_remaining = ch->sample_length;
+}
+
+// the output is the level itself, the channel is quiet while its timer cannot change it
+void dmc_output(DMCChannel *ch) {
+    ch->quiet = ch->silence && !ch->buffer_full;
 }
 
 uint8_t apu_register_read(APU *apu, uint16_t reg) {
@@ -317,7 +669,13 @@ uint8_t apu_register_read(APU *apu, uint16_t reg) {
             status |= (apu->pulse2_en & 0x01) << 1;
             status |= (apu->triangle_en & 0x01) << 2;
             status |= (apu->noise_en & 0x01) << 3;
-            status |= (apu->DMC_en & 0x01) << 4;
+            status |= (apu->dmc.bytes_remaining > 0) << 4;
+            status |= (apu->frame_irq & 0x01) << 6;
+            status |= (apu->dmc.irq_flag & 0x01) << 7;
+
+            // reading acknowledges the frame interrupt
+            apu->frame_irq = 0;
+            apu_update_irq(apu);
             return status;
         }
         default:
@@ -354,7 +712,7 @@ void apu_register_write(APU *apu, uint16_t reg, uint8_t value) {
             apu->pulse1.length_counter = pulse_length[(value >> 3) & 0x1F];
             apu->pulse1.seq_pos = 0;
             apu->pulse1.envelope_start = 1;
-            apu->pulse1.timer_counter = apu->pulse1.timer + 1;
+            apu->pulse1.next_clock = apu_timer_reload(apu, 2 * ((uint64_t)apu->pulse1.timer + 1));
             break;
         }
 
@@ -385,7 +743,7 @@ void apu_register_write(APU *apu, uint16_t reg, uint8_t value) {
             apu->pulse2.length_counter = pulse_length[(value >> 3) & 0x1F];
             apu->pulse2.seq_pos = 0;
             apu->pulse2.envelope_start = 1;
-            apu->pulse2.timer_counter = apu->pulse2.timer + 1;
+            apu->pulse2.next_clock = apu_timer_reload(apu, 2 * ((uint64_t)apu->pulse2.timer + 1));
             break;
         }
 
@@ -428,7 +786,32 @@ void apu_register_write(APU *apu, uint16_t reg, uint8_t value) {
             apu->noise.length_counter = pulse_length[(value >> 3) & 0x1F]; 
             apu->noise.envelope_start = 1; 
             apu->noise.lfsr = 1; 
-            apu->noise.timer_counter = apu->noise.period + 1; 
+            apu->noise.next_clock = apu_timer_reload(apu, apu->noise.period);
+            break;
+        }
+
+        // ======= DMC =======
+
+        case 0x4010: {
+            apu->dmc.irq_en = (value >> 7) & 0x01;
+            apu->dmc.loop = (value >> 6) & 0x01;
+            apu->dmc.rate = dmc_rate[value & 0x0F]; // takes effect at the next expiry
+            if (!apu->dmc.irq_en) {
+                apu->dmc.irq_flag = 0;
+                apu_update_irq(apu);
+            }
+            break;
+        }
+        case 0x4011: {
+            apu->dmc.output = value & 0x7F; // direct load
+            break;
+        }
+        case 0x4012: {
+            apu->dmc.sample_addr = 0xC000 + value * 64;
+            break;
+        }
+        case 0x4013: {
+            apu->dmc.sample_length = value * 16 + 1;
             break;
         }
 
@@ -446,23 +829,48 @@ void apu_register_write(APU *apu, uint16_t reg, uint8_t value) {
             if (!apu->pulse2_en) apu->pulse2.length_counter = 0;
             if (!apu->triangle_en) apu->triangle.length_counter = 0;
             if (!apu->noise_en) apu->noise.length_counter = 0;
+
+            // the DMC stops once its sample ends, or (re)starts it, and fetches the first byte
+            // right away if the buffer is empty
+            apu->dmc.irq_flag = 0;
+            apu_update_irq(apu);
+            if (!apu->DMC_en) {
+                apu->dmc.bytes_remaining = 0;
+            } else if (apu->dmc.bytes_remaining == 0) {
+                dmc_restart(&apu->dmc);
+                if (!apu->dmc.buffer_full) {
+                    dmc_fetch(apu, &apu->dmc);
+                }
+            }
             break;
         }
         case 0x4017: {
             apu->mode = (value >> 7) & 0x01;
             apu->IRQ_inhibit = (value >> 6) & 0x01;
             if (apu->IRQ_inhibit) {
-                // clear IRQ flag
-                // TODO: implement IRQ flag clearing logic
+                apu->frame_irq = 0;
+                apu_update_irq(apu);
+            }
+
+            // the sequence restarts 3 or 4 CPU cycles later, depending on whether the write
+            // falls on an APU cycle. The 5-step sequence also clocks everything once at the
+            // write (not when it restarts, close enough to be inaudible)
+            apu->frame_start = apu->cycles + ((apu->cycles & 1) ? 4 : 3);
+            apu->frame_step = 0;
+            if (apu->mode) {
+                apu_quarter_frame(apu);
+                apu_half_frame(apu);
             }
             break;
         }
         default:
             break;
     }
+
+    // the new state shows up on the next APU cycle
+    apu_schedule_update(apu);
 }
 
 void apu_free(APU *apu) {
-    SDL_CloseAudioDevice(apu->audio_dev);
     free(apu);
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/audio.h"
+#include "../include/log.h"
+
+void audio_callback(void *userdata, Uint8 *stream, int len);
+
+AUDIO *audio_init(NES *nes) {
+    printf("Initializing Audio Device...");
+
+    AUDIO *audio = (AUDIO *)malloc(sizeof(AUDIO));
+    if (!audio) {
+        printf("\tFAILED\n");
+        FATAL_ERROR("AUDIO", "AUDIO memory allocation failed");
+    }
+    audio->nes = nes;
+
+    // initialize SDL audio
+    if (SDL_Init(SDL_INIT_AUDIO) < 0) {
+        printf("\tFAILED\n");
+        FATAL_ERROR("AUDIO", "Failed to initialize SDL audio: %s", SDL_GetError());
+    }
+
+    SDL_AudioSpec want, have;
+    SDL_zero(want);
+    want.freq = AUDIO_SAMPLE_RATE; // sample rate
+    want.format = AUDIO_S16SYS; // 16-bit signed audio
+    want.channels = 1; 
+    want.samples = 1024; // buffer size
+    want.callback = audio_callback;
+    want.userdata = audio;
+
+    audio->audio_dev = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+    if (!audio->audio_dev) {
+        printf("\tFAILED\n");
+        FATAL_ERROR("AUDIO", "Failed to open audio device: %s", SDL_GetError());
+    }
+
+    SDL_PauseAudioDevice(audio->audio_dev, 0); // 0 = start playing
+
+    printf("\tDONE\n");
+    return audio;
+}
+
+void audio_free(AUDIO *audio) {
+    if (audio) {
+        SDL_CloseAudioDevice(audio->audio_dev);
+        free(audio);
+    }
+}
+
+void audio_callback(void *userdata, Uint8 *stream, int len) {
+    AUDIO *audio = (AUDIO *)userdata;
+    if (!audio || !audio->nes || len <= 0) {
+        memset(stream, 0, len);
+        return;
+    }
+
+    nes_read_audio(audio->nes, (int16_t *)stream, len / sizeof(int16_t));
+}
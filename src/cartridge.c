@@ -1,13 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include "../include/nes.h"
 #include "../include/cartridge.h"
 #include "../include/log.h"
+#include "../include/opcodes.h"
 
 void load_rom(Cartridge *cart);
 void save_prg_ram_to_file(Cartridge *cart);
+uint16_t decode_tile_row(uint8_t plane0, uint8_t plane1);
 
 Cartridge *cart_init(const char *rom_filename, const char *save_filename) {
     Cartridge *cart = (Cartridge *)malloc(sizeof(Cartridge));
@@ -22,8 +25,11 @@ Cartridge *cart_init(const char *rom_filename, const char *save_filename) {
 
     // memory from cartridge
     cart->prg_rom = NULL;
+    cart->prg_ops = NULL;
     cart->chr_rom = NULL;
+    cart->chr_tiles = NULL;
     cart->prg_ram = NULL;
+    cart->rom_refs = NULL;
 
     // memory sizes
     cart->prg_size = 0;
@@ -34,9 +40,50 @@ Cartridge *cart_init(const char *rom_filename, const char *save_filename) {
     cart->mapper_id = 0;
     cart->mirroring = 0;
     cart->battery = 0;
+    cart->chr_ram = 0;
 
     // Load ROM data
     load_rom(cart);
+    cart_decode_prg(cart);
+    cart_decode_chr(cart);
+
+    // first owner of the ROM data
+    cart->rom_refs = (int *)malloc(sizeof(int));
+    if (!cart->rom_refs) {
+        FATAL_ERROR("ROM Loader", "Failed to allocate ROM reference count");
+    }
+    *cart->rom_refs = 1;
+
+    return cart;
+}
+
+Cartridge *cart_share(const Cartridge *src) {
+    Cartridge *cart = (Cartridge *)malloc(sizeof(Cartridge));
+    if (cart == NULL) {
+        fprintf(stderr, " Memory allocation for Cartridge failed!\n");
+        exit(1);
+    }
+
+    // same ROM image and header info, but no save file (the battery RAM belongs to the source)
+    *cart = *src;
+    cart->rom_filename = strdup(src->rom_filename);
+    cart->save_filename = NULL;
+
+    // PRG ROM (and CHR ROM) are read-only, so they are shared
+    (*cart->rom_refs)++;
+
+    // RAM is per console
+    if (cart->chr_ram) {
+        cart->chr_rom = (uint8_t *)calloc(1, cart->chr_size);
+        if (!cart->chr_rom) {
+            FATAL_ERROR("ROM Loader", "Failed to allocate CHR RAM memory");
+        }
+        cart_decode_chr(cart);
+    }
+    cart->prg_ram = (uint8_t *)calloc(1, cart->prg_ram_size);
+    if (!cart->prg_ram) {
+        FATAL_ERROR("ROM Loader", "Failed to allocate PRG RAM memory");
+    }
 
     return cart;
 }
@@ -53,16 +100,97 @@ void cart_free(Cartridge *cart) {
         if (cart->save_filename) {
             free(cart->save_filename);
         }
-        if (cart->prg_rom) {
-            free(cart->prg_rom);
+        // ROM data is only freed by the last cartridge sharing it
+        int last_ref = (--(*cart->rom_refs) == 0);
+        if (last_ref) {
+            free(cart->rom_refs);
+            if (cart->prg_rom) {
+                free(cart->prg_rom);
+            }
+            free(cart->prg_ops);
         }
-        if (cart->chr_rom) {
+        if (cart->chr_rom && (cart->chr_ram || last_ref)) {
             free(cart->chr_rom);
+            free(cart->chr_tiles);
+        }
+        if (cart->prg_ram) {
+            free(cart->prg_ram);
         }
         free(cart);
     }
 }
 
+// allocates and fills the decoded instruction cache for the whole of prg_rom. Every byte is decoded
+// as if an instruction started there, so the CPU can look up any PC without checking first.
+// Operands are only cached when they are in the same 1KB page as the opcode, the next page
+// of the CPU address space can be mapped to any other bank
+void cart_decode_prg(Cartridge *cart) {
+    cart->prg_ops = (DecodedOp *)malloc(sizeof(DecodedOp) * cart->prg_size);
+    if (!cart->prg_ops) {
+        FATAL_ERROR("ROM Loader", "Failed to allocate PRG decode cache");
+    }
+
+    for (int addr = 0; addr < cart->prg_size; addr++) {
+        DecodedOp *op = &cart->prg_ops[addr];
+        op->opcode = cart->prg_rom[addr];
+        op->length = opcode_info[op->opcode].length;
+        op->operand = 0;
+
+        int page_offset = addr & (CPU_PAGE_SIZE - 1);
+        if (page_offset + op->length > CPU_PAGE_SIZE) {
+            op->length = 0;
+            continue;
+        }
+        if (op->length > 1) {
+            op->operand = cart->prg_rom[addr + 1];
+        }
+        if (op->length > 2) {
+            op->operand |= cart->prg_rom[addr + 2] << 8;
+        }
+    }
+}
+
+// allocates and fills the decoded tile row cache for the whole of chr_rom
+void cart_decode_chr(Cartridge *cart) {
+    cart->chr_tiles = (uint16_t *)malloc(sizeof(uint16_t) * (cart->chr_size / 2));
+    if (!cart->chr_tiles) {
+        FATAL_ERROR("ROM Loader", "Failed to allocate CHR tile cache");
+    }
+
+    // each 16 byte tile holds 8 rows of plane 0 followed by 8 rows of plane 1
+    for (int tile = 0; tile < cart->chr_size / 16; tile++) {
+        for (int row = 0; row < 8; row++) {
+            uint8_t plane0 = cart->chr_rom[tile * 16 + row];
+            uint8_t plane1 = cart->chr_rom[tile * 16 + row + 8];
+            cart->chr_tiles[tile * 8 + row] = decode_tile_row(plane0, plane1);
+        }
+    }
+}
+
+// writes CHR RAM and re-decodes the tile row that byte belongs to
+void cart_chr_write(Cartridge *cart, uint32_t addr, uint8_t value) {
+    cart->chr_rom[addr] = value;
+
+    uint32_t plane0_addr = addr & ~0x08;
+    cart->chr_tiles[(addr >> 4) * 8 + (addr & 0x07)] = decode_tile_row(cart->chr_rom[plane0_addr], cart->chr_rom[plane0_addr + 8]);
+}
+
+// interleaves the two bitplanes of a tile row into 2 bit pixels (plane 1 is the high bit)
+uint16_t decode_tile_row(uint8_t plane0, uint8_t plane1) {
+    uint16_t lo = plane0;
+    uint16_t hi = plane1;
+
+    // spread the 8 bits out to every other bit position
+    lo = (lo | (lo << 4)) & 0x0F0F;
+    lo = (lo | (lo << 2)) & 0x3333;
+    lo = (lo | (lo << 1)) & 0x5555;
+    hi = (hi | (hi << 4)) & 0x0F0F;
+    hi = (hi | (hi << 2)) & 0x3333;
+    hi = (hi | (hi << 1)) & 0x5555;
+
+    return lo | (hi << 1);
+}
+
 void load_rom(Cartridge *cart) {
     //////////////////////////////////////////////////////
     //                   iNES Format                    //
@@ -152,6 +280,7 @@ void load_rom(Cartridge *cart) {
     } else {
         // CHR RAM — allocate 8KB
         cart->chr_size = 8192;
+        cart->chr_ram = 1;
         cart->chr_rom = (uint8_t *)calloc(1, cart->chr_size);
         if (!cart->chr_rom) {
             fclose(rom);
@@ -1,20 +1,24 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "../include/nes.h"
 #include "../include/cpu.h"
 #include "../include/log.h"
-#include "../include/opcode_handlers.h"
+#include "../include/opcodes.h"
 
 // Addressing Modes
-uint16_t cpu_immediate(uint8_t opcode, const char *instruction, CPU *cpu);
-uint16_t cpu_zero_page(uint8_t opcode, const char *instruction, CPU *cpu);
-uint16_t cpu_zero_page_x(uint8_t opcode, const char *instruction, CPU *cpu);
-uint16_t cpu_zero_page_y(uint8_t opcode, const char *instruction, CPU *cpu);
-uint16_t cpu_absolute(uint8_t opcode, const char *instruction, CPU *cpu);
-uint16_t cpu_absolute_x(uint8_t opcode, const char *instruction, CPU *cpu);
-uint16_t cpu_absolute_y(uint8_t opcode, const char *instruction, CPU *cpu);
-uint16_t cpu_indirect_x(uint8_t opcode, const char *instruction, CPU *cpu);
-uint16_t cpu_indirect_y(uint8_t opcode, const char *instruction, CPU *cpu);
+uint16_t cpu_implied(CPU *cpu, uint16_t operand);
+uint16_t cpu_immediate(CPU *cpu, uint16_t operand);
+uint16_t cpu_zero_page(CPU *cpu, uint16_t operand);
+uint16_t cpu_zero_page_x(CPU *cpu, uint16_t operand);
+uint16_t cpu_zero_page_y(CPU *cpu, uint16_t operand);
+uint16_t cpu_absolute(CPU *cpu, uint16_t operand);
+uint16_t cpu_absolute_x(CPU *cpu, uint16_t operand);
+uint16_t cpu_absolute_y(CPU *cpu, uint16_t operand);
+uint16_t cpu_indirect_x(CPU *cpu, uint16_t operand);
+uint16_t cpu_indirect_y(CPU *cpu, uint16_t operand);
+uint16_t cpu_relative(CPU *cpu, uint16_t operand);
+uint16_t cpu_indirect(CPU *cpu, uint16_t operand);
 
 // Access
 void lda(uint16_t effective_addr, CPU *cpu);
@@ -23,16 +27,29 @@ void ldx(uint16_t effective_addr, CPU *cpu);
 void stx(uint16_t effective_addr, CPU *cpu);
 void ldy(uint16_t effective_addr, CPU *cpu);
 void sty(uint16_t effective_addr, CPU *cpu);
+// Transfer
+void tax(uint16_t effective_addr, CPU *cpu);
+void txa(uint16_t effective_addr, CPU *cpu);
+void tay(uint16_t effective_addr, CPU *cpu);
+void tya(uint16_t effective_addr, CPU *cpu);
 // Arithmetic
 void adc(uint16_t effective_addr, CPU *cpu);
 void sbc(uint16_t effective_addr, CPU *cpu);
 void inc(uint16_t effective_addr, CPU *cpu);
 void dec(uint16_t effective_addr, CPU *cpu);
+void inx(uint16_t effective_addr, CPU *cpu);
+void dex(uint16_t effective_addr, CPU *cpu);
+void iny(uint16_t effective_addr, CPU *cpu);
+void dey(uint16_t effective_addr, CPU *cpu);
 // Shift
 void lsr(uint16_t effective_addr, CPU *cpu);
 void asl(uint16_t effective_addr, CPU *cpu);
 void rol(uint16_t effective_addr, CPU *cpu);
 void ror(uint16_t effective_addr, CPU *cpu);
+void lsr_acc(uint16_t effective_addr, CPU *cpu);
+void asl_acc(uint16_t effective_addr, CPU *cpu);
+void rol_acc(uint16_t effective_addr, CPU *cpu);
+void ror_acc(uint16_t effective_addr, CPU *cpu);
 // Bitwise
 void and(uint16_t effective_addr, CPU *cpu);
 void ora(uint16_t effective_addr, CPU *cpu);
@@ -43,7 +60,36 @@ void cmp(uint16_t effective_addr, CPU *cpu);
 void cpx(uint16_t effective_addr, CPU *cpu);
 void cpy(uint16_t effective_addr, CPU *cpu);
 // Branch
-void branch(int condition, int8_t offset, CPU *cpu);
+void branch(int condition, uint16_t address, CPU *cpu);
+void bcc(uint16_t effective_addr, CPU *cpu);
+void bcs(uint16_t effective_addr, CPU *cpu);
+void beq(uint16_t effective_addr, CPU *cpu);
+void bmi(uint16_t effective_addr, CPU *cpu);
+void bne(uint16_t effective_addr, CPU *cpu);
+void bpl(uint16_t effective_addr, CPU *cpu);
+void bvc(uint16_t effective_addr, CPU *cpu);
+void bvs(uint16_t effective_addr, CPU *cpu);
+// Jump
+void jmp(uint16_t effective_addr, CPU *cpu);
+void jsr(uint16_t effective_addr, CPU *cpu);
+void rts(uint16_t effective_addr, CPU *cpu);
+void brk(uint16_t effective_addr, CPU *cpu);
+void rti(uint16_t effective_addr, CPU *cpu);
+// Stack
+void php(uint16_t effective_addr, CPU *cpu);
+void plp(uint16_t effective_addr, CPU *cpu);
+void pha(uint16_t effective_addr, CPU *cpu);
+void pla(uint16_t effective_addr, CPU *cpu);
+void tsx(uint16_t effective_addr, CPU *cpu);
+void txs(uint16_t effective_addr, CPU *cpu);
+// Flags
+void clc(uint16_t effective_addr, CPU *cpu);
+void sec(uint16_t effective_addr, CPU *cpu);
+void cld(uint16_t effective_addr, CPU *cpu);
+void sed(uint16_t effective_addr, CPU *cpu);
+void cli(uint16_t effective_addr, CPU *cpu);
+void sei(uint16_t effective_addr, CPU *cpu);
+void clv(uint16_t effective_addr, CPU *cpu);
 // Unofficial
 void slo(uint16_t effective_addr, CPU *cpu);
 void lax(uint16_t effective_addr, CPU *cpu);
@@ -53,22 +99,97 @@ void isc(uint16_t effective_addr, CPU *cpu);
 void rla(uint16_t effective_addr, CPU *cpu);
 void sre(uint16_t effective_addr, CPU *cpu);
 void rra(uint16_t effective_addr, CPU *cpu);
+void anc(uint16_t effective_addr, CPU *cpu);
+void alr(uint16_t effective_addr, CPU *cpu);
+void arr(uint16_t effective_addr, CPU *cpu);
+void xaa(uint16_t effective_addr, CPU *cpu);
+void axs(uint16_t effective_addr, CPU *cpu);
+void ahx(uint16_t effective_addr, CPU *cpu);
+void shx(uint16_t effective_addr, CPU *cpu);
+void shy(uint16_t effective_addr, CPU *cpu);
+void tas(uint16_t effective_addr, CPU *cpu);
+void las(uint16_t effective_addr, CPU *cpu);
 // Other
-void nop_implied(CPU *cpu, uint8_t opcode);
-void nop_immediate(CPU *cpu, uint8_t opcode);
-void nop_zero_page(CPU *cpu, uint8_t opcode);
-void nop_zero_page_x(CPU *cpu, uint8_t opcode);
-void nop_absolute(CPU *cpu, uint8_t opcode);
-void nop_absolute_x(CPU *cpu, uint8_t opcode);
-void invalid(CPU *cpu, uint8_t opcode);
+void nop(uint16_t effective_addr, CPU *cpu);
+void kil(uint16_t effective_addr, CPU *cpu);
 
 // Helper Functions
-void init_opcode_table();
-void update_zero_and_negative_flags(CPU* cpu, uint8_t value); 
+void update_zero_and_negative_flags(CPU* cpu, uint8_t value);
+int idle_loop_kind(CPU *cpu, uint16_t head, uint16_t tail);
+int idle_safe_opcode(uint8_t opcode);
+int code_byte(Mapper *mapper, int address);
+
+// Maps the addressing mode column of OPCODE_TABLE to its helper
+#define ADDR_FN_IMP cpu_implied
+#define ADDR_FN_IMM cpu_immediate
+#define ADDR_FN_ZP  cpu_zero_page
+#define ADDR_FN_ZPX cpu_zero_page_x
+#define ADDR_FN_ZPY cpu_zero_page_y
+#define ADDR_FN_ABS cpu_absolute
+#define ADDR_FN_ABX cpu_absolute_x
+#define ADDR_FN_ABY cpu_absolute_y
+#define ADDR_FN_IZX cpu_indirect_x
+#define ADDR_FN_IZY cpu_indirect_y
+#define ADDR_FN_REL cpu_relative
+#define ADDR_FN_IND cpu_indirect
+
+// Runs one instruction from its OPCODE_TABLE columns: resolve the operand address, run the
+// operation, then add the page-cross penalty if the descriptor has one
+#define EXECUTE_INSTRUCTION(op, mode, base_cycles, penalty) \
+    do { \
+        uint16_t effective_addr = ADDR_FN_##mode(cpu, operand); \
+        cpu->cycles = base_cycles; \
+        op(effective_addr, cpu); \
+        if (penalty) { \
+            cpu->cycles += cpu->page_crossed; \
+        } \
+    } while (0)
+
+// cpu_run dispatches through a table of label addresses (GCC/Clang labels-as-values) unless
+// built with CPU_SWITCH_DISPATCH, or by a compiler without them, where it falls back to a switch
+#if defined(__GNUC__) && !defined(CPU_SWITCH_DISPATCH)
+#define CPU_THREADED_DISPATCH
+#endif
+
+const OpcodeInfo opcode_info[256] = {
+#define X(opcode, name, op, mode, cycles, penalty) [opcode] = { #name, ADDR_##mode, ADDR_LENGTH_##mode, cycles, penalty },
+    OPCODE_TABLE(X)
+#undef X
+};
+
+// Fetches the instruction at PC and leaves PC at the next one. In PRG ROM pages the opcode and
+// operand come from the decoded instruction cache (cart->prg_ops, see cart_decode_prg), so
+// straight-line code runs without going through the bus. Everything else (RAM, PRG RAM and
+// operands that run into the next page) is read from the bus, so writes to code are always seen
+static inline uint8_t cpu_fetch(CPU *cpu, uint16_t *operand) {
+    NES *nes = cpu->nes;
+    uint16_t pc = cpu->PC;
+    DecodedOp *page = nes->mapper->cpu_decode_map[pc >> CPU_PAGE_SHIFT];
+    uint8_t opcode;
+
+    if (page && page[pc & (CPU_PAGE_SIZE - 1)].length) {
+        DecodedOp *op = &page[pc & (CPU_PAGE_SIZE - 1)];
+        opcode = op->opcode;
+        *operand = op->operand;
+        cpu->PC = pc + op->length;
+    } else {
+        opcode = nes_cpu_read(nes, pc);
+        int length = opcode_info[opcode].length;
+        *operand = 0;
+        if (length > 1) {
+            *operand = nes_cpu_read(nes, pc + 1);
+        }
+        if (length > 2) {
+            *operand |= nes_cpu_read(nes, pc + 2) << 8;
+        }
+        cpu->PC = pc + length;
+    }
 
-InstructionHandler opcode_table[256];
+    DEBUG_MSG_CPU("Executing instruction [%s]: %02X at 0x%04X", opcode_info[opcode].name, opcode, pc);
+    return opcode;
+}
 
-CPU *cpu_init() {
+CPU *cpu_init(NES *nes) {
     printf("Initializing CPU...");
 
     CPU *cpu = (CPU *)malloc(sizeof(CPU));
@@ -76,9 +197,10 @@ CPU *cpu_init() {
         printf("\tFAILED\n");
         FATAL_ERROR("CPU", "CPU memory allocation failed");
     }
+    cpu->nes = nes;
 
     // Make sure that reset vector is set 0xFFFC & 0xFFFD
-    if (nes_cpu_read(0xFFFC) == 0 && nes_cpu_read(0xFFFD) == 0) { 
+    if (nes_cpu_read(cpu->nes, 0xFFFC) == 0 && nes_cpu_read(cpu->nes, 0xFFFD) == 0) {
         printf("\tFAILED\n");
         FATAL_ERROR("CPU", "Reset vector at 0xFFFC and 0xFFFD not set");
     }
@@ -87,15 +209,20 @@ CPU *cpu_init() {
     cpu->A = 0;
     cpu->X = 0;
     cpu->Y = 0;
-    cpu->PC = nes_cpu_read(0xFFFC) | (nes_cpu_read(0xFFFD) << 8); // reset vector at 0xFFFC and 0xFFFD (little endian)
-    cpu->S = 0xFD; 
-    cpu->P = 0x24;
+    cpu->PC = nes_cpu_read(cpu->nes, 0xFFFC) | (nes_cpu_read(cpu->nes, 0xFFFD) << 8); // reset vector at 0xFFFC and 0xFFFD (little endian)
+    cpu->S = 0xFD;
+    cpu_set_status(cpu, 0x24);
 
     cpu->cycles = 0;
     cpu->page_crossed = 0;
     cpu->service_int = 0;
 
-    init_opcode_table();
+    cpu->idle_skip = 0;
+    cpu->idle_head = -1;
+    cpu->idle_tail = 0;
+    cpu->idle_kind = IDLE_LOOP_NONE;
+    cpu->idle_cycles = 0;
+    memset(cpu->idle_state, 0, sizeof(cpu->idle_state));
 
     printf("\tDONE\n");
     return cpu;
@@ -106,1387 +233,838 @@ void cpu_free(CPU *cpu) {
 }
 
 void cpu_run_cycle(CPU *cpu) {
-    // handle NMI interrupt
-    if (nes->ppu->nmi == 1 && cpu->service_int == 0) { 
-        cpu_nmi(cpu);
-        nes->ppu->nmi = 0; // reset NMI flag
-        return;
-    }
+    NES *nes = cpu->nes;
+    cpu->idle_skip = 0; // stepping runs every instruction
+
+    // an interrupt can only be waiting once the scheduler has something due (see nes_schedule)
+    if (nes->cycles >= nes->next_event && cpu->service_int == 0) {
+        // handle NMI interrupt
+        if (nes->ppu->nmi == 1) {
+            cpu_nmi(cpu);
+            nes->ppu->nmi = 0; // reset NMI flag
+            return;
+        }
 
-    // handle mapper IRQ interrupt 
-    if (nes->mapper->irq == 1 && cpu->service_int == 0) {
-        cpu_irq(cpu);
-        nes->mapper->irq = 0; // reset irq flag
-        return;
+        // handle mapper and APU IRQ interrupt (one IRQ line, masked by the I flag)
+        if ((nes->mapper->irq == 1 || nes->apu->irq == 1) && !(cpu->P & FLAG_INT)) {
+            cpu_irq(cpu);
+            nes->mapper->irq = 0; // reset irq flag (the APU holds its own until acknowledged)
+            return;
+        }
     }
 
-    // fetch next opcode
-    uint8_t opcode = nes_cpu_read(cpu->PC++);
+    // fetch next instruction
+    uint16_t operand;
+    uint8_t opcode = cpu_fetch(cpu, &operand);
 
-    cpu->cycles = 0;
     cpu->page_crossed = 0;
 
     // execute instruction
-    opcode_table[opcode](cpu, opcode);
-}
-
-void stack_push(CPU *cpu, uint8_t value) {
-    DEBUG_MSG_CPU("Pushing value 0x%02X to stack", value);
-    nes_cpu_write(STACK_BASE + cpu->S--, value);
-}
-
-uint8_t stack_pop(CPU *cpu) {
-    uint8_t value = nes_cpu_read(STACK_BASE + ++cpu->S);
-    DEBUG_MSG_CPU("Popping value 0x%02X from stack", value);
-    return value;
-}
-
-// ==================== Access ====================
-
-// ======== LDA ========
-
-// LDA #Immediate
-void handle_0xA9(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "LDA", cpu);
-    lda(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
-}
-
-// LDA Zero Page
-void handle_0xA5(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "LDA", cpu);
-    lda(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
+    switch (opcode) {
+#define X(opcode, name, op, mode, base_cycles, penalty) \
+        case opcode: EXECUTE_INSTRUCTION(op, mode, base_cycles, penalty); break;
+        OPCODE_TABLE(X)
+#undef X
+    }
 }
 
-// LDA Zero Page, X
-void handle_0xB5(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "LDA", cpu);
-    lda(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
+// Runs instructions back to back, advancing the master clock after each one exactly like
+// cpu_run_cycle + nes_tick would. The PPU, the end of the run, OAM DMA and interrupts are only
+// looked at once nes->cycles reaches nes->next_event. Returns 1 as soon as the PPU completes a
+// frame, 0 once nes->cycles reaches deadline or an OAM DMA was started (the caller runs it).
+int cpu_run(CPU *cpu, uint64_t deadline) {
+    NES *nes = cpu->nes;
+    PPU *ppu = nes->ppu;
+    Mapper *mapper = nes->mapper;
+    APU *apu = nes->apu;
+    uint8_t opcode;
+    uint16_t operand;
+
+#ifdef CPU_THREADED_DISPATCH
+    static const void *dispatch_table[256] = {
+#define X(opcode, name, op, mode, base_cycles, penalty) [opcode] = &&op_##opcode,
+        OPCODE_TABLE(X)
+#undef X
+    };
+
+    // every handler ends with its own copy of this, so each opcode gets its own
+    // indirect jump (and branch prediction history) to the next one
+#define NEXT_INSTRUCTION() \
+    do { \
+        nes->cycles += cpu->cycles; \
+        if (nes->cycles >= nes->next_event) { \
+            goto event; \
+        } \
+        opcode = cpu_fetch(cpu, &operand); \
+        cpu->page_crossed = 0; \
+        goto *dispatch_table[opcode]; \
+    } while (0)
+#else
+#define NEXT_INSTRUCTION() goto next
+#endif
+
+    // the deadline is one of the events the schedule covers
+    nes->deadline = deadline;
+    cpu->idle_skip = nes->idle_skip;
+    goto event;
+
+interrupt:
+    // same priority as cpu_run_cycle: NMI first, then mapper and APU IRQ
+    if (ppu->nmi == 1) {
+        cpu_nmi(cpu);
+        ppu->nmi = 0; // reset NMI flag
+    } else {
+        cpu_irq(cpu);
+        mapper->irq = 0; // reset irq flag (the APU holds its own until acknowledged)
+    }
+    goto next;
 
-// LDA Absolute
-void handle_0xAD(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "LDA", cpu);
-    lda(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
+next:
+    nes->cycles += cpu->cycles;
+    if (nes->cycles < nes->next_event) {
+        goto fetch;
+    }
 
-// LDA Absolute, X
-void handle_0xBD(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "LDA", cpu);
-    lda(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1; 
+event:
+    if (nes_run_events(nes)) {
+        return 1;
     }
-    return;
-}
- 
-// LDA Absolute, Y
-void handle_0xB9(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "LDA", cpu);
-    lda(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1; 
+    if (nes->cycles >= deadline || ppu->oam_dma_transfer) {
+        return 0;
     }
-    return;
-}
-       
-// LDA (Indirect, X)
-void handle_0xA1(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "LDA", cpu);
-    lda(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-       
-// LDA (Indirect), Y
-void handle_0xB1(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "LDA", cpu);
-    lda(effective_addr, cpu);
-    cpu->cycles = 5;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1; 
+    if ((ppu->nmi == 1 || ((mapper->irq == 1 || apu->irq == 1) && !(cpu->P & FLAG_INT)))
+        && cpu->service_int == 0) {
+        goto interrupt;
     }
-    return;
-}
-        
-// ======== STA ======== 
-
-// STA Zero Page
-void handle_0x85(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "STA", cpu);
-    sta(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-}
 
-// STA Zero Page, X
-void handle_0x95(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "STA", cpu);
-    sta(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
+fetch:
+    opcode = cpu_fetch(cpu, &operand);
+    cpu->page_crossed = 0;
 
-// STA Absolute
-void handle_0x8D(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "STA", cpu);
-    sta(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
-        
-// STA Absolute, X
-void handle_0x9D(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "STA", cpu);
-    sta(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
-}
-
-// STA Absolute, Y
-void handle_0x99(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "STA", cpu);
-    sta(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
-}
-       
-// STA (Indirect, X)
-void handle_0x81(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "STA", cpu);
-    sta(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-     
-// STA (Indirect), Y
-void handle_0x91(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "STA", cpu);
-    sta(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// ======== LDX ======== 
-
-// LDX #Immediate
-void handle_0xA2(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "LDX", cpu);
-    ldx(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
-}
-
-// LDX Zero Page
-void handle_0xA6(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "LDX", cpu);
-    ldx(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-}
-
-// LDX Zero Page, Y
-void handle_0xB6(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_y(opcode, "LDX", cpu);
-    ldx(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
-
-// LDX Absolute
-void handle_0xAE(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "LDX", cpu);
-    ldx(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
-
-// LDX Absolute, Y
-void handle_0xBE(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "LDX", cpu);
-    ldx(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
+#ifdef CPU_THREADED_DISPATCH
+    goto *dispatch_table[opcode];
+
+#define X(opcode, name, op, mode, base_cycles, penalty) \
+    op_##opcode: \
+        EXECUTE_INSTRUCTION(op, mode, base_cycles, penalty); \
+        NEXT_INSTRUCTION();
+    OPCODE_TABLE(X)
+#undef X
+#else
+    switch (opcode) {
+#define X(opcode, name, op, mode, base_cycles, penalty) \
+        case opcode: EXECUTE_INSTRUCTION(op, mode, base_cycles, penalty); NEXT_INSTRUCTION();
+        OPCODE_TABLE(X)
+#undef X
     }
-    return;
-}
-
-// ======== STX ======== 
+    goto next;
+#endif
 
-// STX Zero Page
-void handle_0x86(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "STX", cpu);
-    stx(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
+#undef NEXT_INSTRUCTION
 }
 
-// STX Zero Page, Y
-void handle_0x96(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_y(opcode, "STX", cpu);
-    stx(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
+void stack_push(CPU *cpu, uint8_t value) {
+    DEBUG_MSG_CPU("Pushing value 0x%02X to stack", value);
+    nes_cpu_write(cpu->nes, STACK_BASE + cpu->S--, value);
 }
 
-// STX Absolute
-void handle_0x8E(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "STX", cpu);
-    stx(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
+uint8_t stack_pop(CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, STACK_BASE + ++cpu->S);
+    DEBUG_MSG_CPU("Popping value 0x%02X from stack", value);
+    return value;
 }
 
-// ======== LDY ======== 
+// ======== Idle Loops ========
 
-// LDY #Immediate
-void handle_0xA0(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "LDY", cpu);
-    ldy(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
-}
+// Called by a branch or JMP that just went back from tail to head. A loop is analyzed when it
+// first closes (see idle_loop_kind). Every other branch, jump, call, return and interrupt
+// forgets it, so when it closes again with the same registers, nothing but its own body ran in
+// between. If the body only reads values that have not changed, every further iteration repeats
+// the last one exactly, and nes_idle_skip fast-forwards through as many of them as it can.
+void cpu_idle_check(CPU *cpu, uint16_t head, uint16_t tail) {
+    NES *nes = cpu->nes;
+    uint8_t state[5] = { cpu->A, cpu->X, cpu->Y, cpu_get_status(cpu), cpu->S };
 
-// LDY Zero Page
-void handle_0xA4(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "LDY", cpu);
-    ldy(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-}
+    if (cpu->idle_head != head || cpu->idle_tail != tail) {
+        cpu->idle_head = head;
+        cpu->idle_tail = tail;
+        cpu->idle_kind = idle_loop_kind(cpu, head, tail);
+    } else if (cpu->idle_kind == IDLE_LOOP_NONE) {
+        return;
+    } else if (memcmp(state, cpu->idle_state, sizeof(state)) == 0) {
+        nes_idle_skip(nes, nes->cycles - cpu->idle_cycles, cpu->idle_kind == IDLE_LOOP_STATUS);
+    }
 
-// LDY Zero Page, X
-void handle_0xB4(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "LDY", cpu);
-    ldy(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
+    cpu->idle_cycles = nes->cycles;
+    memcpy(cpu->idle_state, state, sizeof(state));
 }
-        
-// LDY Absolute
-void handle_0xAC(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "LDY", cpu);
-    ldy(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
-       
-// LDY Absolute, X
-void handle_0xBC(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "LDY", cpu);
-    ldy(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
+
+// Classifies the loop from head up to and including the branch or JMP at tail, which goes back
+// to head. Its instructions have to run straight through (other branches may only leave the
+// loop), must not write memory, use the stack or have other side effects, and may only read
+// memory the mapper maps directly (RAM, PRG RAM and ROM, which only CPU writes change) or
+// PPUSTATUS, at most once.
+int idle_loop_kind(CPU *cpu, uint16_t head, uint16_t tail) {
+    Mapper *mapper = cpu->nes->mapper;
+    int status_reads = 0;
+
+    if (tail - head > IDLE_LOOP_MAX_BYTES) {
+        return IDLE_LOOP_NONE;
     }
-    return;
-}
 
-// ======== STY ======== 
- 
-// STY Zero Page
-void handle_0x84(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "STY", cpu);
-    sty(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-}
+    int pc = head;
+    while (1) {
+        int opcode = code_byte(mapper, pc);
+        if (opcode < 0 || !idle_safe_opcode(opcode)) {
+            return IDLE_LOOP_NONE;
+        }
 
-// STY Zero Page, X
-void handle_0x94(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "STY", cpu);
-    sty(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
+        int mode = opcode_info[opcode].mode;
+        int length = opcode_info[opcode].length;
+        int low = code_byte(mapper, pc + 1);
+        int high = code_byte(mapper, pc + 2);
+        if ((length > 1 && low < 0) || (length > 2 && high < 0)) {
+            return IDLE_LOOP_NONE;
+        }
 
-// STY Absolute
-void handle_0x8C(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "STY", cpu);
-    sty(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
+        int target = -1;
+        if (mode == ADDR_REL) {
+            target = (pc + 2 + (int8_t)low) & 0xFFFF;
+        } else if (opcode == 0x4C) { // JMP absolute
+            target = low | (high << 8);
+        } else if (mode == ADDR_ABS) {
+            uint16_t address = low | (high << 8);
+            if ((address & 0xE007) == PPUSTATUS_REG) {
+                status_reads++;
+            } else if (!mapper->cpu_read_map[address >> CPU_PAGE_SHIFT]) {
+                return IDLE_LOOP_NONE; // I/O or mapper registers
+            }
+        }
 
-// ==================== Transfer ==================== 
+        if (pc == tail) {
+            if (target != head) {
+                return IDLE_LOOP_NONE;
+            }
+            break;
+        }
 
-// TAX Implied
-void handle_0xAA(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [TAX]: %02X", opcode);
-    DEBUG_MSG_CPU("Writing 0x%02X to register X", cpu->A);
-    cpu->X = cpu->A;
-    update_zero_and_negative_flags(cpu, cpu->X);
-    cpu->cycles = 2;
-    return;
-}
+        // before the tail, jumps always leave and branches may only leave
+        if (opcode == 0x4C || (target >= head && target <= tail)) {
+            return IDLE_LOOP_NONE;
+        }
 
-// TXA Implied
-void handle_0x8A(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [TXA]: %02X", opcode);
-    DEBUG_MSG_CPU("Writing 0x%02X to register A", cpu->X);
-    cpu->A = cpu->X;
-    update_zero_and_negative_flags(cpu, cpu->A);
-    cpu->cycles = 2;
-    return;
-}
+        pc += length;
+        if (pc > tail) {
+            return IDLE_LOOP_NONE; // tail is not on an instruction boundary
+        }
+    }
 
-// TAY Implied
-void handle_0xA8(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [TAY]: %02X", opcode);
-    DEBUG_MSG_CPU("Writing 0x%02X to register Y", cpu->A);
-    cpu->Y = cpu->A;
-    update_zero_and_negative_flags(cpu, cpu->Y);
-    cpu->cycles = 2;
-    return;
+    if (status_reads > 1) {
+        return IDLE_LOOP_NONE;
+    }
+    return status_reads ? IDLE_LOOP_STATUS : IDLE_LOOP_MEMORY;
+}
+
+// opcodes that only read memory and change nothing but registers and flags (implied,
+// immediate, zero page, absolute and relative addressing only)
+int idle_safe_opcode(uint8_t opcode) {
+    switch (opcode) {
+        case 0xA9: case 0xA5: case 0xAD: // LDA
+        case 0xA2: case 0xA6: case 0xAE: // LDX
+        case 0xA0: case 0xA4: case 0xAC: // LDY
+        case 0xC9: case 0xC5: case 0xCD: // CMP
+        case 0xE0: case 0xE4: case 0xEC: // CPX
+        case 0xC0: case 0xC4: case 0xCC: // CPY
+        case 0x24: case 0x2C:            // BIT
+        case 0x29: case 0x25: case 0x2D: // AND
+        case 0x09: case 0x05: case 0x0D: // ORA
+        case 0x49: case 0x45: case 0x4D: // EOR
+        case 0x69: case 0x65: case 0x6D: // ADC
+        case 0xE9: case 0xE5: case 0xED: // SBC
+        case 0x0A: case 0x4A: case 0x2A: case 0x6A: // ASL, LSR, ROL, ROR (accumulator)
+        case 0xAA: case 0xA8: case 0x8A: case 0x98: case 0xBA: case 0x9A: // transfers
+        case 0xE8: case 0xC8: case 0xCA: case 0x88: // INX, INY, DEX, DEY
+        case 0x18: case 0x38: case 0x58: case 0x78: case 0xB8: case 0xD8: case 0xF8: // flags
+        case 0x10: case 0x30: case 0x50: case 0x70: case 0x90: case 0xB0: case 0xD0: case 0xF0: // branches
+        case 0x4C: // JMP absolute
+        case 0xEA: // NOP
+            return 1;
+        default:
+            return 0;
+    }
 }
 
-// TYA Implied
-void handle_0x98(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [TYA]: %02X", opcode);
-    DEBUG_MSG_CPU("Writing 0x%02X to register A", cpu->Y);
-    cpu->A = cpu->Y;
-    update_zero_and_negative_flags(cpu, cpu->A);
-    cpu->cycles = 2;
-    return;
+// byte at address if the mapper maps its page directly, -1 otherwise
+int code_byte(Mapper *mapper, int address) {
+    uint8_t *page = mapper->cpu_read_map[(address & 0xFFFF) >> CPU_PAGE_SHIFT];
+    if (!page) {
+        return -1;
+    }
+    return page[address & (CPU_PAGE_SIZE - 1)];
 }
-    
-// ==================== Arithmetic ====================
 
-// ======== ADC ======== 
+// ======== Interrupts ======== 
 
-// ADC #Immediate
-void handle_0x69(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "ADC", cpu);
-    adc(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
-}
+void cpu_irq(CPU *cpu) { // HARDWARE interrupts 
+    if (!(cpu->P & FLAG_INT)) {        
+        DEBUG_MSG_CPU("Hardware Interrupt Triggered");
 
-// ADC Zero Page
-void handle_0x65(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "ADC", cpu);
-    adc(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-}
+        cpu->service_int = 1; // signal that the interrupt is being serviced
+        cpu->idle_head = -1; // the handler may change what a watched loop reads
 
-// ADC Zero Page, X
-void handle_0x75(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "ADC", cpu);
-    adc(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
+        // The return address is PC
+        uint16_t return_addr = cpu->PC;
 
-// ADC Absolute
-void handle_0x6D(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "ADC", cpu);
-    adc(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
+        // push PC to stack
+        stack_push(cpu, (return_addr >> 8) & 0xFF); // high byte
+        stack_push(cpu, return_addr & 0xFF);        // low byte
 
-// ADC Absolute, X
-void handle_0x7D(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "ADC", cpu);
-    adc(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
-}
+        uint8_t status = (cpu_get_status(cpu) & ~FLAG_BREAK) | FLAG_UNUSED;
+        stack_push(cpu, status);
 
-// ADC Absolute, Y
-void handle_0x79(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "ADC", cpu);
-    adc(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
-}
+        // Set Interrupt Disable flag
+        cpu->P |= FLAG_INT; 
 
-// ADC (Indirect, X)
-void handle_0x61(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "ADC", cpu);
-    adc(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
+        // Load new PC from IRQ vector at 0xFFFE/0xFFFF
+        uint8_t low = nes_cpu_read(cpu->nes, 0xFFFE);
+        uint8_t high = nes_cpu_read(cpu->nes, 0xFFFF);
+        cpu->PC = (high << 8) | low;
 
-// ADC (Indirect), Y
-void handle_0x71(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "ADC", cpu);
-    adc(effective_addr, cpu);
-    cpu->cycles = 5;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
+        // Set cycles
+        cpu->cycles = 7;
     }
-    return;
 }
 
-// ======== SBC ======== 
+void cpu_nmi(CPU *cpu) { // Non-Maskable Interrupt
+    DEBUG_MSG_CPU("NMI Triggered");
 
-// SBC #Immediate (Unofficial Opcode)
-void handle_0xEB(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "SBC", cpu);
-    sbc(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
-}
+    cpu->service_int = 1; // signal that the interrupt is being serviced
+    cpu->idle_head = -1; // the handler may change what a watched loop reads
+    
+    // The return address is PC
+    uint16_t return_addr = cpu->PC;
 
-// SBC #Immediate
-void handle_0xE9(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "SBC", cpu);
-    sbc(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
-}
+    // push PC to stack
+    stack_push(cpu, (return_addr >> 8) & 0xFF); // high byte
+    stack_push(cpu, return_addr & 0xFF);        // low byte
 
-// SBC Zero Page
-void handle_0xE5(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "SBC", cpu);
-    sbc(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-}
+    uint8_t status = (cpu_get_status(cpu) & ~FLAG_BREAK) | FLAG_UNUSED;
+    stack_push(cpu, status);
 
-// SBC Zero Page, X
-void handle_0xF5(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "SBC", cpu);
-    sbc(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
+    // Set Interrupt Disable flag
+    cpu->P |= FLAG_INT; 
 
-// SBC Absolute
-void handle_0xED(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "SBC", cpu);
-    sbc(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
+    // Load new PC from IRQ vector at 0xFFFA/0xFFFB
+    uint8_t low = nes_cpu_read(cpu->nes, 0xFFFA);
+    uint8_t high = nes_cpu_read(cpu->nes, 0xFFFB);
+    cpu->PC = (high << 8) | low;
 
-// SBC Absolute, X
-void handle_0xFD(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "SBC", cpu);
-    sbc(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
+    // Set cycles
+    cpu->cycles = 8;
 }
 
-// SBC Absolute, Y
-void handle_0xF9(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "SBC", cpu);
-    sbc(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
-}
+// ======================= Instructions =======================
 
-// SBC (Indirect, X)
-void handle_0xE1(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "SBC", cpu);
-    sbc(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
+void lda(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr); 
+    DEBUG_MSG_CPU("Writing 0x%02X to register A", value);
+    cpu->A = value;
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// SBC (Indirect), Y
-void handle_0xF1(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "SBC", cpu);
-    sbc(effective_addr, cpu);
-    cpu->cycles = 5;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
+void sta(uint16_t effective_addr, CPU *cpu) {
+    nes_cpu_write(cpu->nes, effective_addr, cpu->A);
 }
 
-// ======== INC ======== 
-
-// INC Zero Page
-void handle_0xE6(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "INC", cpu);
-    inc(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
+void ldx(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr); 
+    DEBUG_MSG_CPU("Writing 0x%02X to register X", value);
+    cpu->X = value;
+    update_zero_and_negative_flags(cpu, cpu->X);
 }
 
-// INC Zero Page, X
-void handle_0xF6(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "INC", cpu);
-    inc(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
+void stx(uint16_t effective_addr, CPU *cpu) {
+    nes_cpu_write(cpu->nes, effective_addr, cpu->X);
 }
 
-// INC Absolute
-void handle_0xEE(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "INC", cpu);
-    inc(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
+void ldy(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr); 
+    DEBUG_MSG_CPU("Writing 0x%02X to register Y", value);
+    cpu->Y = value;
+    update_zero_and_negative_flags(cpu, cpu->Y);
 }
 
-// INC Absolute, X
-void handle_0xFE(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "INC", cpu);
-    inc(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
+void sty(uint16_t effective_addr, CPU *cpu) {
+    nes_cpu_write(cpu->nes, effective_addr, cpu->Y);
 }
 
-// ======== DEC ======== 
+void adc(uint16_t effective_addr, CPU *cpu) {
+    uint8_t operand = nes_cpu_read(cpu->nes, effective_addr);
+    uint8_t carry_in = (cpu->P & FLAG_CARRY) ? 1 : 0;
+    uint16_t result = cpu->A + operand + carry_in;
 
-// DEC Zero Page
-void handle_0xC6(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "DEC", cpu);
-    dec(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
-}
+    cpu->P = (result > 0xFF) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    cpu->P = (((cpu->A ^ result) & (operand ^ result) & 0x80) != 0) ? (cpu->P | FLAG_OVERFLOW) : (cpu->P & ~FLAG_OVERFLOW);
 
-// DEC Zero Page, X
-void handle_0xD6(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "DEC", cpu);
-    dec(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
+    cpu->A = (uint8_t) result;
 
-// DEC Absolute
-void handle_0xCE(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "DEC", cpu);
-    dec(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// DEC Absolute, X
-void handle_0xDE(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "DEC", cpu);
-    dec(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
+void sbc(uint16_t effective_addr, CPU *cpu) {
+    uint8_t operand = nes_cpu_read(cpu->nes, effective_addr);
 
-// ======== INX ======== 
+    uint8_t carry_in = (cpu->P & FLAG_CARRY) ? 1 : 0;
+    uint16_t result = cpu->A + ~operand + carry_in;
 
-// INX (Increment X)
-void handle_0xE8(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [INX]: %02X", opcode);
-    DEBUG_MSG_CPU("Incrementing register X by 0x01");
-    cpu->X += 0x01; // increment X by 1, does not modify carry or overflow
-    update_zero_and_negative_flags(cpu, cpu->X);
-    cpu->cycles = 2;
-    return;
-}
+    cpu->P = (result <= 0xFF) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    cpu->P = (((cpu->A ^ operand) & (cpu->A ^ result) & 0x80) != 0) ? (cpu->P | FLAG_OVERFLOW) : (cpu->P & ~FLAG_OVERFLOW);
 
-// ======== DEX ======== 
+    cpu->A = (uint8_t) result;
 
-// DEX (Decrement X)
-void handle_0xCA(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [DEX]: %02X", opcode);
-    DEBUG_MSG_CPU("Decrementing register X by 0x01");
-    cpu->X -= 0x01; // decrement X by 1, does not modify carry or overflow
-    update_zero_and_negative_flags(cpu, cpu->X);
-    cpu->cycles = 2;
-    return;
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// ======== INY ======== 
-
-// INY (Increment Y)
-void handle_0xC8(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [INY]: %02X", opcode);
-    DEBUG_MSG_CPU("Incrementing register Y by 0x01");
-    cpu->Y += 0x01; // increment Y by 1, does not modify carry or overflow
-    update_zero_and_negative_flags(cpu, cpu->Y);
-    cpu->cycles = 2;
-    return;
+void inc(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+    // Increment value and write back to memory
+    value++; 
+    nes_cpu_write(cpu->nes, effective_addr, value);
+    update_zero_and_negative_flags(cpu, value);
 }
 
-// ======== DEY ======== 
-
-// DEY (Decrement Y)
-void handle_0x88(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [DEY]: %02X", opcode);
-    DEBUG_MSG_CPU("Decrementing register Y by 0x01");
-    cpu->Y -= 0x01; // decrement Y by 1, does not modify carry or overflow
-    update_zero_and_negative_flags(cpu, cpu->Y);
-    cpu->cycles = 2;
-    return;
+void dec(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+    // decrement value and write back to memory
+    value--;
+    nes_cpu_write(cpu->nes, effective_addr, value);
+    update_zero_and_negative_flags(cpu, value);
 }
 
-// ==================== Shift ====================
-
-// ======== LSR ======== 
-
-// LSR Accumulator
-void handle_0x4A(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [LSR Accumulator]: %02X", opcode);
+void lsr(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
 
     // Carry Flag
-    cpu->P = (cpu->A & 0x01) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    cpu->P = (value & 0x01) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
 
     // Logical Shift Right
-    cpu->A >>= 1;
-
-    // Set flags
-    cpu->P = (cpu->A == 0) ? (cpu->P | FLAG_ZERO) : (cpu->P & ~FLAG_ZERO);
-    cpu->P &= ~FLAG_NEGATIVE; // bit 8 is always cleared after shift
-
-    // Set cycles
-    cpu->cycles = 2;
-    return;
-}
-
-// LSR Zero Page
-void handle_0x46(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "LSR", cpu);
-    lsr(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
-}
-
-// LSR Zero Page, X
-void handle_0x56(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "LSR", cpu);
-    lsr(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
+    value >>= 1;
 
-// LSR Absolute
-void handle_0x4E(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "LSR", cpu);
-    lsr(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
+    nes_cpu_write(cpu->nes, effective_addr, value);
 
-// LSR Absolute, X
-void handle_0x5E(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "LSR", cpu);
-    lsr(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
+    // Set flags (bit 8 is always cleared after shift)
+    update_zero_and_negative_flags(cpu, value);
 }
 
-// ======== ASL ======== 
-
-// ASL Accumulator
-void handle_0x0A(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [ASL Accumulator]: %02X", opcode);
+void asl(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
 
     // Carry Flag
-    cpu->P = (cpu->A & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    cpu->P = (value & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
 
     // Arithmetic Shift Left
-    cpu->A <<= 1;
+    value <<= 1;
 
     // Set flags
-    update_zero_and_negative_flags(cpu, cpu->A);
+    update_zero_and_negative_flags(cpu, value);
 
-    // Set cycles
-    cpu->cycles = 2;
-    return;
+    // write back to memory
+    nes_cpu_write(cpu->nes, effective_addr, value);
 }
 
-// ASL Zero Page
-void handle_0x06(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "ASL", cpu);
-    asl(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
-}
+void rol(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
 
-// ASL Zero Page, X
-void handle_0x16(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "ASL", cpu);
-    asl(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
+    uint8_t old_carry = (cpu->P & FLAG_CARRY) ? 1 : 0;
+    cpu->P = (value & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
 
-// ASL Absolute
-void handle_0x0E(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "ASL", cpu);
-    asl(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
+    value = (value << 1) | old_carry;
 
-// ASL Absolute, X
-void handle_0x1E(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "ASL", cpu);
-    asl(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
+    nes_cpu_write(cpu->nes, effective_addr, value);
+
+    update_zero_and_negative_flags(cpu, value);
 }
 
-// ======== ROR ========
+void ror(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
 
-// ROR Accumulator
-void handle_0x6A(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [ROR Accumulator]: %02X", opcode);
-        
     uint8_t old_carry = (cpu->P & FLAG_CARRY) ? 1 : 0;
-    uint8_t new_carry = cpu->A & 0x01;
+    uint8_t new_carry = value & 0x01;
 
-    cpu->A >>= 1;
-    cpu->A |= (old_carry << 7);
+    value >>= 1;
+    value |= (old_carry << 7);
 
-    cpu->P = (new_carry) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    nes_cpu_write(cpu->nes, effective_addr, value);
 
-    update_zero_and_negative_flags(cpu, cpu->A);
+    cpu->P = (new_carry) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
 
-    cpu->cycles = 2;
-    return;
+    update_zero_and_negative_flags(cpu, value);
 }
 
-// ROR Zero Page
-void handle_0x66(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "ROR", cpu);
-    ror(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
+void and(uint16_t effective_addr, CPU *cpu) {
+    uint8_t operand = nes_cpu_read(cpu->nes, effective_addr);
+    uint8_t value = cpu->A & operand;
+    DEBUG_MSG_CPU("Writing 0x%02X to register A", value);
+    cpu->A = value;
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// ROR Zero Page, X    
-void handle_0x76(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "ROR", cpu);
-    ror(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
+void ora(uint16_t effective_addr, CPU *cpu) {
+    uint8_t operand = nes_cpu_read(cpu->nes, effective_addr);
+    uint8_t value = cpu->A | operand;
+    DEBUG_MSG_CPU("Writing 0x%02X to register A", value);
+    cpu->A = value;
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// ROR Absolute
-void handle_0x6E(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "ROR", cpu);
-    ror(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
+void eor(uint16_t effective_addr, CPU *cpu) {
+    uint8_t operand = nes_cpu_read(cpu->nes, effective_addr);
+    uint8_t value = cpu->A ^ operand;
+    DEBUG_MSG_CPU("Writing 0x%02X to register A", value);
+    cpu->A = value;
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// ROR Absolute, X
-void handle_0x7E(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "ROR", cpu);
-    ror(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
+void bit(uint16_t effective_addr, CPU *cpu) {
+    uint8_t operand = nes_cpu_read(cpu->nes, effective_addr);
 
-// ======== ROL ========
+    // Perform bitwise AND 
+    uint8_t result = cpu->A & operand;
 
-// ROL Accumulator
-void handle_0x2A(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [ROL Accumulator]: %02X", opcode);
+    // Set flags: Z from the result, but N from bit 7 of the operand
+    cpu->P = (operand & 0x40) ? (cpu->P | FLAG_OVERFLOW) : (cpu->P & ~FLAG_OVERFLOW);
+    cpu->nz = ((operand & 0x80) << 8) | result;
+}
 
-    // Save old carry to rotate in
-    uint8_t old_carry = (cpu->P & FLAG_CARRY) ? 1 : 0;
+void cmp(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+    uint8_t result = cpu->A - value;
 
-    // Update carry with bit 7 of A
-    cpu->P = (cpu->A & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    // Set flags
+    cpu->P = (cpu->A >= value) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    update_zero_and_negative_flags(cpu, result);
+}
 
-    // Rotate left: shift and bring in old carry
-    cpu->A = (cpu->A << 1) | old_carry;
+void cpx(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+    uint8_t result = cpu->X - value;
 
     // Set flags
-    update_zero_and_negative_flags(cpu, cpu->A);
+    cpu->P = (cpu->X >= value) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    update_zero_and_negative_flags(cpu, result);
+}
 
-    // Set cycles
-    cpu->cycles = 2;
-    return;
+void cpy(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+    uint8_t result = cpu->Y - value;
+
+    // Set flags
+    cpu->P = (cpu->Y >= value) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    update_zero_and_negative_flags(cpu, result);
 }
 
-// ROL Zero Page
-void handle_0x26(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "ROL", cpu);
-    rol(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
+void branch(int condition, uint16_t address, CPU *cpu) {
+    if (condition) { 
+        uint16_t tail = cpu->PC - 2; // address of the branch instruction
+        cpu->cycles++;
+        if ((cpu->PC & 0xFF00) != (address & 0xFF00)) { // page crossed
+            cpu->cycles++; 
+        }
+        DEBUG_MSG_CPU("Branching to 0x%04X", address);
+        cpu->PC = address;
+
+        // a backward branch closes a loop that may be idle, any other one leaves it
+        if (address > tail) {
+            cpu->idle_head = -1;
+        } else if (cpu->idle_skip) {
+            cpu_idle_check(cpu, address, tail);
+        }
+    }
 }
 
-// ROL Zero Page, X
-void handle_0x36(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "ROL", cpu);
-    rol(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
+void slo(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+
+    // Carry Flag
+    cpu->P = (value & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+
+    // Arithmetic Shift Left
+    value <<= 1;
+
+    nes_cpu_write(cpu->nes, effective_addr, value);
+
+    // OR result with A and store back in A
+    cpu->A |= value;
+
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// ROL Absolute
-void handle_0x2E(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "ROL", cpu);
-    rol(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
+void lax(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+    cpu->A = value;
+    cpu->X = value;
+    update_zero_and_negative_flags(cpu, value);
 }
 
-// ROL Absolute, X
-void handle_0x3E(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "ROL", cpu);
-    rol(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
+void sax(uint16_t effective_addr, CPU *cpu) {
+    // Store A & X into memory
+    uint8_t result = cpu->A & cpu->X;
+    nes_cpu_write(cpu->nes, effective_addr, result);
 }
 
-// ==================== Bitwise ====================
+void dcp(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+
+    value--; // Decrement memory
+    nes_cpu_write(cpu->nes, effective_addr, value);
+
+    // Perform CMP (A - value)
+    uint8_t result = cpu->A - value;
 
-// ======== AND ======== 
+    // Set Carry Flag if A >= M
+    cpu->P = (cpu->A >= value) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
 
-// AND #Immediate
-void handle_0x29(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "AND", cpu);
-    and(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
+    update_zero_and_negative_flags(cpu, result);
 }
 
-// AND Zero Page
-void handle_0x25(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "AND", cpu);
-    and(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
+void isc(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+        
+    value += 1; // Increment memory
+    nes_cpu_write(cpu->nes, effective_addr, value);
+
+    // Perform SBC with incremented value
+    uint8_t inverted = ~value;
+    uint16_t sum = cpu->A + inverted + (cpu->P & FLAG_CARRY ? 1 : 0);
+
+    // Set flags
+    cpu->P = (cpu->P & ~FLAG_OVERFLOW) |
+                (((cpu->A ^ sum) & (value ^ sum) & 0x80) ? FLAG_OVERFLOW : 0);
+    cpu->P = (cpu->P & ~FLAG_CARRY) |
+                ((sum > 0xFF) ? FLAG_CARRY : 0);
+
+    cpu->A = sum & 0xFF;
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// AND Zero Page, X
-void handle_0x35(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "AND", cpu);
-    and(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
+void rla(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+
+    // Rotate Left through Carry
+    uint8_t carry_in = (cpu->P & FLAG_CARRY) ? 1 : 0;
+    cpu->P = (value & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    value = (value << 1) | carry_in;
+
+    nes_cpu_write(cpu->nes, effective_addr, value);
+
+    // AND with accumulator
+    cpu->A &= value;
+
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// AND Absolute
-void handle_0x2D(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "AND", cpu);
-    and(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
+void sre(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+
+    // Carry Flag from bit 0 before shift
+    cpu->P = (value & 0x01) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+
+    // Logical Shift Right
+    value >>= 1;
+    nes_cpu_write(cpu->nes, effective_addr, value);
+
+    // EOR with accumulator
+    cpu->A ^= value;
+
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// AND Absolute, X
-void handle_0x3D(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "AND", cpu);
-    and(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
+void rra(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+        
+    // Rotate Right
+    uint8_t old_carry = (cpu->P & FLAG_CARRY) ? 0x80 : 0x00;
+    cpu->P = (value & 0x01) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    value = (value >> 1) | old_carry;
+
+    nes_cpu_write(cpu->nes, effective_addr, value);
+
+    // ADC logic
+    uint16_t sum = cpu->A + value + ((cpu->P & FLAG_CARRY) ? 1 : 0);
+    cpu->P = (cpu->P & ~FLAG_OVERFLOW) |
+                (((cpu->A ^ sum) & (value ^ sum) & 0x80) ? FLAG_OVERFLOW : 0);
+    cpu->P = (cpu->P & ~FLAG_CARRY) |
+                ((sum > 0xFF) ? FLAG_CARRY : 0);
+
+    cpu->A = sum & 0xFF;
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// AND Absolute, Y
-void handle_0x39(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "AND", cpu);
-    and(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
+// ==================== Transfer ====================
+
+void tax(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    DEBUG_MSG_CPU("Writing 0x%02X to register X", cpu->A);
+    cpu->X = cpu->A;
+    update_zero_and_negative_flags(cpu, cpu->X);
 }
 
-// AND (Indirect, X)
-void handle_0x21(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "AND", cpu);
-    and(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
+void txa(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    DEBUG_MSG_CPU("Writing 0x%02X to register A", cpu->X);
+    cpu->A = cpu->X;
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// AND (Indirect), Y
-void handle_0x31(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "AND", cpu);
-    and(effective_addr, cpu);
-    cpu->cycles = 5;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
+void tay(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    DEBUG_MSG_CPU("Writing 0x%02X to register Y", cpu->A);
+    cpu->Y = cpu->A;
+    update_zero_and_negative_flags(cpu, cpu->Y);
+}
+
+void tya(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    DEBUG_MSG_CPU("Writing 0x%02X to register A", cpu->Y);
+    cpu->A = cpu->Y;
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// ======== ORA ======== 
+// ==================== Increment / Decrement Registers ====================
 
-// ORA #Immedaite
-void handle_0x09(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "ORA", cpu);
-    ora(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
+void inx(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    cpu->X += 0x01; // increment X by 1, does not modify carry or overflow
+    update_zero_and_negative_flags(cpu, cpu->X);
 }
 
-// ORA Zero Page
-void handle_0x05(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "ORA", cpu);
-    ora(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
+void dex(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    cpu->X -= 0x01; // decrement X by 1, does not modify carry or overflow
+    update_zero_and_negative_flags(cpu, cpu->X);
 }
 
-// ORA Zero Page, X
-void handle_0x15(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "ORA", cpu);
-    ora(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
+void iny(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    cpu->Y += 0x01; // increment Y by 1, does not modify carry or overflow
+    update_zero_and_negative_flags(cpu, cpu->Y);
 }
 
-// ORA Absolute
-void handle_0x0D(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "ORA", cpu);
-    ora(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
+void dey(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    cpu->Y -= 0x01; // decrement Y by 1, does not modify carry or overflow
+    update_zero_and_negative_flags(cpu, cpu->Y);
 }
 
-// ORA Absolute, X
-void handle_0x1D(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "ORA", cpu);
-    ora(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
+// ==================== Shift Accumulator ====================
+
+void lsr_acc(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    // Carry Flag
+    cpu->P = (cpu->A & 0x01) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    // Logical Shift Right
+    cpu->A >>= 1;
+    // Set flags (bit 8 is always cleared after shift)
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// ORA Absolute, Y
-void handle_0x19(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "ORA", cpu);
-    ora(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
+void asl_acc(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    // Carry Flag
+    cpu->P = (cpu->A & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    // Arithmetic Shift Left
+    cpu->A <<= 1;
+    // Set flags
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// ORA (Indirect, X)
-void handle_0x01(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "ORA", cpu);
-    ora(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
+void ror_acc(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    uint8_t old_carry = (cpu->P & FLAG_CARRY) ? 1 : 0;
+    uint8_t new_carry = cpu->A & 0x01;
+    cpu->A >>= 1;
+    cpu->A |= (old_carry << 7);
+    cpu->P = (new_carry) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// ORA (Indirect), Y
-void handle_0x11(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "ORA", cpu);
-    ora(effective_addr, cpu);
-    cpu->cycles = 5;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
+void rol_acc(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    // Save old carry to rotate in
+    uint8_t old_carry = (cpu->P & FLAG_CARRY) ? 1 : 0;
+    // Update carry with bit 7 of A
+    cpu->P = (cpu->A & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    // Rotate left: shift and bring in old carry
+    cpu->A = (cpu->A << 1) | old_carry;
+    // Set flags
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// ======== EOR ======== 
+// ==================== Branch ====================
 
-// EOR #Immedaite
-void handle_0x49(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "EOR", cpu);
-    eor(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
+void bcc(uint16_t effective_addr, CPU *cpu) {
+    branch(!(cpu->P & FLAG_CARRY), effective_addr, cpu);
 }
 
-// EOR Zero Page
-void handle_0x45(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "EOR", cpu);
-    eor(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
+void bcs(uint16_t effective_addr, CPU *cpu) {
+    branch(cpu->P & FLAG_CARRY, effective_addr, cpu);
 }
 
-// EOR Zero Page, X
-void handle_0x55(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "EOR", cpu);
-    eor(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
+void beq(uint16_t effective_addr, CPU *cpu) {
+    branch(NZ_ZERO(cpu->nz), effective_addr, cpu);
 }
 
-// EOR Absolute
-void handle_0x4D(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "EOR", cpu);
-    eor(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
+void bmi(uint16_t effective_addr, CPU *cpu) {
+    branch(NZ_NEGATIVE(cpu->nz), effective_addr, cpu);
 }
 
-// EOR Absolute, X
-void handle_0x5D(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "EOR", cpu);
-    eor(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
+void bne(uint16_t effective_addr, CPU *cpu) {
+    branch(!NZ_ZERO(cpu->nz), effective_addr, cpu);
 }
 
-// EOR Absolute, Y
-void handle_0x59(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "EOR", cpu);
-    eor(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
+void bpl(uint16_t effective_addr, CPU *cpu) {
+    branch(!NZ_NEGATIVE(cpu->nz), effective_addr, cpu);
 }
 
-// EOR (Indirect, X)
-void handle_0x41(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "EOR", cpu);
-    eor(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
+void bvc(uint16_t effective_addr, CPU *cpu) {
+    branch(!(cpu->P & FLAG_OVERFLOW), effective_addr, cpu);
 }
 
-// EOR (Indirect), Y
-void handle_0x51(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "EOR", cpu);
-    eor(effective_addr, cpu);
-    cpu->cycles = 5;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
-}
-
-// ======== BIT ======== 
-
-// BIT Zero Page
-void handle_0x24(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "BIT", cpu);
-    bit(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-}
-
-// BIT Absolute
-void handle_0x2C(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "BIT", cpu);
-    bit(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}      
-
-// ==================== Compare ====================
-
-// ======== CMP ========
-
-// CMP #Immediate
-void handle_0xC9(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "CMP", cpu);
-    cmp(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
-}  
-
-// CMP Zero Page
-void handle_0xC5(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "CMP", cpu);
-    cmp(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-}  
-
-// CMP Zero Page, X
-void handle_0xD5(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "CMP", cpu);
-    cmp(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}  
-
-// CMP Absolute
-void handle_0xCD(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "CMP", cpu);
-    cmp(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}  
-
-// CMP Absolute, X
-void handle_0xDD(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "CMP", cpu);
-    cmp(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
-} 
-
-// CMP Absolute, Y
-void handle_0xD9(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "CMP", cpu);
-    cmp(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
-} 
-
-
-// CMP (Indirect, X)
-void handle_0xC1(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "CMP", cpu);
-    cmp(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}  
-
-// CMP (Indirect), Y
-void handle_0xD1(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "CMP", cpu);
-    cmp(effective_addr, cpu);
-    cpu->cycles = 5;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
-} 
-
-// ======== CPX ======== 
-
-// CPX #Immediate
-void handle_0xE0(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "CPX", cpu);
-    cpx(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
-}  
-
-// CPX Zero Page
-void handle_0xE4(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "CPX", cpu);
-    cpx(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-} 
-
-// CPX Absolute
-void handle_0xEC(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "CPX", cpu);
-    cpx(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-} 
-
-// ======== CPY ======== 
-
-// CPY #Immediate
-void handle_0xC0(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "CPY", cpu);
-    cpy(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
-} 
-
-// CPY Zero Page
-void handle_0xC4(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "CPY", cpu);
-    cpy(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-} 
-        
-// CPY Absolute
-void handle_0xCC(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "CPY", cpu);
-    cpy(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-} 
-       
-// ==================== Branch ====================
-
-// BCC (Branch if Carry Clear)
-void handle_0x90(CPU *cpu, uint8_t opcode) {
-    int8_t offset = (int8_t) nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [BCC Relative]: %02X %02X", opcode, (uint8_t) offset);
-    cpu->cycles = 2;
-    int contiditon = !(cpu->P & FLAG_CARRY);
-    branch(contiditon, offset, cpu);
-    return;
-}
-
-// BCS (Branch if Carry Set)
-void handle_0xB0(CPU *cpu, uint8_t opcode) {
-    int8_t offset = (int8_t) nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [BCS Relative]: %02X %02X", opcode, (uint8_t) offset);
-    cpu->cycles = 2;
-    int contiditon = cpu->P & FLAG_CARRY;
-    branch(contiditon, offset, cpu);
-    return;
-}
-
-// BEQ (Branch if Equal)
-void handle_0xF0(CPU *cpu, uint8_t opcode) {
-    int8_t offset = (int8_t) nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [BEQ Relative]: %02X %02X", opcode, (uint8_t) offset);
-    cpu->cycles = 2;
-    int contiditon = cpu->P & FLAG_ZERO;
-    branch(contiditon, offset, cpu);
-    return;
-}
-
-// BMI (Branch if Minus)
-void handle_0x30(CPU *cpu, uint8_t opcode) {
-    int8_t offset = (int8_t) nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [BMI Relative]: %02X %02X", opcode, (uint8_t) offset);
-    cpu->cycles = 2;
-    int contiditon = cpu->P & FLAG_NEGATIVE;
-    branch(contiditon, offset, cpu);
-    return;
-}
-
-// BNE (Branch if Not Equal)
-void handle_0xD0(CPU *cpu, uint8_t opcode) {
-    int8_t offset = (int8_t) nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [BNE Relative]: %02X %02X", opcode, (uint8_t) offset);
-    cpu->cycles = 2;
-    int contiditon = !(cpu->P & FLAG_ZERO);
-    branch(contiditon, offset, cpu);
-    return;
-}
-
-// BPL (Branch if Plus)
-void handle_0x10(CPU *cpu, uint8_t opcode) {
-    int8_t offset = (int8_t) nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [BPL Relative]: %02X %02X", opcode, (uint8_t) offset);
-    cpu->cycles = 2;
-    int contiditon = !(cpu->P & FLAG_NEGATIVE);
-    branch(contiditon, offset, cpu);
-    return;
-}
-
-// BVC (Branch if Overflow Clear)
-void handle_0x50(CPU *cpu, uint8_t opcode) {
-    int8_t offset = (int8_t) nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [BVC Relative]: %02X %02X", opcode, (uint8_t) offset);
-    cpu->cycles = 2;
-    int contiditon = !(cpu->P & FLAG_OVERFLOW);
-    branch(contiditon, offset, cpu);
-    return;
-}
-
-// BVS (Branch if Overflow Set)
-void handle_0x70(CPU *cpu, uint8_t opcode) {
-    int8_t offset = (int8_t) nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [BVS Relative]: %02X %02X", opcode, (uint8_t) offset);
-    cpu->cycles = 2;
-    int contiditon = cpu->P & FLAG_OVERFLOW;
-    branch(contiditon, offset, cpu);
-    return;
+void bvs(uint16_t effective_addr, CPU *cpu) {
+    branch(cpu->P & FLAG_OVERFLOW, effective_addr, cpu);
 }
 
 // ==================== Jump ====================
 
-// ======== JMP ======== 
-
-// JMP Absolute
-void handle_0x4C(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "JMP", cpu);
+void jmp(uint16_t effective_addr, CPU *cpu) {
+    uint16_t tail = cpu->PC - 3; // address of the jump instruction
     DEBUG_MSG_CPU("Jumping to address 0x%04X", effective_addr);
     cpu->PC = effective_addr;
-    cpu->cycles = 3;
-    return;
-}
-
-// JMP (Indirect)
-void handle_0x6C(CPU *cpu, uint8_t opcode) {
-    uint8_t low = nes_cpu_read(cpu->PC++);
-    uint8_t high = nes_cpu_read(cpu->PC++);
-    uint16_t ptr = (high << 8) | low;
 
-    // Emulate 6502 page boundary bug
-    uint8_t jump_low = nes_cpu_read(ptr);
-    uint8_t jump_high;
-    if ((ptr & 0x00FF) == 0x00FF) {
-        // Wrap around same page
-        jump_high = nes_cpu_read(ptr & 0xFF00);
-    } else {
-        jump_high = nes_cpu_read(ptr + 1);
+    // same as branches, a backward jump closes a loop that may be idle
+    if (effective_addr > tail) {
+        cpu->idle_head = -1;
+    } else if (cpu->idle_skip) {
+        cpu_idle_check(cpu, effective_addr, tail);
     }
-
-    cpu->PC = (jump_high << 8) | jump_low;
-
-    DEBUG_MSG_CPU("Executing instruction [JMP (Indirect)]: %02X %02X %02X", opcode, low, high);
-
-    // Set cycles
-    cpu->cycles = 5;
-    return;
 }
-        
-// ======== JSR ======== 
-
-// JSR (Jump to Subroutine)
-void handle_0x20(CPU *cpu, uint8_t opcode) {
-    uint8_t low = nes_cpu_read(cpu->PC++);
-    uint8_t high = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [JSR]: %02X %02X %02X", opcode, low, high);
-    uint16_t new_addr = (high << 8) | low;
 
+void jsr(uint16_t effective_addr, CPU *cpu) {
     uint16_t return_addr = cpu->PC - 1; // decrement PC because it is pointing at next instruction
+    cpu->idle_head = -1; // calls and returns leave any loop being watched
 
     // Push return address to stack
     stack_push(cpu, (return_addr >> 8) & 0xFF); // high byte
     stack_push(cpu, return_addr & 0xFF); // low byte
 
     // Jump to new address
-    DEBUG_MSG_CPU("Jumping to address 0x%04X", new_addr);
-    cpu->PC = new_addr;
-
-    // Set cycles
-    cpu->cycles = 6;
-    return;
+    DEBUG_MSG_CPU("Jumping to address 0x%04X", effective_addr);
+    cpu->PC = effective_addr;
 }
 
-// ======== RTS ======== 
-
-// RTS (Return from Subroutine)
-void handle_0x60(CPU *cpu, uint8_t opcode) {
-    DEBUG_MSG_CPU("Executing instruction [RTS]: %02X", opcode);
-
+void rts(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    cpu->idle_head = -1;
     // Pop address from top of the stack
     uint8_t low = stack_pop(cpu);
     uint8_t high = stack_pop(cpu);
@@ -1497,18 +1075,11 @@ void handle_0x60(CPU *cpu, uint8_t opcode) {
     // Set PC to address + 1
     DEBUG_MSG_CPU("Returning to address 0x%04X", return_addr + 1);
     cpu->PC = return_addr + 1;
-
-    // Set cycles
-    cpu->cycles = 6;
-    return;
 }
 
-// ======== BRK ======== 
-
-// BRK (Break)
-void handle_0x00(CPU *cpu, uint8_t opcode) {
-    DEBUG_MSG_CPU("Executing instruction [BRK]: %02X", opcode);
-
+void brk(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    cpu->idle_head = -1;
     cpu->service_int = 1; // set service flag to prevent other interrupts during BRK handling
 
     // The return address is PC + 2
@@ -1519,32 +1090,25 @@ void handle_0x00(CPU *cpu, uint8_t opcode) {
     stack_push(cpu, return_addr & 0xFF);        // low byte
 
     // Push status register with Break flag set
-    uint8_t status_with_B = cpu->P | FLAG_BREAK | FLAG_UNUSED; 
+    uint8_t status_with_B = cpu_get_status(cpu) | FLAG_BREAK | FLAG_UNUSED;
     stack_push(cpu, status_with_B);
 
     // Set Interrupt Disable flag
-    cpu->P |= FLAG_INT; 
+    cpu->P |= FLAG_INT;
 
     // Load new PC from IRQ vector at 0xFFFE/0xFFFF
-    uint8_t low = nes_cpu_read(0xFFFE);
-    uint8_t high = nes_cpu_read(0xFFFF);
+    uint8_t low = nes_cpu_read(cpu->nes, 0xFFFE);
+    uint8_t high = nes_cpu_read(cpu->nes, 0xFFFF);
     cpu->PC = (high << 8) | low;
-
-    // Set cycles
-    cpu->cycles = 7;
-    return;
 }
 
-// ======== RTI ======== 
-
-// RTI (Return from Interrupt)
-void handle_0x40(CPU *cpu, uint8_t opcode) {
-    DEBUG_MSG_CPU("Executing instruction [RTI]: %02X", opcode);
-
+void rti(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    cpu->idle_head = -1;
     // Pop status flag from stack
     uint8_t status = stack_pop(cpu);
     status |= FLAG_UNUSED;
-    cpu->P = status;
+    cpu_set_status(cpu, status);
 
     // Pop address from top of the stack
     uint8_t low = stack_pop(cpu);
@@ -1557,1243 +1121,223 @@ void handle_0x40(CPU *cpu, uint8_t opcode) {
     DEBUG_MSG_CPU("Returning to address 0x%04X", return_addr);
     cpu->PC = return_addr;
 
-    // Set cycles
-    cpu->cycles = 6;
-
     cpu->service_int = 0; // reset service flag
-    return;
+    cpu->nes->next_event = 0; // an interrupt that arrived during the handler is serviced next
 }
-        
-// ==================== Stack ====================
 
-// ======== PHP ======== 
+// ==================== Stack ====================
 
-// PHP (Push Processor Status)
-void handle_0x08(CPU *cpu, uint8_t opcode) {
-    DEBUG_MSG_CPU("Executing instruction [PHP]: %02X", opcode);
-    uint8_t status = cpu->P | FLAG_BREAK;
+void php(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    uint8_t status = cpu_get_status(cpu) | FLAG_BREAK;
     stack_push(cpu, status);
-    cpu->cycles = 3;
-    return;
 }
 
-// ======== PLP ======== 
-
-// PLP (Pull Processor Status)
-void handle_0x28(CPU *cpu, uint8_t opcode) {
-    DEBUG_MSG_CPU("Executing instruction [PLP]: %02X", opcode);
+void plp(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
     uint8_t value = stack_pop(cpu);
 
     value &= ~(1 << 4);     // Clear B flag
     value |= (1 << 5);      // Set unused bit to 1
-    cpu->P = value;
-
-    cpu->cycles = 4;
-    return;
+    cpu_set_status(cpu, value);
+    cpu->nes->next_event = 0; // an IRQ held while I was set is serviced next
 }
 
-// ======== PLA ======== 
+void pha(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
+    stack_push(cpu, cpu->A);
+}
 
-// Pull A
-void handle_0x68(CPU *cpu, uint8_t opcode) {
-    DEBUG_MSG_CPU("Executing instruction [PLA]: %02X", opcode);
+void pla(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
     cpu->A = stack_pop(cpu);
     update_zero_and_negative_flags(cpu, cpu->A);
-    cpu->cycles = 4;
-    return;
-}
-
-// ======== PHA ======== 
-
-// Push A
-void handle_0x48(CPU *cpu, uint8_t opcode) {
-    DEBUG_MSG_CPU("Executing instruction [PHA]: %02X", opcode);
-    stack_push(cpu, cpu->A);
-    cpu->cycles = 3;
-    return;
 }
 
-// TSX Implied
-void handle_0xBA(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [TSX]: %02X", opcode);
+void tsx(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
     DEBUG_MSG_CPU("Writing 0x%02X to register X", cpu->S);
     cpu->X = cpu->S;
     update_zero_and_negative_flags(cpu, cpu->X);
-    cpu->cycles = 2;
-    return;
 }
 
-// TXS Implied
-void handle_0x9A(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [TXS]: %02X", opcode);
+void txs(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
     DEBUG_MSG_CPU("Writing 0x%02X to register S", cpu->X);
     cpu->S = cpu->X;
-    cpu->cycles = 2;
-    return;
 }
 
 // ==================== Flags ====================
 
-// CLC (Clear Carry)
-void handle_0x18(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [CLC]: %02X", opcode);
+void clc(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
     cpu->P &= ~FLAG_CARRY;
-    cpu->cycles = 2;
-    return;
 }
 
-// SEC (Set Carry)
-void handle_0x38(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [SEC]: %02X", opcode);
+void sec(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
     cpu->P |= FLAG_CARRY;
-    cpu->cycles = 2;
-    return;
 }
 
-// CLD (Clear Decimal)
-void handle_0xD8(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [CLD]: %02X", opcode);
+void cld(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
     cpu->P &= ~FLAG_DECIMAL;
-    cpu->cycles = 2;
-    return;
 }
-        
-// SED (Set Decimal)
-void handle_0xF8(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [SED]: %02X", opcode);
+
+void sed(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
     cpu->P |= FLAG_DECIMAL;
-    cpu->cycles = 2;
-    return;
 }
 
-// CLI (Clear Interrupt Disable)
-void handle_0x58(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [CLI]: %02X", opcode);
+void cli(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
     cpu->P &= ~FLAG_INT;
-    cpu->cycles = 2;
-    return;
+    cpu->nes->next_event = 0; // an IRQ held while I was set is serviced next
 }
 
-// SEI (Set Interrupt Disable)
-void handle_0x78(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [SEI]: %02X", opcode);
+void sei(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
     cpu->P |= FLAG_INT;
-    cpu->cycles = 2;
-    return;
 }
 
-// CLV (Clear Overflow)
-void handle_0xB8(CPU *cpu, uint8_t opcode) {
-    (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [CLV]: %02X", opcode);
+void clv(uint16_t effective_addr, CPU *cpu) {
+    (void)effective_addr;
     cpu->P &= ~FLAG_OVERFLOW;
-    cpu->cycles = 2;
-    return;
-}
-
-// ==================== Unofficial Opcodes ==================== 
-
-// ======== SLO ======== 
-
-// SLO Zero Page
-void handle_0x07(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "SLO", cpu);
-    slo(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
-}
-
-// SLO Zero Page, X
-void handle_0x17(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "SLO", cpu);
-    slo(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
 }
 
-// SLO Absolute
-void handle_0x0F(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "SLO", cpu);
-    slo(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
+// ==================== Unofficial (Immediate) ====================
 
-// SLO Absolute, X
-void handle_0x1F(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "SLO", cpu);
-    slo(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
+void anc(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+    cpu->A &= value;
+    // Set Carry to bit 7 of result
+    cpu->P = (cpu->A & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// SLO Absolute, Y
-void handle_0x1B(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "SLO", cpu);
-    slo(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
+void alr(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+    cpu->A &= value;
+    // Set Carry to bit 0 before shift
+    cpu->P = (cpu->A & 0x01) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    // Logical Shift Right
+    cpu->A >>= 1;
+    update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-// SLO (Indirect, X)
-void handle_0x03(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "SLO", cpu);
-    slo(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-
-// SLO (Indirect), Y
-void handle_0x13(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "SLO", cpu);
-    slo(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-
-// ======== LAX ======== 
-
-// LAX Immediate (Highly Unstable)
-void handle_0xAB(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_immediate(opcode, "LAX", cpu);
-    lax(effective_addr, cpu);
-    cpu->cycles = 2;
-    return;
-}
-
-// LAX Zero Page
-void handle_0xA7(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "LAX", cpu);
-    lax(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-}
-       
-// LAX Zero Page, Y
-void handle_0xB7(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_y(opcode, "LAX", cpu);
-    lax(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
-
-// LAX Absolute
-void handle_0xAF(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "LAX", cpu);
-    lax(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
-
-// LAX Absolute, Y
-void handle_0xBF(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "LAX", cpu);
-    lax(effective_addr, cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
-}
-
-// LAX (Indirect, X)
-void handle_0xA3(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "LAX", cpu);
-    lax(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// LAX (Indirect), Y
-void handle_0xB3(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "LAX", cpu);
-    lax(effective_addr, cpu);
-    cpu->cycles = 5;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
-}
-
-// ======== SAX ======== 
-
-// SAX Zero Page
-void handle_0x87(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "SAX", cpu);
-    sax(effective_addr, cpu);
-    cpu->cycles = 3;
-    return;
-}
-
-// SAX Zero Page, Y
-void handle_0x97(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_y(opcode, "SAX", cpu);
-    sax(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
-
-// SAX Absolute
-void handle_0x8F(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "SAX", cpu);
-    sax(effective_addr, cpu);
-    cpu->cycles = 4;
-    return;
-}
-
-// SAX (Indirect, X)
-void handle_0x83(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "SAX", cpu);
-    sax(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// ======== DCP ======== 
-
-// DCP Zero Page
-void handle_0xC7(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "DCP", cpu);
-    dcp(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
-}
-
-// DCP Zero Page, X
-void handle_0xD7(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "DCP", cpu);
-    dcp(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// DCP Absolute
-void handle_0xCF(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "DCP", cpu);
-    dcp(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// DCP Absolute, X
-void handle_0xDF(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "DCP", cpu);
-    dcp(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
-
-// DCP Absolute, Y
-void handle_0xDB(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "DCP", cpu);
-    dcp(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
-
-// DCP (Indirect, X)
-void handle_0xC3(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "DCP", cpu);
-    dcp(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-
-// DCP (Indirect), Y
-void handle_0xD3(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "DCP", cpu);
-    dcp(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-
-// ======== ISC ======== 
-
-// ISC Zero Page
-void handle_0xE7(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "ISC", cpu);
-    isc(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
-}
-
-// ISC Zero Page, X
-void handle_0xF7(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "ISC", cpu);
-    isc(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// ISC Absolute
-void handle_0xEF(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "ISC", cpu);
-    isc(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// ISC Absolute, X
-void handle_0xFF(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "ISC", cpu);
-    isc(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
-
-// ISC Absolute, Y
-void handle_0xFB(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "ISC", cpu);
-    isc(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
-
-// ISC (Indirect, X)
-void handle_0xE3(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "ISC", cpu);
-    isc(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-
-// ISC (Indirect), Y
-void handle_0xF3(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "ISC", cpu);
-    isc(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-
-// ======== RLA ======== 
-
-// RLA Zero Page
-void handle_0x27(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "RLA", cpu);
-    rla(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
-}
-
-// RLA Zero Page, X
-void handle_0x37(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "RLA", cpu);
-    rla(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// RLA Absolute
-void handle_0x2F(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "RLA", cpu);
-    rla(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// RLA Absolute, X
-void handle_0x3F(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "RLA", cpu);
-    rla(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
-
-// RLA Absolute, Y
-void handle_0x3B(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "RLA", cpu);
-    rla(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
-
-// RLA (Indirect, X)
-void handle_0x23(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "RLA", cpu);
-    rla(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-
-// RLA (Indirect), Y
-void handle_0x33(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "RLA", cpu);
-    rla(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-
-// ======== SRE ======== 
-
-// SRE Zero Page
-void handle_0x47(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "SRE", cpu);
-    sre(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
-}
-
-// SRE Zero Page, X
-void handle_0x57(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "SRE", cpu);
-    sre(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// SRE Absolute
-void handle_0x4F(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "SRE", cpu);
-    sre(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// SRE Absolute, X
-void handle_0x5F(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "SRE", cpu);
-    sre(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
-
-// SRE Absolute, Y
-void handle_0x5B(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "SRE", cpu);
-    sre(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
-
-// SRE (Indirect, X)
-void handle_0x43(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "SRE", cpu);
-    sre(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-
-// SRE (Indirect), Y
-void handle_0x53(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "SRE", cpu);
-    sre(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-
-// ======== RRA ======== 
-
-// RRA Zero Page
-void handle_0x67(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page(opcode, "RRA", cpu);
-    rra(effective_addr, cpu);
-    cpu->cycles = 5;
-    return;
-}
-
-// RRA Zero Page, X
-void handle_0x77(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_zero_page_x(opcode, "RRA", cpu);
-    rra(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-        
-// RRA Absolute
-void handle_0x6F(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute(opcode, "RRA", cpu);
-    rra(effective_addr, cpu);
-    cpu->cycles = 6;
-    return;
-}
-
-// RRA Absolute, X
-void handle_0x7F(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "RRA", cpu);
-    rra(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
-
-// RRA Absolute, Y
-void handle_0x7B(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "RRA", cpu);
-    rra(effective_addr, cpu);
-    cpu->cycles = 7;
-    return;
-}
-    
-// RRA (Indirect, X)
-void handle_0x63(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_x(opcode, "RRA", cpu);
-    rra(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-
-// RRA (Indirect), Y
-void handle_0x73(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "RRA", cpu);
-    rra(effective_addr, cpu);
-    cpu->cycles = 8;
-    return;
-}
-        
-// ======== ANC ======== 
-
-void handle_0x0B(CPU *cpu, uint8_t opcode) {
-    uint8_t value = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [ANC]: %02X %02X", opcode, value);
-    cpu->A &= value;
-
-    // Set Carry to bit 7 of result
-    cpu->P = (cpu->A & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-    update_zero_and_negative_flags(cpu, cpu->A);
-
-    cpu->cycles = 2;
-    return;
-}
-
-void handle_0x2B(CPU *cpu, uint8_t opcode) {
-    uint8_t value = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [ANC]: %02X %02X", opcode, value);
-    cpu->A &= value;
-
-    // Set Carry to bit 7 of result
-    cpu->P = (cpu->A & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-    update_zero_and_negative_flags(cpu, cpu->A);
-
-    cpu->cycles = 2;
-    return;
-}
-        
-
-// ======== ALR ======== 
-
-void handle_0x4B(CPU *cpu, uint8_t opcode) {
-    uint8_t value = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [ALR]: %02X %02X", opcode, value);
-    cpu->A &= value;
-
-    // Set Carry to bit 0 before shift
-    cpu->P = (cpu->A & 0x01) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-
-    // Logical Shift Right
-    cpu->A >>= 1;
-
-    update_zero_and_negative_flags(cpu, cpu->A);
-    cpu->cycles = 2;
-    return;
-}
-
-// ======== ARR ======== 
-
-void handle_0x6B(CPU *cpu, uint8_t opcode) {
-    uint8_t value = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [ARR]: %02X %02X", opcode, value);
-    cpu->A &= value;
-
-    // Rotate Right through Carry
-    uint8_t carry = (cpu->P & FLAG_CARRY) ? 0x80 : 0x00;
-    uint8_t result = (cpu->A >> 1) | carry;
-    cpu->A = result;
-
-    // Set Carry to bit 6, Overflow from bits 6 and 5
-    cpu->P = (result & 0x40) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-    cpu->P = ((result ^ (result << 1)) & 0x40) ? (cpu->P | FLAG_OVERFLOW) : (cpu->P & ~FLAG_OVERFLOW);
-
-    update_zero_and_negative_flags(cpu, cpu->A);
-    cpu->cycles = 2;
-    return;
-}
-        
-// ======== XAA ======== 
-
-void handle_0x8B(CPU *cpu, uint8_t opcode) {
-    uint8_t value = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [XXA]: %02X %02X", opcode, value);
-
-    // Output is AND of A, X, and immediate
-    cpu->A = (cpu->A & cpu->X) & value;
-
-    update_zero_and_negative_flags(cpu, cpu->A);
-    cpu->cycles = 2;
-    return;
-}
-
-// ======== AXS ======== 
-
-void handle_0xCB(CPU *cpu, uint8_t opcode) {
-    uint8_t value = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [AXS]: %02X %02X", opcode, value);
-    uint8_t result = cpu->X & cpu->A;
-    result -= value;
-
-    // Set Carry if result did not borrow
-    cpu->P = (cpu->X & cpu->A) >= value ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-    cpu->X = result;
-
-    update_zero_and_negative_flags(cpu, result);
-    cpu->cycles = 2;
-    return;
-}
-
-// ======== AHX ======== 
-
-void handle_0x93(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_indirect_y(opcode, "AHX", cpu);
-    uint16_t temp = ((effective_addr >> 8) + 1) & 0xFF;
-    uint8_t value = cpu->A & cpu->X & temp;
-    nes_cpu_write(effective_addr, value);
-    cpu->cycles = 8;
-    return;
-}
-          
-// ======== SHY ======== 
-
-void handle_0x9C(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_x(opcode, "SHY", cpu);
-    uint8_t value = cpu->Y & ((effective_addr >> 8) + 1);
-    nes_cpu_write(effective_addr, value);
-    cpu->cycles = 5;
-    return;
-}
- 
-// ======== AHX ======== 
-
-void handle_0x9F(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "AHX", cpu);
-    uint8_t value = cpu->A & cpu->X & ((effective_addr >> 8) + 1);
-    nes_cpu_write(effective_addr, value);
-    cpu->cycles = 5;
-    return;
-}
-
-// ======== SHX ======== 
-
-void handle_0x9E(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "SHX", cpu);
-    uint8_t value = cpu->X & ((effective_addr >> 8) + 1);
-    nes_cpu_write(effective_addr, value);
-    cpu->cycles = 5;
-    return;
-}
-
-// ======== TAS ======== 
-
-void handle_0x9B(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "TAS", cpu);
-    cpu->S = cpu->A & cpu->X;
-    uint8_t value = cpu->S & ((effective_addr >> 8) + 1);
-    nes_cpu_write(effective_addr, value);
-    cpu->cycles = 5;
-    return;
-}
-        
-// ======== LAS ======== 
-
-void handle_0xBB(CPU *cpu, uint8_t opcode) {
-    uint16_t effective_addr = cpu_absolute_y(opcode, "LAS", cpu);
-    uint8_t value = nes_cpu_read(effective_addr) & cpu->S;
-    cpu->A = cpu->X = cpu->S = value;
-    update_zero_and_negative_flags(cpu, value);
-    cpu->cycles = 4;
-    return;
-}
-
-// ======== Interrupts ======== 
-
-void cpu_irq(CPU *cpu) { // HARDWARE interrupts 
-    if (!(cpu->P & FLAG_INT)) {        
-        DEBUG_MSG_CPU("Hardware Interrupt Triggered");
-
-        cpu->service_int = 1; // signal that the interrupt is being serviced
-
-        // The return address is PC
-        uint16_t return_addr = cpu->PC;
-
-        // push PC to stack
-        stack_push(cpu, (return_addr >> 8) & 0xFF); // high byte
-        stack_push(cpu, return_addr & 0xFF);        // low byte
-
-        uint8_t status = (cpu->P & ~FLAG_BREAK) | FLAG_UNUSED;
-        stack_push(cpu, status);
-
-        // Set Interrupt Disable flag
-        cpu->P |= FLAG_INT; 
-
-        // Load new PC from IRQ vector at 0xFFFE/0xFFFF
-        uint8_t low = nes_cpu_read(0xFFFE);
-        uint8_t high = nes_cpu_read(0xFFFF);
-        cpu->PC = (high << 8) | low;
-
-        // Set cycles
-        cpu->cycles = 7;
-    }
-}
-
-void cpu_nmi(CPU *cpu) { // Non-Maskable Interrupt
-    DEBUG_MSG_CPU("NMI Triggered");
-
-    cpu->service_int = 1; // signal that the interrupt is being serviced
-    
-    // The return address is PC
-    uint16_t return_addr = cpu->PC;
-
-    // push PC to stack
-    stack_push(cpu, (return_addr >> 8) & 0xFF); // high byte
-    stack_push(cpu, return_addr & 0xFF);        // low byte
-
-    uint8_t status = (cpu->P & ~FLAG_BREAK) | FLAG_UNUSED;
-    stack_push(cpu, status);
-
-    // Set Interrupt Disable flag
-    cpu->P |= FLAG_INT; 
-
-    // Load new PC from IRQ vector at 0xFFFA/0xFFFB
-    uint8_t low = nes_cpu_read(0xFFFA);
-    uint8_t high = nes_cpu_read(0xFFFB);
-    cpu->PC = (high << 8) | low;
-
-    // Set cycles
-    cpu->cycles = 8;
-}
-
-// ======================= Instructions =======================
-
-void lda(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr); 
-    DEBUG_MSG_CPU("Writing 0x%02X to register A", value);
-    cpu->A = value;
-    update_zero_and_negative_flags(cpu, cpu->A);
-}
-
-void sta(uint16_t effective_addr, CPU *cpu) {
-    nes_cpu_write(effective_addr, cpu->A);
-}
-
-void ldx(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr); 
-    DEBUG_MSG_CPU("Writing 0x%02X to register X", value);
-    cpu->X = value;
-    update_zero_and_negative_flags(cpu, cpu->X);
-}
-
-void stx(uint16_t effective_addr, CPU *cpu) {
-    nes_cpu_write(effective_addr, cpu->X);
-}
-
-void ldy(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr); 
-    DEBUG_MSG_CPU("Writing 0x%02X to register Y", value);
-    cpu->Y = value;
-    update_zero_and_negative_flags(cpu, cpu->Y);
-}
-
-void sty(uint16_t effective_addr, CPU *cpu) {
-    nes_cpu_write(effective_addr, cpu->Y);
-}
-
-void adc(uint16_t effective_addr, CPU *cpu) {
-    uint8_t operand = nes_cpu_read(effective_addr);
-    uint8_t carry_in = (cpu->P & FLAG_CARRY) ? 1 : 0;
-    uint16_t result = cpu->A + operand + carry_in;
-
-    cpu->P = (result > 0xFF) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-    cpu->P = (((cpu->A ^ result) & (operand ^ result) & 0x80) != 0) ? (cpu->P | FLAG_OVERFLOW) : (cpu->P & ~FLAG_OVERFLOW);
-
-    cpu->A = (uint8_t) result;
-
-    update_zero_and_negative_flags(cpu, cpu->A);
-}
-
-void sbc(uint16_t effective_addr, CPU *cpu) {
-    uint8_t operand = nes_cpu_read(effective_addr);
-
-    uint8_t carry_in = (cpu->P & FLAG_CARRY) ? 1 : 0;
-    uint16_t result = cpu->A + ~operand + carry_in;
-
-    cpu->P = (result <= 0xFF) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-    cpu->P = (((cpu->A ^ operand) & (cpu->A ^ result) & 0x80) != 0) ? (cpu->P | FLAG_OVERFLOW) : (cpu->P & ~FLAG_OVERFLOW);
-
-    cpu->A = (uint8_t) result;
-
-    update_zero_and_negative_flags(cpu, cpu->A);
-}
-
-void inc(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-    // Increment value and write back to memory
-    value++; 
-    nes_cpu_write(effective_addr, value);
-    update_zero_and_negative_flags(cpu, value);
-}
-
-void dec(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-    // decrement value and write back to memory
-    value--;
-    nes_cpu_write(effective_addr, value);
-    update_zero_and_negative_flags(cpu, value);
-}
-
-void lsr(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-
-    // Carry Flag
-    cpu->P = (value & 0x01) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-
-    // Logical Shift Right
-    value >>= 1;
-
-    nes_cpu_write(effective_addr, value);
-
-    // Set flags
-    cpu->P = (value == 0) ? (cpu->P | FLAG_ZERO) : (cpu->P & ~FLAG_ZERO);
-    cpu->P &= ~FLAG_NEGATIVE; // bit 8 is always cleared after shift
-}
-
-void asl(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-
-    // Carry Flag
-    cpu->P = (value & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-
-    // Arithmetic Shift Left
-    value <<= 1;
-
-    // Set flags
-    update_zero_and_negative_flags(cpu, value);
-
-    // write back to memory
-    nes_cpu_write(effective_addr, value);
-}
-
-void rol(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-
-    uint8_t old_carry = (cpu->P & FLAG_CARRY) ? 1 : 0;
-    cpu->P = (value & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-
-    value = (value << 1) | old_carry;
-
-    nes_cpu_write(effective_addr, value);
-
-    update_zero_and_negative_flags(cpu, value);
-}
-
-void ror(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-
-    uint8_t old_carry = (cpu->P & FLAG_CARRY) ? 1 : 0;
-    uint8_t new_carry = value & 0x01;
-
-    value >>= 1;
-    value |= (old_carry << 7);
-
-    nes_cpu_write(effective_addr, value);
-
-    cpu->P = (new_carry) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-
-    update_zero_and_negative_flags(cpu, value);
-}
-
-void and(uint16_t effective_addr, CPU *cpu) {
-    uint8_t operand = nes_cpu_read(effective_addr);
-    uint8_t value = cpu->A & operand;
-    DEBUG_MSG_CPU("Writing 0x%02X to register A", value);
-    cpu->A = value;
-    update_zero_and_negative_flags(cpu, cpu->A);
-}
-
-void ora(uint16_t effective_addr, CPU *cpu) {
-    uint8_t operand = nes_cpu_read(effective_addr);
-    uint8_t value = cpu->A | operand;
-    DEBUG_MSG_CPU("Writing 0x%02X to register A", value);
-    cpu->A = value;
-    update_zero_and_negative_flags(cpu, cpu->A);
-}
-
-void eor(uint16_t effective_addr, CPU *cpu) {
-    uint8_t operand = nes_cpu_read(effective_addr);
-    uint8_t value = cpu->A ^ operand;
-    DEBUG_MSG_CPU("Writing 0x%02X to register A", value);
-    cpu->A = value;
+void arr(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+    cpu->A &= value;
+    // Rotate Right through Carry
+    uint8_t carry = (cpu->P & FLAG_CARRY) ? 0x80 : 0x00;
+    uint8_t result = (cpu->A >> 1) | carry;
+    cpu->A = result;
+    // Set Carry to bit 6, Overflow from bits 6 and 5
+    cpu->P = (result & 0x40) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    cpu->P = ((result ^ (result << 1)) & 0x40) ? (cpu->P | FLAG_OVERFLOW) : (cpu->P & ~FLAG_OVERFLOW);
     update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-void bit(uint16_t effective_addr, CPU *cpu) {
-    uint8_t operand = nes_cpu_read(effective_addr);
-
-    // Perform bitwise AND 
-    uint8_t result = cpu->A & operand;
-
-    // Set flags
-    cpu->P = (result == 0) ? (cpu->P | FLAG_ZERO) : (cpu->P & ~FLAG_ZERO);
-    cpu->P = (operand & 0x40) ? (cpu->P | FLAG_OVERFLOW) : (cpu->P & ~FLAG_OVERFLOW);
-    cpu->P = (operand & 0x80) ? (cpu->P | FLAG_NEGATIVE) : (cpu->P & ~FLAG_NEGATIVE);
-}
-
-void cmp(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-    uint8_t result = cpu->A - value;
-
-    // Set flags
-    cpu->P = (cpu->A >= value) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-    cpu->P = ((result & 0xFF) == 0) ? (cpu->P | FLAG_ZERO) : (cpu->P & ~FLAG_ZERO);
-    cpu->P = (result & 0x80) ? (cpu->P | FLAG_NEGATIVE) : (cpu->P & ~FLAG_NEGATIVE);
-}
-
-void cpx(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-    uint8_t result = cpu->X - value;
-
-    // Set flags
-    cpu->P = (cpu->X >= value) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-    cpu->P = (cpu->X == value) ? (cpu->P | FLAG_ZERO) : (cpu->P & ~FLAG_ZERO);
-    cpu->P = (result & 0x80) ? (cpu->P | FLAG_NEGATIVE) : (cpu->P & ~FLAG_NEGATIVE);
-}
-
-void cpy(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-    uint8_t result = cpu->Y - value;
-
-    // Set flags
-    cpu->P = (cpu->Y >= value) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-    cpu->P = (cpu->Y == value) ? (cpu->P | FLAG_ZERO) : (cpu->P & ~FLAG_ZERO);
-    cpu->P = (result & 0x80) ? (cpu->P | FLAG_NEGATIVE) : (cpu->P & ~FLAG_NEGATIVE);
-}
-
-void branch(int condition, int8_t offset, CPU *cpu) {
-    if (condition) { 
-        uint16_t address = cpu->PC + offset;
-        cpu->cycles++;
-        if ((cpu->PC & 0xFF00) != (address & 0xFF00)) { // page crossed
-            cpu->cycles++; 
-        }
-        DEBUG_MSG_CPU("Branching to 0x%04X", address);
-        cpu->PC = address;
-    }
-}
-
-void slo(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-
-    // Carry Flag
-    cpu->P = (value & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-
-    // Arithmetic Shift Left
-    value <<= 1;
-
-    nes_cpu_write(effective_addr, value);
-
-    // OR result with A and store back in A
-    cpu->A |= value;
-
+void xaa(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+    // Output is AND of A, X, and immediate
+    cpu->A = (cpu->A & cpu->X) & value;
     update_zero_and_negative_flags(cpu, cpu->A);
 }
 
-void lax(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-    cpu->A = value;
-    cpu->X = value;
-    update_zero_and_negative_flags(cpu, value);
-}
-
-void sax(uint16_t effective_addr, CPU *cpu) {
-    // Store A & X into memory
-    uint8_t result = cpu->A & cpu->X;
-    nes_cpu_write(effective_addr, result);
-}
-
-void dcp(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-
-    value--; // Decrement memory
-    nes_cpu_write(effective_addr, value);
-
-    // Perform CMP (A - value)
-    uint8_t result = cpu->A - value;
-
-    // Set Carry Flag if A >= M
-    cpu->P = (cpu->A >= value) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-
+void axs(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr);
+    uint8_t result = cpu->X & cpu->A;
+    result -= value;
+    // Set Carry if result did not borrow
+    cpu->P = (cpu->X & cpu->A) >= value ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
+    cpu->X = result;
     update_zero_and_negative_flags(cpu, result);
 }
 
-void isc(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-        
-    value += 1; // Increment memory
-    nes_cpu_write(effective_addr, value);
-
-    // Perform SBC with incremented value
-    uint8_t inverted = ~value;
-    uint16_t sum = cpu->A + inverted + (cpu->P & FLAG_CARRY ? 1 : 0);
-
-    // Set flags
-    cpu->P = (cpu->P & ~FLAG_OVERFLOW) |
-                (((cpu->A ^ sum) & (value ^ sum) & 0x80) ? FLAG_OVERFLOW : 0);
-    cpu->P = (cpu->P & ~FLAG_CARRY) |
-                ((sum > 0xFF) ? FLAG_CARRY : 0);
+// ==================== Unofficial (Unstable Stores) ====================
 
-    cpu->A = sum & 0xFF;
-    update_zero_and_negative_flags(cpu, cpu->A);
+void ahx(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = cpu->A & cpu->X & ((effective_addr >> 8) + 1);
+    nes_cpu_write(cpu->nes, effective_addr, value);
 }
 
-void rla(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-
-    // Rotate Left through Carry
-    uint8_t carry_in = (cpu->P & FLAG_CARRY) ? 1 : 0;
-    cpu->P = (value & 0x80) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-    value = (value << 1) | carry_in;
-
-    nes_cpu_write(effective_addr, value);
-
-    // AND with accumulator
-    cpu->A &= value;
-
-    update_zero_and_negative_flags(cpu, cpu->A);
+void shx(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = cpu->X & ((effective_addr >> 8) + 1);
+    nes_cpu_write(cpu->nes, effective_addr, value);
 }
 
-void sre(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-
-    // Carry Flag from bit 0 before shift
-    cpu->P = (value & 0x01) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-
-    // Logical Shift Right
-    value >>= 1;
-    nes_cpu_write(effective_addr, value);
-
-    // EOR with accumulator
-    cpu->A ^= value;
-
-    update_zero_and_negative_flags(cpu, cpu->A);
+void shy(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = cpu->Y & ((effective_addr >> 8) + 1);
+    nes_cpu_write(cpu->nes, effective_addr, value);
 }
 
-void rra(uint16_t effective_addr, CPU *cpu) {
-    uint8_t value = nes_cpu_read(effective_addr);
-        
-    // Rotate Right
-    uint8_t old_carry = (cpu->P & FLAG_CARRY) ? 0x80 : 0x00;
-    cpu->P = (value & 0x01) ? (cpu->P | FLAG_CARRY) : (cpu->P & ~FLAG_CARRY);
-    value = (value >> 1) | old_carry;
-
-    nes_cpu_write(effective_addr, value);
-
-    // ADC logic
-    uint16_t sum = cpu->A + value + ((cpu->P & FLAG_CARRY) ? 1 : 0);
-    cpu->P = (cpu->P & ~FLAG_OVERFLOW) |
-                (((cpu->A ^ sum) & (value ^ sum) & 0x80) ? FLAG_OVERFLOW : 0);
-    cpu->P = (cpu->P & ~FLAG_CARRY) |
-                ((sum > 0xFF) ? FLAG_CARRY : 0);
-
-    cpu->A = sum & 0xFF;
-    update_zero_and_negative_flags(cpu, cpu->A);
+void tas(uint16_t effective_addr, CPU *cpu) {
+    cpu->S = cpu->A & cpu->X;
+    uint8_t value = cpu->S & ((effective_addr >> 8) + 1);
+    nes_cpu_write(cpu->nes, effective_addr, value);
 }
 
-void nop_implied(CPU *cpu, uint8_t opcode) {
-    (void)cpu; (void)opcode;
-    DEBUG_MSG_CPU("Executing instruction [NOP]: %02X", opcode);
-    cpu->cycles = 2;
-    return;
+void las(uint16_t effective_addr, CPU *cpu) {
+    uint8_t value = nes_cpu_read(cpu->nes, effective_addr) & cpu->S;
+    cpu->A = cpu->X = cpu->S = value;
+    update_zero_and_negative_flags(cpu, value);
 }
 
-void nop_immediate(CPU *cpu, uint8_t opcode) {
-    cpu_immediate(opcode, "NOP", cpu);
-    cpu->cycles = 2;
-    return;
-}
+// ==================== Other ====================
 
-void nop_zero_page(CPU *cpu, uint8_t opcode) {
-    cpu_zero_page(opcode, "NOP", cpu);
-    cpu->cycles = 3;
-    return;
+void nop(uint16_t effective_addr, CPU *cpu) {
+    // operand bytes were already consumed by the addressing mode
+    (void)effective_addr; (void)cpu;
 }
 
-void nop_zero_page_x(CPU *cpu, uint8_t opcode) {
-    cpu_zero_page_x(opcode, "NOP", cpu);
-    cpu->cycles = 4;
-    return;
+void kil(uint16_t effective_addr, CPU *cpu) {
+    // jams the real CPU, treated as a 2 byte instruction that takes no cycles
+    (void)effective_addr; (void)cpu;
 }
 
-void nop_absolute(CPU *cpu, uint8_t opcode) {
-    cpu_absolute(opcode, "NOP", cpu);
-    cpu->cycles = 4;
-    return;
-}
+// ======================= Addressing Modes =======================
 
-void nop_absolute_x(CPU *cpu, uint8_t opcode) {
-    cpu_absolute_x(opcode, "NOP", cpu);
-    cpu->cycles = 4;
-    if (cpu->page_crossed) {
-        cpu->cycles += 1;
-    }
-    return;
-}
+// Each mode turns the operand bytes read by cpu_fetch (PC already points at the next
+// instruction) into the effective address
 
-void invalid(CPU *cpu, uint8_t opcode) {
-    (void)cpu; (void)opcode;
-    cpu->PC++;
-    cpu->cycles = 0;
-    return;
+uint16_t cpu_implied(CPU *cpu, uint16_t operand) {
+    (void)cpu; (void)operand;
+    return 0;
 }
 
-// ======================= Addressing Modes =======================
-
-uint16_t cpu_immediate(uint8_t opcode, const char *instruction, CPU *cpu) {
-    uint16_t effective_addr = cpu->PC++;
-    uint16_t immediate = nes_cpu_read(effective_addr);
-    DEBUG_MSG_CPU("Executing instruction [%s #Immediate]: %02X %02X", instruction, opcode, immediate);
+uint16_t cpu_immediate(CPU *cpu, uint16_t operand) {
+    (void)operand;
+    uint16_t effective_addr = cpu->PC - 1; // address of the operand byte
     return effective_addr;
 }
 
-uint16_t cpu_zero_page(uint8_t opcode, const char *instruction, CPU *cpu) {
-    uint8_t zero_addr = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [%s ZeroPage]: %02X %02X", instruction, opcode, zero_addr);
-    uint16_t effective_addr = (uint16_t) zero_addr;
+uint16_t cpu_zero_page(CPU *cpu, uint16_t operand) {
+    (void)cpu;
+    uint16_t effective_addr = operand & 0xFF;
     return effective_addr;
 }
 
-uint16_t cpu_zero_page_x(uint8_t opcode, const char *instruction, CPU *cpu) {
-    uint8_t zero_addr = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [%s ZeroPage, X]: %02X %02X", instruction, opcode, zero_addr);
-    uint8_t wrapped_addr = (zero_addr + cpu->X) & 0xFF; 
-    uint16_t effective_addr = (uint16_t) wrapped_addr; 
+uint16_t cpu_zero_page_x(CPU *cpu, uint16_t operand) {
+    uint8_t wrapped_addr = (operand + cpu->X) & 0xFF;
+    uint16_t effective_addr = (uint16_t) wrapped_addr;
     return effective_addr;
 }
 
-uint16_t cpu_zero_page_y(uint8_t opcode, const char *instruction, CPU *cpu) {
-    uint8_t zero_addr = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [%s ZeroPage, Y]: %02X %02X", instruction, opcode, zero_addr);
-    uint8_t wrapped_addr = (zero_addr + cpu->Y) & 0xFF; 
-    uint16_t effective_addr = (uint16_t) wrapped_addr; 
+uint16_t cpu_zero_page_y(CPU *cpu, uint16_t operand) {
+    uint8_t wrapped_addr = (operand + cpu->Y) & 0xFF;
+    uint16_t effective_addr = (uint16_t) wrapped_addr;
     return effective_addr;
 }
 
-uint16_t cpu_absolute(uint8_t opcode, const char *instruction, CPU *cpu) {
-    uint8_t low = nes_cpu_read(cpu->PC++);
-    uint8_t high = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [%s Absolute]: %02X %02X %02X", instruction, opcode, low, high);
-    uint16_t effective_addr = (uint16_t) (high << 8 | low);
+uint16_t cpu_absolute(CPU *cpu, uint16_t operand) {
+    (void)cpu;
+    uint16_t effective_addr = operand;
     return effective_addr;
 }
 
-uint16_t cpu_absolute_x(uint8_t opcode, const char *instruction, CPU *cpu) {
-    uint8_t low = nes_cpu_read(cpu->PC++);
-    uint8_t high = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [%s Absolute, X]: %02X %02X %02X", instruction, opcode, low, high);
-    uint16_t base_addr = (uint16_t) (high << 8 | low);
+uint16_t cpu_absolute_x(CPU *cpu, uint16_t operand) {
+    uint16_t base_addr = operand;
     uint16_t effective_addr = base_addr + cpu->X;
     if ((base_addr & 0xFF00) != (effective_addr & 0xFF00)) {
         cpu->page_crossed = 1;
@@ -2801,11 +1345,8 @@ uint16_t cpu_absolute_x(uint8_t opcode, const char *instruction, CPU *cpu) {
     return effective_addr;
 }
 
-uint16_t cpu_absolute_y(uint8_t opcode, const char *instruction, CPU *cpu) {
-    uint8_t low = nes_cpu_read(cpu->PC++);
-    uint8_t high = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [%s Absolute, Y]: %02X %02X %02X", instruction, opcode, low, high);
-    uint16_t base_addr = (uint16_t) (high << 8 | low);
+uint16_t cpu_absolute_y(CPU *cpu, uint16_t operand) {
+    uint16_t base_addr = operand;
     uint16_t effective_addr = base_addr + cpu->Y;
     if ((base_addr & 0xFF00) != (effective_addr & 0xFF00)) {
         cpu->page_crossed = 1;
@@ -2813,23 +1354,19 @@ uint16_t cpu_absolute_y(uint8_t opcode, const char *instruction, CPU *cpu) {
     return effective_addr;
 }
 
-uint16_t cpu_indirect_x(uint8_t opcode, const char *instruction, CPU *cpu) {
-    uint8_t zero_addr = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [%s (Indirect, X)]: %02X %02X", instruction, opcode, zero_addr);
-    uint8_t wrapped_addr = (zero_addr + cpu->X) & 0xFF; 
+uint16_t cpu_indirect_x(CPU *cpu, uint16_t operand) {
+    uint8_t wrapped_addr = (operand + cpu->X) & 0xFF;
     uint16_t addr = (uint16_t) wrapped_addr;
-    uint8_t low = nes_cpu_read(addr);
-    uint8_t high = nes_cpu_read((addr + 1) & 0xFF);
+    uint8_t low = nes_cpu_read(cpu->nes, addr);
+    uint8_t high = nes_cpu_read(cpu->nes, (addr + 1) & 0xFF);
     uint16_t effective_addr = (high << 8) | low;
     return effective_addr;
 }
 
-uint16_t cpu_indirect_y(uint8_t opcode, const char *instruction, CPU *cpu) {
-    uint8_t zero_addr = nes_cpu_read(cpu->PC++);
-    DEBUG_MSG_CPU("Executing instruction [%s (Indirect), Y]: %02X %02X", instruction, opcode, zero_addr);
-    uint16_t addr = (uint16_t) zero_addr;
-    uint8_t low = nes_cpu_read(addr);
-    uint8_t high = nes_cpu_read((addr + 1) & 0xFF);
+uint16_t cpu_indirect_y(CPU *cpu, uint16_t operand) {
+    uint16_t addr = operand & 0xFF;
+    uint8_t low = nes_cpu_read(cpu->nes, addr);
+    uint8_t high = nes_cpu_read(cpu->nes, (addr + 1) & 0xFF);
     uint16_t base_addr = (high << 8) | low;
     uint16_t effective_addr = base_addr + cpu->Y;
     if ((base_addr & 0xFF00) != (effective_addr & 0xFF00)) {
@@ -2838,266 +1375,48 @@ uint16_t cpu_indirect_y(uint8_t opcode, const char *instruction, CPU *cpu) {
     return effective_addr;
 }
 
+uint16_t cpu_relative(CPU *cpu, uint16_t operand) {
+    int8_t offset = (int8_t) operand;
+    uint16_t effective_addr = cpu->PC + offset; // branch target
+    return effective_addr;
+}
+
+uint16_t cpu_indirect(CPU *cpu, uint16_t operand) {
+    uint16_t ptr = operand;
+
+    // Emulate 6502 page boundary bug
+    uint8_t jump_low = nes_cpu_read(cpu->nes, ptr);
+    uint8_t jump_high;
+    if ((ptr & 0x00FF) == 0x00FF) {
+        // Wrap around same page
+        jump_high = nes_cpu_read(cpu->nes, ptr & 0xFF00);
+    } else {
+        jump_high = nes_cpu_read(cpu->nes, ptr + 1);
+    }
+    uint16_t effective_addr = (jump_high << 8) | jump_low;
+    return effective_addr;
+}
+
+// N and Z are evaluated lazily: the result is only kept in nz, and turned into flags when
+// something needs them (see NZ_ZERO / NZ_NEGATIVE and cpu_get_status)
 void update_zero_and_negative_flags(CPU* cpu, uint8_t value) {
-    cpu->P = (value == 0) ? (cpu->P | FLAG_ZERO) : (cpu->P & ~FLAG_ZERO);
-    cpu->P = (value & 0x80) ? (cpu->P | FLAG_NEGATIVE) : (cpu->P & ~FLAG_NEGATIVE);
-}
-
-void init_opcode_table() {
-    opcode_table[0x00] = handle_0x00;
-    opcode_table[0x01] = handle_0x01;
-    opcode_table[0x02] = invalid;
-    opcode_table[0x03] = handle_0x03;
-    opcode_table[0x04] = nop_zero_page;
-    opcode_table[0x05] = handle_0x05;
-    opcode_table[0x06] = handle_0x06;
-    opcode_table[0x07] = handle_0x07;
-    opcode_table[0x08] = handle_0x08;
-    opcode_table[0x09] = handle_0x09;
-    opcode_table[0x0A] = handle_0x0A;
-    opcode_table[0x0B] = handle_0x0B;
-    opcode_table[0x0C] = nop_absolute;
-    opcode_table[0x0D] = handle_0x0D;
-    opcode_table[0x0E] = handle_0x0E;
-    opcode_table[0x0F] = handle_0x0F;
-    opcode_table[0x10] = handle_0x10;
-    opcode_table[0x11] = handle_0x11;
-    opcode_table[0x12] = invalid;
-    opcode_table[0x13] = handle_0x13;
-    opcode_table[0x14] = nop_zero_page_x;
-    opcode_table[0x15] = handle_0x15;
-    opcode_table[0x16] = handle_0x16;
-    opcode_table[0x17] = handle_0x17;
-    opcode_table[0x18] = handle_0x18;
-    opcode_table[0x19] = handle_0x19;
-    opcode_table[0x1A] = nop_implied;
-    opcode_table[0x1B] = handle_0x1B;
-    opcode_table[0x1C] = nop_absolute_x;
-    opcode_table[0x1D] = handle_0x1D;
-    opcode_table[0x1E] = handle_0x1E;
-    opcode_table[0x1F] = handle_0x1F;
-    opcode_table[0x20] = handle_0x20;
-    opcode_table[0x21] = handle_0x21;
-    opcode_table[0x22] = invalid;
-    opcode_table[0x23] = handle_0x23;
-    opcode_table[0x24] = handle_0x24;
-    opcode_table[0x25] = handle_0x25;
-    opcode_table[0x26] = handle_0x26;
-    opcode_table[0x27] = handle_0x27;
-    opcode_table[0x28] = handle_0x28;
-    opcode_table[0x29] = handle_0x29;
-    opcode_table[0x2A] = handle_0x2A;
-    opcode_table[0x2B] = handle_0x2B;
-    opcode_table[0x2C] = handle_0x2C;
-    opcode_table[0x2D] = handle_0x2D;
-    opcode_table[0x2E] = handle_0x2E;
-    opcode_table[0x2F] = handle_0x2F;
-    opcode_table[0x30] = handle_0x30;
-    opcode_table[0x31] = handle_0x31;
-    opcode_table[0x32] = invalid;
-    opcode_table[0x33] = handle_0x33;
-    opcode_table[0x34] = nop_zero_page_x;
-    opcode_table[0x35] = handle_0x35;
-    opcode_table[0x36] = handle_0x36;
-    opcode_table[0x37] = handle_0x37;
-    opcode_table[0x38] = handle_0x38;
-    opcode_table[0x39] = handle_0x39;
-    opcode_table[0x3A] = nop_implied;
-    opcode_table[0x3B] = handle_0x3B;
-    opcode_table[0x3C] = nop_absolute_x;
-    opcode_table[0x3D] = handle_0x3D;
-    opcode_table[0x3E] = handle_0x3E;
-    opcode_table[0x3F] = handle_0x3F;
-    opcode_table[0x40] = handle_0x40;
-    opcode_table[0x41] = handle_0x41;
-    opcode_table[0x42] = invalid;
-    opcode_table[0x43] = handle_0x43;
-    opcode_table[0x44] = nop_zero_page;
-    opcode_table[0x45] = handle_0x45;
-    opcode_table[0x46] = handle_0x46;
-    opcode_table[0x47] = handle_0x47;
-    opcode_table[0x48] = handle_0x48;
-    opcode_table[0x49] = handle_0x49;
-    opcode_table[0x4A] = handle_0x4A;
-    opcode_table[0x4B] = handle_0x4B;
-    opcode_table[0x4C] = handle_0x4C;
-    opcode_table[0x4D] = handle_0x4D;
-    opcode_table[0x4E] = handle_0x4E;
-    opcode_table[0x4F] = handle_0x4F;
-    opcode_table[0x50] = handle_0x50;
-    opcode_table[0x51] = handle_0x51;
-    opcode_table[0x52] = invalid;
-    opcode_table[0x53] = handle_0x53;
-    opcode_table[0x54] = nop_zero_page_x;
-    opcode_table[0x55] = handle_0x55;
-    opcode_table[0x56] = handle_0x56;
-    opcode_table[0x57] = handle_0x57;
-    opcode_table[0x58] = handle_0x58;
-    opcode_table[0x59] = handle_0x59;
-    opcode_table[0x5A] = nop_implied;
-    opcode_table[0x5B] = handle_0x5B;
-    opcode_table[0x5C] = nop_absolute_x;
-    opcode_table[0x5D] = handle_0x5D;
-    opcode_table[0x5E] = handle_0x5E;
-    opcode_table[0x5F] = handle_0x5F;
-    opcode_table[0x60] = handle_0x60;
-    opcode_table[0x61] = handle_0x61;
-    opcode_table[0x62] = invalid;
-    opcode_table[0x63] = handle_0x63;
-    opcode_table[0x64] = nop_zero_page;
-    opcode_table[0x65] = handle_0x65;
-    opcode_table[0x66] = handle_0x66;
-    opcode_table[0x67] = handle_0x67;
-    opcode_table[0x68] = handle_0x68;
-    opcode_table[0x69] = handle_0x69;
-    opcode_table[0x6A] = handle_0x6A;
-    opcode_table[0x6B] = handle_0x6B;
-    opcode_table[0x6C] = handle_0x6C;
-    opcode_table[0x6D] = handle_0x6D;
-    opcode_table[0x6E] = handle_0x6E;
-    opcode_table[0x6F] = handle_0x6F;
-    opcode_table[0x70] = handle_0x70;
-    opcode_table[0x71] = handle_0x71;
-    opcode_table[0x72] = invalid;
-    opcode_table[0x73] = handle_0x73;
-    opcode_table[0x74] = nop_zero_page_x;
-    opcode_table[0x75] = handle_0x75;
-    opcode_table[0x76] = handle_0x76;
-    opcode_table[0x77] = handle_0x77;
-    opcode_table[0x78] = handle_0x78;
-    opcode_table[0x79] = handle_0x79;
-    opcode_table[0x7A] = nop_implied;
-    opcode_table[0x7B] = handle_0x7B;
-    opcode_table[0x7C] = nop_absolute_x;
-    opcode_table[0x7D] = handle_0x7D;
-    opcode_table[0x7E] = handle_0x7E;
-    opcode_table[0x7F] = handle_0x7F;
-    opcode_table[0x80] = nop_immediate;
-    opcode_table[0x81] = handle_0x81;
-    opcode_table[0x82] = nop_immediate;
-    opcode_table[0x83] = handle_0x83;
-    opcode_table[0x84] = handle_0x84;
-    opcode_table[0x85] = handle_0x85;
-    opcode_table[0x86] = handle_0x86;
-    opcode_table[0x87] = handle_0x87;
-    opcode_table[0x88] = handle_0x88;
-    opcode_table[0x89] = nop_immediate;
-    opcode_table[0x8A] = handle_0x8A;
-    opcode_table[0x8B] = handle_0x8B;
-    opcode_table[0x8C] = handle_0x8C;
-    opcode_table[0x8D] = handle_0x8D;
-    opcode_table[0x8E] = handle_0x8E;
-    opcode_table[0x8F] = handle_0x8F;
-    opcode_table[0x90] = handle_0x90;
-    opcode_table[0x91] = handle_0x91;
-    opcode_table[0x92] = invalid;
-    opcode_table[0x93] = handle_0x93;
-    opcode_table[0x94] = handle_0x94;
-    opcode_table[0x95] = handle_0x95;
-    opcode_table[0x96] = handle_0x96;
-    opcode_table[0x97] = handle_0x97;
-    opcode_table[0x98] = handle_0x98;
-    opcode_table[0x99] = handle_0x99;
-    opcode_table[0x9A] = handle_0x9A;
-    opcode_table[0x9B] = handle_0x9B;
-    opcode_table[0x9C] = handle_0x9C;
-    opcode_table[0x9D] = handle_0x9D;
-    opcode_table[0x9E] = handle_0x9E;
-    opcode_table[0x9F] = handle_0x9F;
-    opcode_table[0xA0] = handle_0xA0;
-    opcode_table[0xA1] = handle_0xA1;
-    opcode_table[0xA2] = handle_0xA2;
-    opcode_table[0xA3] = handle_0xA3;
-    opcode_table[0xA4] = handle_0xA4;
-    opcode_table[0xA5] = handle_0xA5;
-    opcode_table[0xA6] = handle_0xA6;
-    opcode_table[0xA7] = handle_0xA7;
-    opcode_table[0xA8] = handle_0xA8;
-    opcode_table[0xA9] = handle_0xA9;
-    opcode_table[0xAA] = handle_0xAA;
-    opcode_table[0xAB] = handle_0xAB;
-    opcode_table[0xAC] = handle_0xAC;
-    opcode_table[0xAD] = handle_0xAD;
-    opcode_table[0xAE] = handle_0xAE;
-    opcode_table[0xAF] = handle_0xAF;
-    opcode_table[0xB0] = handle_0xB0;
-    opcode_table[0xB1] = handle_0xB1;
-    opcode_table[0xB2] = invalid;
-    opcode_table[0xB3] = handle_0xB3;
-    opcode_table[0xB4] = handle_0xB4;
-    opcode_table[0xB5] = handle_0xB5;
-    opcode_table[0xB6] = handle_0xB6;
-    opcode_table[0xB7] = handle_0xB7;
-    opcode_table[0xB8] = handle_0xB8;
-    opcode_table[0xB9] = handle_0xB9;
-    opcode_table[0xBA] = handle_0xBA;
-    opcode_table[0xBB] = handle_0xBB;
-    opcode_table[0xBC] = handle_0xBC;
-    opcode_table[0xBD] = handle_0xBD;
-    opcode_table[0xBE] = handle_0xBE;
-    opcode_table[0xBF] = handle_0xBF;
-    opcode_table[0xC0] = handle_0xC0;
-    opcode_table[0xC1] = handle_0xC1;
-    opcode_table[0xC2] = nop_immediate;
-    opcode_table[0xC3] = handle_0xC3;
-    opcode_table[0xC4] = handle_0xC4;
-    opcode_table[0xC5] = handle_0xC5;
-    opcode_table[0xC6] = handle_0xC6;
-    opcode_table[0xC7] = handle_0xC7;
-    opcode_table[0xC8] = handle_0xC8;
-    opcode_table[0xC9] = handle_0xC9;
-    opcode_table[0xCA] = handle_0xCA;
-    opcode_table[0xCB] = handle_0xCB;
-    opcode_table[0xCC] = handle_0xCC;
-    opcode_table[0xCD] = handle_0xCD;
-    opcode_table[0xCE] = handle_0xCE;
-    opcode_table[0xCF] = handle_0xCF;
-    opcode_table[0xD0] = handle_0xD0;
-    opcode_table[0xD1] = handle_0xD1;
-    opcode_table[0xD2] = invalid;
-    opcode_table[0xD3] = handle_0xD3;
-    opcode_table[0xD4] = nop_zero_page_x;
-    opcode_table[0xD5] = handle_0xD5;
-    opcode_table[0xD6] = handle_0xD6;
-    opcode_table[0xD7] = handle_0xD7;
-    opcode_table[0xD8] = handle_0xD8;
-    opcode_table[0xD9] = handle_0xD9;
-    opcode_table[0xDA] = nop_implied;
-    opcode_table[0xDB] = handle_0xDB;
-    opcode_table[0xDC] = nop_absolute_x;
-    opcode_table[0xDD] = handle_0xDD;
-    opcode_table[0xDE] = handle_0xDE;
-    opcode_table[0xDF] = handle_0xDF;
-    opcode_table[0xE0] = handle_0xE0;
-    opcode_table[0xE1] = handle_0xE1;
-    opcode_table[0xE2] = nop_immediate;
-    opcode_table[0xE3] = handle_0xE3;
-    opcode_table[0xE4] = handle_0xE4;
-    opcode_table[0xE5] = handle_0xE5;
-    opcode_table[0xE6] = handle_0xE6;
-    opcode_table[0xE7] = handle_0xE7;
-    opcode_table[0xE8] = handle_0xE8;
-    opcode_table[0xE9] = handle_0xE9;
-    opcode_table[0xEA] = nop_implied;
-    opcode_table[0xEB] = handle_0xEB;
-    opcode_table[0xEC] = handle_0xEC;
-    opcode_table[0xED] = handle_0xED;
-    opcode_table[0xEE] = handle_0xEE;
-    opcode_table[0xEF] = handle_0xEF;
-    opcode_table[0xF0] = handle_0xF0;
-    opcode_table[0xF1] = handle_0xF1;
-    opcode_table[0xF2] = invalid;
-    opcode_table[0xF3] = handle_0xF3;
-    opcode_table[0xF4] = nop_zero_page_x;
-    opcode_table[0xF5] = handle_0xF5;
-    opcode_table[0xF6] = handle_0xF6;
-    opcode_table[0xF7] = handle_0xF7;
-    opcode_table[0xF8] = handle_0xF8;
-    opcode_table[0xF9] = handle_0xF9;
-    opcode_table[0xFA] = nop_implied;
-    opcode_table[0xFB] = handle_0xFB;
-    opcode_table[0xFC] = nop_absolute_x;
-    opcode_table[0xFD] = handle_0xFD;
-    opcode_table[0xFE] = handle_0xFE;
-    opcode_table[0xFF] = handle_0xFF;
-}
\ No newline at end of file
+    cpu->nz = value;
+}
+
+// P with N and Z filled in from nz, for pushes and anything outside the CPU that looks at it
+uint8_t cpu_get_status(CPU *cpu) {
+    uint8_t status = cpu->P & ~(FLAG_ZERO | FLAG_NEGATIVE);
+    if (NZ_ZERO(cpu->nz)) {
+        status |= FLAG_ZERO;
+    }
+    if (NZ_NEGATIVE(cpu->nz)) {
+        status |= FLAG_NEGATIVE;
+    }
+    return status;
+}
+
+// loads P (PLP, RTI, reset), N and Z are moved into nz
+void cpu_set_status(CPU *cpu, uint8_t status) {
+    cpu->P = status;
+    cpu->nz = ((status & FLAG_NEGATIVE) << 8) | !(status & FLAG_ZERO);
+}
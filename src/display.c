@@ -21,6 +21,12 @@ DISPLAY *window_init(int debug_enable) {
     }
 
     display->debug_enable = debug_enable;
+    display->nt_texture = NULL;
+    display->pt_texture = NULL;
+    display->nt_frame_counter = 0;
+    display->frames = 0;
+    display->FPS = 0;
+    display->last_time = SDL_GetTicks();
 
     int width = WINDOW_WIDTH;
     int height = WINDOW_HEIGHT; 
@@ -64,6 +70,12 @@ void free_display(DISPLAY *display) {
         if (display->game_texture) {
             SDL_DestroyTexture(display->game_texture);
         }
+        if (display->nt_texture) {
+            SDL_DestroyTexture(display->nt_texture);
+        }
+        if (display->pt_texture) {
+            SDL_DestroyTexture(display->pt_texture);
+        }
         if (display->renderer) {
             SDL_DestroyRenderer(display->renderer);
         }
@@ -76,12 +88,22 @@ void free_display(DISPLAY *display) {
     }
 }
 
-void render_display(DISPLAY *display) {
+void render_display(DISPLAY *display, NES *nes) {
     // Safety check: ensure NES is initialized
     if (!nes || !nes->ppu || !nes->cpu || !nes->mapper) {
         return;
     }
 
+    // calculate FPS
+    display->frames++;
+    if (display->frames > 10) {
+        uint32_t curr_time = SDL_GetTicks();
+        double elapsed = (double)(curr_time - display->last_time) / 1000.0;
+        display->FPS = display->frames / elapsed;
+        display->frames = 0;
+        display->last_time = curr_time;
+    }
+
     // clear the screen once before rendering
     SDL_SetRenderDrawColor(display->renderer, 0, 0, 0, 255); 
     SDL_RenderClear(display->renderer);
@@ -93,21 +115,18 @@ void render_display(DISPLAY *display) {
         x_offset = NT_DISPLAY_WIDTH;
         
         // ======================= Nametables =======================
-        static SDL_Texture *nt_texture = NULL;
-        static int frame_counter = 0;
-        
         // Create texture if it doesn't exist
-        if (!nt_texture) {
-            nt_texture = SDL_CreateTexture(display->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, NT_WIDTH, NT_HEIGHT * 2);
-            if (!nt_texture) {
+        if (!display->nt_texture) {
+            display->nt_texture = SDL_CreateTexture(display->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, NT_WIDTH, NT_HEIGHT * 2);
+            if (!display->nt_texture) {
                 goto skip_nametables;
             }
         }
         
         // Only update nametables every 5 frames to improve performance
-        if (frame_counter % 5 == 0) {
+        if (display->nt_frame_counter % 5 == 0) {
             // Render the 2 physical nametables (2KB VRAM)
-            SDL_SetRenderTarget(display->renderer, nt_texture);
+            SDL_SetRenderTarget(display->renderer, display->nt_texture);
             SDL_SetRenderDrawColor(display->renderer, 0, 0, 0, 255);
             SDL_RenderClear(display->renderer);
             
@@ -121,7 +140,7 @@ void render_display(DISPLAY *display) {
                     for (int tx = 0; tx < 32; tx++) {
                         // Read tile index from nametable
                         uint16_t tile_addr = nt_base + ty * 32 + tx;
-                        uint8_t tile_id = nes_ppu_read(tile_addr);
+                        uint8_t tile_id = nes_ppu_read(nes, tile_addr);
                         
                         // Get pattern table base (from PPUCTRL bit 4)
                         uint16_t pattern_base = (nes->ppu->PPUCTRL & PPUCNTRL_B) ? 0x1000 : 0x0000;
@@ -129,13 +148,10 @@ void render_display(DISPLAY *display) {
                         
                         // Render the 8x8 tile
                         for (int py = 0; py < 8; py++) {
-                            uint8_t plane0 = nes_ppu_read(tile_pattern_addr + py);
-                            uint8_t plane1 = nes_ppu_read(tile_pattern_addr + py + 8);
+                            uint16_t row_pixels = nes_ppu_read_tile_row(nes, tile_pattern_addr + py);
                             
                             for (int px = 0; px < 8; px++) {
-                                uint8_t bit0 = (plane0 >> (7 - px)) & 1;
-                                uint8_t bit1 = (plane1 >> (7 - px)) & 1;
-                                uint8_t pixel = (bit1 << 1) | bit0;
+                                uint8_t pixel = (row_pixels >> (14 - 2 * px)) & 0x03;
                                 
                                 // Use grayscale based on pixel value (0-3)
                                 uint8_t shade = 85 * pixel;  // 0, 85, 170, 255
@@ -157,7 +173,7 @@ void render_display(DISPLAY *display) {
             SDL_SetRenderTarget(display->renderer, NULL);
         }
         
-        frame_counter++;
+        display->nt_frame_counter++;
         
         // Copy nametables to screen (always display, even if not updated this frame)
         SDL_Rect nt_dest = {
@@ -166,7 +182,7 @@ void render_display(DISPLAY *display) {
             .w = NT_DISPLAY_WIDTH,
             .h = NT_DISPLAY_HEIGHT
         };
-        SDL_RenderCopy(display->renderer, nt_texture, NULL, &nt_dest);
+        SDL_RenderCopy(display->renderer, display->nt_texture, NULL, &nt_dest);
         
         skip_nametables:;
         // ======================= Nametables =======================
@@ -181,7 +197,7 @@ void render_display(DISPLAY *display) {
         .h = NES_HEIGHT - 16  // 240 - 16 = 224
     };
     
-    SDL_UpdateTexture(display->game_texture, NULL, nes->ppu->frame_buffer, NES_WIDTH * sizeof(uint32_t)); 
+    SDL_UpdateTexture(display->game_texture, NULL, nes_get_framebuffer(nes), NES_WIDTH * sizeof(uint32_t)); 
     SDL_Rect game_rect = {x_offset, 0, GAME_WIDTH, GAME_HEIGHT};
     SDL_RenderCopy(display->renderer, display->game_texture, &crop_rect, &game_rect);  
     // ======================= Game Window =======================
@@ -193,19 +209,17 @@ void render_display(DISPLAY *display) {
     }
 
     // ======================= Pattern Tables =======================
-    static SDL_Texture *pt_texture = NULL;
-    
     // create texture if it doesn't exist
-    if (!pt_texture) {
-        pt_texture = SDL_CreateTexture(display->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, PT_WIDTH, PT_HEIGHT);
-        if (!pt_texture) {
+    if (!display->pt_texture) {
+        display->pt_texture = SDL_CreateTexture(display->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, PT_WIDTH, PT_HEIGHT);
+        if (!display->pt_texture) {
             SDL_RenderPresent(display->renderer);
             return;
         }
     }
 
     // re-render the pattern table every frame 
-    SDL_SetRenderTarget(display->renderer, pt_texture);
+    SDL_SetRenderTarget(display->renderer, display->pt_texture);
     SDL_SetRenderDrawColor(display->renderer, 0, 0, 0, 255);
     SDL_RenderClear(display->renderer);
 
@@ -218,13 +232,10 @@ void render_display(DISPLAY *display) {
 
             uint16_t addr = base + tile_index * 16;
             for (int row = 0; row < 8; row++) {
-                uint8_t plane0 = nes->mapper->ppu_read(nes->mapper, (addr + row) & 0x1FFF);
-                uint8_t plane1 = nes->mapper->ppu_read(nes->mapper, (addr + row + 8) & 0x1FFF);
+                uint16_t row_pixels = nes_ppu_read_tile_row(nes, (addr + row) & 0x1FFF);
 
                 for (int col = 0; col < 8; col++) {
-                    uint8_t bit0 = (plane0 >> (7 - col)) & 1;
-                    uint8_t bit1 = (plane1 >> (7 - col)) & 1;
-                    uint8_t pixel = (bit1 << 1) | bit0;
+                    uint8_t pixel = (row_pixels >> (14 - 2 * col)) & 0x03;
 
                     uint8_t shade = 85 * pixel;
                     SDL_SetRenderDrawColor(display->renderer, shade, shade, shade, 255);
@@ -250,7 +261,7 @@ void render_display(DISPLAY *display) {
         .w = (int)(PT_WIDTH * SCALE_FACTOR),
         .h = (int)(PT_HEIGHT * SCALE_FACTOR)
     };
-    SDL_RenderCopy(display->renderer, pt_texture, NULL, &pt_dest);
+    SDL_RenderCopy(display->renderer, display->pt_texture, NULL, &pt_dest);
 
     // ======================= Pattern Tables =======================
 
@@ -260,20 +271,21 @@ void render_display(DISPLAY *display) {
 
     // ======================= Debug Info =======================
     char reg_text[512];
+    uint8_t status = cpu_get_status(nes->cpu);
     snprintf(reg_text, sizeof(reg_text),
              "PC: $%04X   A: $%02X   X: $%02X   Y: $%02X   SP: $%02X   P: %c%c-%c%c%c%c%c%c    FPS: %02i\n"
              "PPUCTRL: $%02X   PPUMASK: $%02X   PPUSTATUS: $%02X   OAMADDR: $%02X\n"
              "OAMDATA: $%02X   PPUSCROLL: $%02X   PPUADDR: $%02X   PPUDATA: $%02X",
              nes->cpu->PC, nes->cpu->A, nes->cpu->X, nes->cpu->Y, nes->cpu->S,
-             (nes->cpu->P & FLAG_NEGATIVE) ? 'N' : 'n',
-             (nes->cpu->P & FLAG_OVERFLOW) ? 'V' : 'v',
-             (nes->cpu->P & FLAG_UNUSED) ? 'U' : 'u',
-             (nes->cpu->P & FLAG_BREAK) ? 'B' : 'b',
-             (nes->cpu->P & FLAG_DECIMAL) ? 'D' : 'd',
-             (nes->cpu->P & FLAG_INT) ? 'I' : 'i',
-             (nes->cpu->P & FLAG_ZERO) ? 'Z' : 'z',
-             (nes->cpu->P & FLAG_CARRY) ? 'C' : 'c',
-             nes->ppu->FPS,
+             (status & FLAG_NEGATIVE) ? 'N' : 'n',
+             (status & FLAG_OVERFLOW) ? 'V' : 'v',
+             (status & FLAG_UNUSED) ? 'U' : 'u',
+             (status & FLAG_BREAK) ? 'B' : 'b',
+             (status & FLAG_DECIMAL) ? 'D' : 'd',
+             (status & FLAG_INT) ? 'I' : 'i',
+             (status & FLAG_ZERO) ? 'Z' : 'z',
+             (status & FLAG_CARRY) ? 'C' : 'c',
+             display->FPS,
              nes->ppu->PPUCTRL, nes->ppu->PPUMASK, nes->ppu->PPUSTATUS, nes->ppu->OAMADDR,
              nes->ppu->OAMDATA, nes->ppu->PPUSCROLL, nes->ppu->PPUADDR, nes->ppu->PPUDATA);
 
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/keyboard.h"
+#include "../include/input.h"
+#include "../include/log.h"
+
+void keyboard1_handle_input(uint8_t *button_state, SDL_Event *event) {
+    if (event->type == SDL_KEYDOWN || event->type == SDL_KEYUP) {
+        uint8_t mask = 0;
+
+        switch (event->key.keysym.sym) {
+            case SDLK_x: 
+                mask = NES_BUTTON_A; 
+                break;
+            case SDLK_z: 
+                mask = NES_BUTTON_B; 
+                break;
+            case SDLK_RETURN: 
+                mask = NES_BUTTON_START; 
+                break;
+            case SDLK_RSHIFT: 
+                mask = NES_BUTTON_SELECT; 
+                break;
+            case SDLK_UP: 
+                mask = NES_BUTTON_UP; 
+                break;
+            case SDLK_DOWN: 
+                mask = NES_BUTTON_DOWN; 
+                break;
+            case SDLK_LEFT: 
+                mask = NES_BUTTON_LEFT; 
+                break;
+            case SDLK_RIGHT: 
+                mask = NES_BUTTON_RIGHT; 
+                break;
+            default:
+                return; // Ignore other keys
+        }
+
+        if (event->type == SDL_KEYDOWN) {
+            if (!(*button_state & mask)) {
+                DEBUG_MSG_CNTRL("Key [%s] pressed", SDL_GetKeyName(event->key.keysym.sym));
+                *button_state |= mask;  // Set bit (button pressed)
+            }
+        } else {
+            *button_state &= ~mask; // Clear bit (button released)
+        }
+    }
+}
+
+void keyboard2_handle_input(uint8_t *button_state, SDL_Event *event) {
+    if (event->type == SDL_KEYDOWN || event->type == SDL_KEYUP) {
+        uint8_t mask = 0;
+
+        switch (event->key.keysym.sym) {
+            case SDLK_l: 
+                mask = NES_BUTTON_A; 
+                break;
+            case SDLK_k: 
+                mask = NES_BUTTON_B; 
+                break;
+            case SDLK_h: 
+                mask = NES_BUTTON_START; 
+                break;
+            case SDLK_g: 
+                mask = NES_BUTTON_SELECT; 
+                break;
+            case SDLK_w: 
+                mask = NES_BUTTON_UP; 
+                break;
+            case SDLK_s: 
+                mask = NES_BUTTON_DOWN; 
+                break;
+            case SDLK_a: 
+                mask = NES_BUTTON_LEFT; 
+                break;
+            case SDLK_d: 
+                mask = NES_BUTTON_RIGHT; 
+                break;
+            default:
+                return; // Ignore other keys
+        }
+
+        if (event->type == SDL_KEYDOWN) {
+            if (!(*button_state & mask)) {
+                DEBUG_MSG_CNTRL("Key [%s] pressed", SDL_GetKeyName(event->key.keysym.sym));
+                *button_state |= mask;  // Set bit (button pressed)
+            }
+        } else {
+            *button_state &= ~mask; // Clear bit (button released)
+        }
+    }
+}
@@ -11,22 +11,28 @@
 #include "../include/ppu.h"
 #include "../include/input.h"
 #include "../include/display.h"
+#include "../include/audio.h"
+#include "../include/keyboard.h"
 #include "../include/apu.h"
 
 void clean_up();
 void handle_sigint(int sig);
 
-uint32_t last_time;
+int display_flag = 0; // pattern table and register display
+int dot_accurate = 0; // step the PPU dot by dot instead of batching whole lines
+int idle_skip = 1; // fast-forward idle loops
 
-int display = 0; // pattern table and register display
+NES *nes = NULL;
+DISPLAY *display = NULL;
+AUDIO *audio = NULL;
+uint8_t button_state[2] = {0, 0}; // controller 1 and 2 button states
 
-int debug_enable = 0;
 uint16_t breakpoint = 0xFFFF;
 int at_break = 0;
 
 int main(int argc, char *argv[]) {
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s <rom.nes> [<save.nes>] [--display] [--debug] [--break <addr>]\n", argv[0]);
+        fprintf(stderr, "Usage: %s <rom.nes> [<save.nes>] [--display] [--debug] [--dot-accurate] [--no-idle-skip] [--break <addr>]\n", argv[0]);
         exit(1);
     }
 
@@ -52,7 +58,7 @@ int main(int argc, char *argv[]) {
 
         // --display flag for extra debug display
         if (strcmp(argv[i], "--display") == 0) {
-            display = 1;
+            display_flag = 1;
             i++;
             continue;
         }
@@ -60,6 +66,23 @@ int main(int argc, char *argv[]) {
         // --debug flag
         if (strcmp(argv[i], "--debug") == 0) {
             debug_enable = 1;
+#ifdef NES_RELEASE
+            printf("Note: tracing is compiled out of release builds\n");
+#endif
+            i++;
+            continue;
+        }
+
+        // --dot-accurate flag
+        if (strcmp(argv[i], "--dot-accurate") == 0) {
+            dot_accurate = 1;
+            i++;
+            continue;
+        }
+
+        // --no-idle-skip flag
+        if (strcmp(argv[i], "--no-idle-skip") == 0) {
+            idle_skip = 0;
             i++;
             continue;
         }
@@ -93,14 +116,17 @@ int main(int argc, char *argv[]) {
 
     printf("Booting up NES Emulator...\n");
 
-    // get initial time
-    last_time = SDL_GetTicks();
-
     // Register signal handler for SIGINT
     signal(SIGINT, handle_sigint);
 
     // Initialize NES
-    nes_init(rom, save, display);
+    nes = nes_init(rom, save);
+    nes_set_dot_accurate(nes, dot_accurate);
+    nes_set_idle_skip(nes, idle_skip);
+
+    // Initialize frontend (window and audio output)
+    display = window_init(display_flag); // pass display flag for debug display
+    audio = audio_init(nes);
 
     printf("\nStarting execution of program [%s]\n\n", rom); 
 
@@ -108,6 +134,7 @@ int main(int argc, char *argv[]) {
         printf("DEBUG MODE enabled\n");
         if (breakpoint) {
             printf("BREAKPOINT SET at address 0x%04X\n", breakpoint);
+            nes_set_breakpoint(nes, breakpoint);
         }
         printf("\n");
     }
@@ -123,8 +150,10 @@ int main(int argc, char *argv[]) {
         SDL_Event event;
         while (SDL_PollEvent(&event)) {       
             // Controller input
-            cntrl1_handle_input(nes->controller1, &event);
-            cntrl2_handle_input(nes->controller2, &event);
+            keyboard1_handle_input(&button_state[0], &event);
+            keyboard2_handle_input(&button_state[1], &event);
+            nes_set_controller(nes, 0, button_state[0]);
+            nes_set_controller(nes, 1, button_state[1]);
 
             if (event.type == SDL_KEYUP) {
                 if (event.key.keysym.sym == SDLK_q) {
@@ -139,7 +168,9 @@ int main(int argc, char *argv[]) {
                                 step = !step; // Toggle step mode
                                 break;
                             case SDLK_p:
-                                running = nes_cycle(&last_time, debug_enable); // Run next instruction
+                                if (nes_cycle(nes)) { // Run next instruction
+                                    render_display(display, nes);
+                                }
                                 break;
                             default:
                                 break;
@@ -150,28 +181,15 @@ int main(int argc, char *argv[]) {
         }
 
         if (!step) { // run continuously
-            int cycles_this_frame = 0;
             uint32_t frame_start = SDL_GetTicks();
 
-            // run enough CPU cycles to simulate 1/60th of a second
-            while (cycles_this_frame < CYCLES_PER_FRAME && running) {
-                running = nes_cycle(&last_time, debug_enable); 
-                cycles_this_frame += nes->cpu->cycles;    // get actual number of cycles run
-
-                // handle infitite loop edge case
-                if (nes->cpu->cycles == 0) {
-                    cycles_this_frame++;
-                }
-
-                // check for breakpoint
-                if (debug_enable && nes->cpu->PC == breakpoint && !at_break) {
-                    printf("BREAKPOINT HIT at 0x%04X\nSTEP MODE Enabled [press `p` to run next instruction]\n", breakpoint);
-                    step = 1;
-                    at_break = 1;
-                    break;
-                } else if (debug_enable && nes->cpu->PC != breakpoint && at_break) {
-                    at_break = 0;
-                }
+            // run until the PPU completes a frame (1/60th of a second) or the breakpoint is hit
+            if (nes_run_frame(nes) == NES_RUN_BREAKPOINT) {
+                printf("BREAKPOINT HIT at 0x%04X\nSTEP MODE Enabled [press `p` to run next instruction]\n", breakpoint);
+                step = 1;
+                at_break = 1;
+            } else {
+                render_display(display, nes);
             }
 
             uint32_t frame_end = SDL_GetTicks();
@@ -199,7 +217,9 @@ int main(int argc, char *argv[]) {
 
 void clean_up() {
     printf("Cleaning up...\n");
-    nes_free();
+    audio_free(audio); // stop pulling samples before the console goes away
+    nes_free(nes);
+    free_display(display);
     printf("DONE\n");
 }
 
@@ -9,9 +9,7 @@ void mapper_mmc1_init(Mapper *m);
 void mapper_uxrom_init(Mapper *m);
 void mapper_mmc3_init(Mapper *m);
 
-uint16_t mirror_nametable(Mapper *m, uint16_t address);
-
-Mapper *mapper_init(Cartridge *cart) {
+Mapper *mapper_init(Cartridge *cart, uint8_t *vram) {
     if (!cart) {
         FATAL_ERROR("Mapper", "Cannot initialize mapper with NULL cartridge");
         return NULL;
@@ -29,10 +27,8 @@ Mapper *mapper_init(Cartridge *cart) {
     mapper->cart = cart;
 
     // set initial mirroring mode from cartridge
-    mapper->mirroring = cart->mirroring;
-
-    // set default nametable mirroring function
-    mapper->mirror_nametable = mirror_nametable; 
+    mapper->vram = vram;
+    mapper_set_mirroring(mapper, cart->mirroring);
 
     // initialize IRQ flag
     mapper->irq = 0;
@@ -66,33 +62,86 @@ Mapper *mapper_init(Cartridge *cart) {
 
 void mapper_free(Mapper *mapper) {
     if (mapper) {
+        if (mapper->regs) {
+            free(mapper->regs);
+        }
         free(mapper);
     }
 }
 
-uint16_t mirror_nametable(Mapper *m, uint16_t address) {
-    switch (m->mirroring) {
-        case MIRROR_VERTICAL: {
-            if (address >= 0x2800 && address < 0x2C00) {
-                return address - 0x800;
-            }
-            if (address >= 0x2C00 && address < 0x3000) {
-                return address - 0x800;
-            }
-            break;
-        }
-        case MIRROR_HORIZONTAL: {
-            if (address >= 0x2400 && address < 0x2800) {
-                return address - 0x400;
-            }
-            if (address >= 0x2800 && address < 0x2C00) {
-                return address - 0x400;
-            }
-            if (address >= 0x2C00 && address < 0x3000) {
-                return address - 0x800;
-            }
-            break;
-        }
+// points the CPU pages covering addr..addr+size-1 at read/write (NULL sends the page to the slow path)
+void mapper_map_cpu(Mapper *m, uint16_t addr, uint32_t size, uint8_t *read, uint8_t *write) {
+    int first_page = addr >> CPU_PAGE_SHIFT;
+    int pages = size >> CPU_PAGE_SHIFT;
+
+    for (int i = 0; i < pages; i++) {
+        m->cpu_read_map[first_page + i] = read ? read + i * CPU_PAGE_SIZE : NULL;
+        m->cpu_write_map[first_page + i] = write ? write + i * CPU_PAGE_SIZE : NULL;
+        m->cpu_decode_map[first_page + i] = NULL; // instructions are fetched from the bus
+    }
+}
+
+// maps PRG ROM starting at prg_offset (read only, wraps around if out of bounds). Bank switches only
+// repoint the pages, the decoded instructions of every bank stay cached
+void mapper_map_prg_rom(Mapper *m, uint16_t addr, uint32_t size, uint32_t prg_offset) {
+    int first_page = addr >> CPU_PAGE_SHIFT;
+    int pages = size >> CPU_PAGE_SHIFT;
+
+    for (int i = 0; i < pages; i++) {
+        uint32_t prg_addr = (prg_offset + i * CPU_PAGE_SIZE) % m->cart->prg_size;
+        m->cpu_read_map[first_page + i] = m->cart->prg_rom + prg_addr;
+        m->cpu_write_map[first_page + i] = NULL; // writes go to the mapper registers
+        m->cpu_decode_map[first_page + i] = m->cart->prg_ops + prg_addr;
+    }
+}
+
+// maps PRG RAM at 0x6000-0x7FFF (mirrored if smaller than 8KB)
+void mapper_map_prg_ram(Mapper *m, int readable, int writable) {
+    int first_page = 0x6000 >> CPU_PAGE_SHIFT;
+    int pages = 0x2000 >> CPU_PAGE_SHIFT;
+
+    for (int i = 0; i < pages; i++) {
+        uint8_t *page = m->cart->prg_ram + (i * CPU_PAGE_SIZE) % m->cart->prg_ram_size;
+        m->cpu_read_map[first_page + i] = readable ? page : NULL;
+        m->cpu_write_map[first_page + i] = writable ? page : NULL;
+        m->cpu_decode_map[first_page + i] = NULL; // RAM can be rewritten, its code is fetched from the bus
+    }
+}
+
+// maps CHR ROM/RAM starting at chr_offset into the pattern table pages covering addr..addr+size-1
+// (wraps around if out of bounds)
+void mapper_map_chr(Mapper *m, uint16_t addr, uint32_t size, uint32_t chr_offset, int writable) {
+    int first_page = addr >> PPU_PAGE_SHIFT;
+    int pages = size >> PPU_PAGE_SHIFT;
+
+    for (int i = 0; i < pages; i++) {
+        uint32_t chr_addr = (chr_offset + i * PPU_PAGE_SIZE) % m->cart->chr_size;
+        m->chr_read_map[first_page + i] = m->cart->chr_rom + chr_addr;
+        m->chr_write_map[first_page + i] = writable ? m->cart->chr_rom + chr_addr : NULL;
+        m->chr_tile_map[first_page + i] = m->cart->chr_tiles + chr_addr / 2; // 16 byte tiles decode to 8 rows
+    }
+}
+
+// writes to a writable pattern table page (CHR RAM) and keeps the decoded tile row cache in sync
+void mapper_chr_write(Mapper *m, uint16_t addr, uint8_t value) {
+    uint8_t *page = m->chr_write_map[addr >> PPU_PAGE_SHIFT];
+    if (page) {
+        cart_chr_write(m->cart, (page - m->cart->chr_rom) + (addr & (PPU_PAGE_SIZE - 1)), value);
     }
-    return address;
-}
\ No newline at end of file
+}
+
+// sets the mirroring mode and points the four nametables at the matching 1KB half of VRAM
+void mapper_set_mirroring(Mapper *m, int mirroring) {
+    // physical VRAM page used by nametables 0x2000, 0x2400, 0x2800 and 0x2C00
+    static const uint8_t layouts[4][NAMETABLE_COUNT] = {
+        [MIRROR_VERTICAL]     = {0, 1, 0, 1},
+        [MIRROR_HORIZONTAL]   = {0, 0, 1, 1},
+        [MIRROR_SINGLE_LOWER] = {0, 0, 0, 0},
+        [MIRROR_SINGLE_UPPER] = {1, 1, 1, 1},
+    };
+
+    m->mirroring = mirroring;
+    for (int i = 0; i < NAMETABLE_COUNT; i++) {
+        m->nametable_map[i] = m->vram + layouts[mirroring][i] * PPU_PAGE_SIZE;
+    }
+}
@@ -5,16 +5,18 @@
 
 uint8_t mapper_nrom_cpu_read(Mapper *m, uint16_t addr);
 void mapper_nrom_cpu_write(Mapper *m, uint16_t addr, uint8_t value);
-uint8_t mapper_nrom_ppu_read(Mapper *m, uint16_t addr);
-void mapper_nrom_ppu_write(Mapper *m, uint16_t addr, uint8_t value);
 
 void mapper_nrom_init(Mapper *m) {
     m->cpu_read = mapper_nrom_cpu_read;
     m->cpu_write = mapper_nrom_cpu_write;
-    m->ppu_read = mapper_nrom_ppu_read;
-    m->ppu_write = mapper_nrom_ppu_write;
 
     m->regs = NULL; // NROM has no registers
+
+    // PRG ROM never changes (a 16KB ROM is mirrored to fill 32KB), no PRG RAM
+    mapper_map_prg_rom(m, 0x8000, 0x8000, 0);
+
+    // CHR ROM/RAM: 0x0000-0x1FFF (writable only for CHR RAM)
+    mapper_map_chr(m, 0x0000, 0x2000, 0, m->cart->chr_ram);
 }
 
 uint8_t mapper_nrom_cpu_read(Mapper *m, uint16_t addr) {
@@ -40,18 +42,3 @@ void mapper_nrom_cpu_write(Mapper *m, uint16_t addr, uint8_t value) {
     // NROM has no writable registers
     // Writes to 0x8000-0xFFFF are ignored
 }
-
-uint8_t mapper_nrom_ppu_read(Mapper *m, uint16_t addr) {    
-    // CHR ROM/RAM: 0x0000-0x1FFF
-    if (addr < 0x2000) {
-        return m->cart->chr_rom[addr];
-    }
-    return 0; 
-}
-
-void mapper_nrom_ppu_write(Mapper *m, uint16_t addr, uint8_t value) {    
-    // CHR ROM/RAM: 0x0000-0x1FFF (RAM if chr_size == 0)
-    if (addr < 0x2000 && m->cart->chr_size == 0) {
-        m->cart->chr_rom[addr] = value;
-    }
-}
\ No newline at end of file
@@ -10,10 +10,7 @@
 
 uint8_t mapper_mmc1_cpu_read(Mapper *m, uint16_t addr);
 void mapper_mmc1_cpu_write(Mapper *m, uint16_t addr, uint8_t value);
-uint8_t mapper_mmc1_ppu_read(Mapper *m, uint16_t addr);
-void mapper_mmc1_ppu_write(Mapper *m, uint16_t addr, uint8_t value);
-
-uint16_t mirror_nametable_mmc1(Mapper *m, uint16_t address);
+void mapper_mmc1_map_banks(Mapper *m);
 
 typedef struct regs_mmc1 {
     // shift register (5 bits)
@@ -38,8 +35,6 @@ typedef struct regs_mmc1 {
 void mapper_mmc1_init(Mapper *m) {
     m->cpu_read = mapper_mmc1_cpu_read;
     m->cpu_write = mapper_mmc1_cpu_write;
-    m->ppu_read = mapper_mmc1_ppu_read;
-    m->ppu_write = mapper_mmc1_ppu_write;
 
     m->regs = (struct regs_mmc1 *)malloc(sizeof(struct regs_mmc1));
     memset(m->regs, 0, sizeof(struct regs_mmc1));
@@ -51,21 +46,55 @@ void mapper_mmc1_init(Mapper *m) {
     // convert initial mirroring from cartridge to MMC1 format
     switch (m->cart->mirroring) {
         case 0: 
-            m->mirroring = MIRROR_SINGLE_LOWER;
+            mapper_set_mirroring(m, MIRROR_SINGLE_LOWER);
             break;
         case 1: 
-            m->mirroring = MIRROR_SINGLE_UPPER;
+            mapper_set_mirroring(m, MIRROR_SINGLE_UPPER);
             break;
         case 2: 
-            m->mirroring = MIRROR_VERTICAL;
+            mapper_set_mirroring(m, MIRROR_VERTICAL);
             break;
         case 3: 
-            m->mirroring = MIRROR_HORIZONTAL;
+            mapper_set_mirroring(m, MIRROR_HORIZONTAL);
             break;
     }
 
-    // override default nametable mirroring function
-    m->mirror_nametable = mirror_nametable_mmc1; 
+    mapper_mmc1_map_banks(m);
+}
+
+// publishes the current PRG/CHR banks and PRG RAM enable to the CPU and PPU page maps
+void mapper_mmc1_map_banks(Mapper *m) {
+    regs_mmc1 *regs = (regs_mmc1 *)m->regs;
+
+    // PRG RAM (active low enable)
+    mapper_map_prg_ram(m, regs->prg_ram_en == 0, regs->prg_ram_en == 0);
+
+    // 32KB bank size mode
+    if (regs->prg_bank_mode == 0 || regs->prg_bank_mode == 1) {
+        uint8_t bank = (regs->prg_bank & 0x0E) >> 1; // ignore LSB for 32KB mode
+        mapper_map_prg_rom(m, 0x8000, MMC1_PRG_BANK_SIZE_32K, bank * MMC1_PRG_BANK_SIZE_32K);
+    }
+    // 16KB fixed first bank mode
+    else if (regs->prg_bank_mode == 2) {
+        mapper_map_prg_rom(m, 0x8000, MMC1_PRG_BANK_SIZE_16K, 0);
+        mapper_map_prg_rom(m, 0xC000, MMC1_PRG_BANK_SIZE_16K, (regs->prg_bank & 0x0F) * MMC1_PRG_BANK_SIZE_16K);
+    }
+    // 16KB fixed last bank mode
+    else {
+        mapper_map_prg_rom(m, 0x8000, MMC1_PRG_BANK_SIZE_16K, (regs->prg_bank & 0x0F) * MMC1_PRG_BANK_SIZE_16K);
+        mapper_map_prg_rom(m, 0xC000, MMC1_PRG_BANK_SIZE_16K, m->cart->prg_size - MMC1_PRG_BANK_SIZE_16K);
+    }
+
+    // 8KB CHR bank mode
+    if (regs->chr_bank_mode == 0) {
+        uint8_t bank = (regs->chr_bank_0 & 0x1E) >> 1; // ignore LSB for 8KB mode
+        mapper_map_chr(m, 0x0000, MMC1_CHR_BANK_SIZE_8K, bank * MMC1_CHR_BANK_SIZE_8K, m->cart->chr_ram);
+    }
+    // two 4KB CHR bank mode
+    else {
+        mapper_map_chr(m, 0x0000, MMC1_CHR_BANK_SIZE_4K, (regs->chr_bank_0 & 0x1F) * MMC1_CHR_BANK_SIZE_4K, m->cart->chr_ram);
+        mapper_map_chr(m, 0x1000, MMC1_CHR_BANK_SIZE_4K, (regs->chr_bank_1 & 0x1F) * MMC1_CHR_BANK_SIZE_4K, m->cart->chr_ram);
+    }
 }
 
 uint8_t mapper_mmc1_cpu_read(Mapper *m, uint16_t addr) {
@@ -152,18 +181,19 @@ void mapper_mmc1_cpu_write(Mapper *m, uint16_t addr, uint8_t value) {
             // convert initial mirroring from cartridge to MMC1 format
             switch (m->cart->mirroring) {
                 case 0: 
-                    m->mirroring = MIRROR_SINGLE_LOWER;
+                    mapper_set_mirroring(m, MIRROR_SINGLE_LOWER);
                     break;
                 case 1: 
-                    m->mirroring = MIRROR_SINGLE_UPPER;
+                    mapper_set_mirroring(m, MIRROR_SINGLE_UPPER);
                     break;
                 case 2: 
-                    m->mirroring = MIRROR_VERTICAL;
+                    mapper_set_mirroring(m, MIRROR_VERTICAL);
                     break;
                 case 3: 
-                    m->mirroring = MIRROR_HORIZONTAL;
+                    mapper_set_mirroring(m, MIRROR_HORIZONTAL);
                     break;
             }
+            mapper_mmc1_map_banks(m);
             return;
         }
         // shift in LSB of value into shift register
@@ -181,16 +211,16 @@ void mapper_mmc1_cpu_write(Mapper *m, uint16_t addr, uint8_t value) {
                     // set mirroring mode
                     switch (regs->shift_reg & 0x03) {
                         case 0:
-                            m->mirroring = MIRROR_SINGLE_LOWER;
+                            mapper_set_mirroring(m, MIRROR_SINGLE_LOWER);
                             break;
                         case 1:
-                            m->mirroring = MIRROR_SINGLE_UPPER;
+                            mapper_set_mirroring(m, MIRROR_SINGLE_UPPER);
                             break;
                         case 2:
-                            m->mirroring = MIRROR_VERTICAL;
+                            mapper_set_mirroring(m, MIRROR_VERTICAL);
                             break;
                         case 3:
-                            m->mirroring = MIRROR_HORIZONTAL;
+                            mapper_set_mirroring(m, MIRROR_HORIZONTAL);
                             break;
                     }
                 }
@@ -211,133 +241,9 @@ void mapper_mmc1_cpu_write(Mapper *m, uint16_t addr, uint8_t value) {
                 // reset shift register
                 regs->shift_reg = 0;
                 regs->shift_count = 0;
-            }
-        }
-    }
-}
 
-uint8_t mapper_mmc1_ppu_read(Mapper *m, uint16_t addr) {    
-    regs_mmc1 *regs = (regs_mmc1 *)m->regs;
-
-    // handle CHR ROM/RAM
-    if (addr < 0x2000) {
-        // 8KB bank mode
-        if (regs->chr_bank_mode == 0) {
-            uint8_t bank = (regs->chr_bank_0 & 0x1E) >> 1; // get bank index (ignore LSB for 8KB mode)
-            uint16_t offset = addr; // offset into bank
-            uint32_t chr_addr = (bank * MMC1_CHR_BANK_SIZE_8K) + offset; // calculate physical address
-            chr_addr = chr_addr % m->cart->chr_size; // wrap around if out of bounds
-            return m->cart->chr_rom[chr_addr];
-        }
-        // two 4KB bank mode
-        else if (regs->chr_bank_mode == 1) {
-            if (addr < 0x1000) {
-                // first 4KB bank
-                uint8_t bank = regs->chr_bank_0 & 0x1F; // get bank index
-                uint16_t offset = addr; // offset into bank
-                uint32_t chr_addr = (bank * MMC1_CHR_BANK_SIZE_4K) + offset; // calculate physical address
-                chr_addr = chr_addr % m->cart->chr_size; // wrap around if out of bounds
-                return m->cart->chr_rom[chr_addr];
-            } 
-            else {
-                // second 4KB bank
-                uint8_t bank = regs->chr_bank_1 & 0x1F; // get bank index
-                uint16_t offset = addr - 0x1000; // offset into bank
-                uint32_t chr_addr = (bank * MMC1_CHR_BANK_SIZE_4K) + offset; // calculate physical address
-                chr_addr = chr_addr % m->cart->chr_size; // wrap around if out of bounds
-                return m->cart->chr_rom[chr_addr];
-            }
-        }
-    } 
-    
-    return 0; 
-}
-
-void mapper_mmc1_ppu_write(Mapper *m, uint16_t addr, uint8_t value) {    
-    regs_mmc1 *regs = (regs_mmc1 *)m->regs;
-    
-    // handle CHR RAM
-    if (addr < 0x2000) {
-        // 8KB bank mode
-        if (regs->chr_bank_mode == 0) {
-            uint8_t bank = (regs->chr_bank_0 & 0x1E) >> 1; // get bank index (ignore LSB for 8KB mode)
-            uint16_t offset = addr; // offset into bank
-            uint32_t chr_addr = (bank * MMC1_CHR_BANK_SIZE_8K) + offset; // calculate physical address
-            chr_addr = chr_addr % m->cart->chr_size; // wrap around if out of bounds
-            m->cart->chr_rom[chr_addr] = value;
-        }
-        // two 4KB bank mode
-        else if (regs->chr_bank_mode == 1) {
-            if (addr < 0x1000) {
-                // first 4KB bank
-                uint8_t bank = regs->chr_bank_0 & 0x1F; // get bank index
-                uint16_t offset = addr; // offset into bank
-                uint32_t chr_addr = (bank * MMC1_CHR_BANK_SIZE_4K) + offset; // calculate physical address
-                chr_addr = chr_addr % m->cart->chr_size; // wrap around if out of bounds
-                m->cart->chr_rom[chr_addr] = value;
-            } 
-            else {
-                // second 4KB bank
-                uint8_t bank = regs->chr_bank_1 & 0x1F; // get bank index
-                uint16_t offset = addr - 0x1000; // offset into bank
-                uint32_t chr_addr = (bank * MMC1_CHR_BANK_SIZE_4K) + offset; // calculate physical address
-                chr_addr = chr_addr % m->cart->chr_size; // wrap around if out of bounds
-                m->cart->chr_rom[chr_addr] = value;
+                mapper_mmc1_map_banks(m);
             }
         }
     }
 }
-
-uint16_t mirror_nametable_mmc1(Mapper *m, uint16_t address) {
-    switch (m->mirroring) {
-        case MIRROR_VERTICAL: {
-            if (address >= 0x2800 && address < 0x2C00) {
-                return address - 0x800;
-            }
-            if (address >= 0x2C00 && address < 0x3000) {
-                return address - 0x800;
-            }
-            break;
-        }
-        case MIRROR_HORIZONTAL: {
-            if (address >= 0x2400 && address < 0x2800) {
-                return address - 0x400;
-            }
-            if (address >= 0x2800 && address < 0x2C00) {
-                return address - 0x400;
-            }
-            if (address >= 0x2C00 && address < 0x3000) {
-                return address - 0x800;
-            }
-            break;
-        }
-        case MIRROR_SINGLE_LOWER: {
-            // All addresses map to 0x2000-0x23FF
-            if (address >= 0x2400 && address < 0x2800) {
-                return address - 0x400;
-            }
-            if (address >= 0x2800 && address < 0x2C00) {
-                return address - 0x800;
-            }
-            if (address >= 0x2C00 && address < 0x3000) {
-                return address - 0xC00;
-            }
-            break;
-        }
-        case MIRROR_SINGLE_UPPER: {
-            // All addresses map to 0x2400-0x27FF
-            if (address >= 0x2000 && address < 0x2400) {
-                return address + 0x400;
-            }
-            if (address >= 0x2800 && address < 0x2C00) {
-                return address - 0x400;
-            }
-            if (address >= 0x2C00 && address < 0x3000) {
-                return address - 0x800;
-            }
-            break;
-        }
-    }
-
-    return address;
-}
\ No newline at end of file
@@ -7,8 +7,7 @@
 
 uint8_t mapper_uxrom_cpu_read(Mapper *m, uint16_t addr);
 void mapper_uxrom_cpu_write(Mapper *m, uint16_t addr, uint8_t value);
-uint8_t mapper_uxrom_ppu_read(Mapper *m, uint16_t addr);
-void mapper_uxrom_ppu_write(Mapper *m, uint16_t addr, uint8_t value);
+void mapper_uxrom_map_prg(Mapper *m);
 
 typedef struct regs_uxrom {
     uint8_t prg_bank; // selected PRG bank number
@@ -17,11 +16,22 @@ typedef struct regs_uxrom {
 void mapper_uxrom_init(Mapper *m) {
     m->cpu_read = mapper_uxrom_cpu_read;
     m->cpu_write = mapper_uxrom_cpu_write;
-    m->ppu_read = mapper_uxrom_ppu_read;
-    m->ppu_write = mapper_uxrom_ppu_write;
 
     m->regs = (regs_uxrom *)malloc(sizeof(regs_uxrom));
     memset(m->regs, 0, sizeof(regs_uxrom));
+
+    mapper_uxrom_map_prg(m);
+
+    // CHR ROM/RAM: 0x0000-0x1FFF (not banked, writable only for CHR RAM)
+    mapper_map_chr(m, 0x0000, 0x2000, 0, m->cart->chr_ram);
+}
+
+// publishes the current PRG banks to the CPU page map
+void mapper_uxrom_map_prg(Mapper *m) {
+    regs_uxrom *regs = (regs_uxrom *)m->regs;
+
+    mapper_map_prg_rom(m, 0x8000, UxROM_PRG_BANK_SIZE, (regs->prg_bank & 0x07) * UxROM_PRG_BANK_SIZE);
+    mapper_map_prg_rom(m, 0xC000, UxROM_PRG_BANK_SIZE, m->cart->prg_size - UxROM_PRG_BANK_SIZE);
 }
 
 uint8_t mapper_uxrom_cpu_read(Mapper *m, uint16_t addr) {
@@ -55,20 +65,6 @@ void mapper_uxrom_cpu_write(Mapper *m, uint16_t addr, uint8_t value) {
     if (addr >= 0x8000) {
         uint8_t bank = value & 0x0F; // lower 4 bits
         regs->prg_bank = bank; // store selected bank in regs[0]
+        mapper_uxrom_map_prg(m);
     }
 }
-
-uint8_t mapper_uxrom_ppu_read(Mapper *m, uint16_t addr) {  
-    // CHR ROM/RAM: 0x0000-0x1FFF 
-    if (addr < 0x2000) {
-        return m->cart->chr_rom[addr];
-    }
-    return 0; 
-}
-
-void mapper_uxrom_ppu_write(Mapper *m, uint16_t addr, uint8_t value) {    
-    // CHR ROM/RAM: 0x0000-0x1FFF 
-    if (addr < 0x2000) {
-        m->cart->chr_rom[addr] = value;
-    } 
-}
\ No newline at end of file
@@ -3,15 +3,15 @@
 #include "../../include/mapper.h"
 #include "../../include/log.h"
 
+#define MMC3_PRG_BANK_SIZE_8K 8192      // 8KB
 #define MMC3_CHR_BANK_SIZE_8K 8192      // 8KB
 #define MMC3_CHR_BANK_SIZE_1K 1024      // 1KB
 
 uint8_t mapper_mmc3_cpu_read(Mapper *m, uint16_t addr);
 void mapper_mmc3_cpu_write(Mapper *m, uint16_t addr, uint8_t value);
-uint8_t mapper_mmc3_ppu_read(Mapper *m, uint16_t addr);
-void mapper_mmc3_ppu_write(Mapper *m, uint16_t addr, uint8_t value);
 
 void mapper_mmc3_irq_clock(Mapper *m);
+void mapper_mmc3_map_banks(Mapper *m);
 
 typedef struct regs_mmc3 {
     // ========= 0x8000-0x9FFE =========
@@ -53,14 +53,42 @@ typedef struct regs_mmc3 {
 void mapper_mmc3_init(Mapper *m) {
     m->cpu_read = mapper_mmc3_cpu_read;
     m->cpu_write = mapper_mmc3_cpu_write;
-    m->ppu_read = mapper_mmc3_ppu_read;
-    m->ppu_write = mapper_mmc3_ppu_write;
 
     m->regs = (regs_mmc3 *)malloc(sizeof(regs_mmc3));
     memset(m->regs, 0, sizeof(regs_mmc3));
 
     m->irq_clock = mapper_mmc3_irq_clock; 
     m->irq = 0;
+
+    mapper_mmc3_map_banks(m);
+}
+
+// publishes the current PRG/CHR banks and PRG RAM enable/protect to the CPU and PPU page maps
+void mapper_mmc3_map_banks(Mapper *m) {
+    regs_mmc3 *regs = (regs_mmc3 *)m->regs;
+
+    uint32_t r6_bank = (regs->R6 & 0x3F) * MMC3_PRG_BANK_SIZE_8K;
+    uint32_t r7_bank = (regs->R7 & 0x3F) * MMC3_PRG_BANK_SIZE_8K;
+    uint32_t second_last_bank = m->cart->prg_size - (2 * MMC3_PRG_BANK_SIZE_8K);
+    uint32_t last_bank = m->cart->prg_size - MMC3_PRG_BANK_SIZE_8K;
+
+    mapper_map_prg_ram(m, regs->prg_ram_enable, regs->prg_ram_enable && !regs->prg_ram_protect);
+
+    // R6 and the second to last bank swap places depending on the PRG ROM bank mode
+    mapper_map_prg_rom(m, 0x8000, MMC3_PRG_BANK_SIZE_8K, regs->prg_rom_bank_mode == 0 ? r6_bank : second_last_bank);
+    mapper_map_prg_rom(m, 0xA000, MMC3_PRG_BANK_SIZE_8K, r7_bank);
+    mapper_map_prg_rom(m, 0xC000, MMC3_PRG_BANK_SIZE_8K, regs->prg_rom_bank_mode == 0 ? second_last_bank : r6_bank);
+    mapper_map_prg_rom(m, 0xE000, MMC3_PRG_BANK_SIZE_8K, last_bank);
+
+    // two 2KB banks (R0, R1) and four 1KB banks (R2-R5), the CHR bank mode picks which half gets which
+    uint16_t chr_2k_base = regs->chr_bank_mode == 0 ? 0x0000 : 0x1000;
+    uint16_t chr_1k_base = regs->chr_bank_mode == 0 ? 0x1000 : 0x0000;
+    mapper_map_chr(m, chr_2k_base + 0x0000, 2 * MMC3_CHR_BANK_SIZE_1K, (regs->R0 & 0xFE) * MMC3_CHR_BANK_SIZE_1K, m->cart->chr_ram);
+    mapper_map_chr(m, chr_2k_base + 0x0800, 2 * MMC3_CHR_BANK_SIZE_1K, (regs->R1 & 0xFE) * MMC3_CHR_BANK_SIZE_1K, m->cart->chr_ram);
+    mapper_map_chr(m, chr_1k_base + 0x0000, MMC3_CHR_BANK_SIZE_1K, regs->R2 * MMC3_CHR_BANK_SIZE_1K, m->cart->chr_ram);
+    mapper_map_chr(m, chr_1k_base + 0x0400, MMC3_CHR_BANK_SIZE_1K, regs->R3 * MMC3_CHR_BANK_SIZE_1K, m->cart->chr_ram);
+    mapper_map_chr(m, chr_1k_base + 0x0800, MMC3_CHR_BANK_SIZE_1K, regs->R4 * MMC3_CHR_BANK_SIZE_1K, m->cart->chr_ram);
+    mapper_map_chr(m, chr_1k_base + 0x0C00, MMC3_CHR_BANK_SIZE_1K, regs->R5 * MMC3_CHR_BANK_SIZE_1K, m->cart->chr_ram);
 }
 
 uint8_t mapper_mmc3_cpu_read(Mapper *m, uint16_t addr) {
@@ -179,6 +207,7 @@ void mapper_mmc3_cpu_write(Mapper *m, uint16_t addr, uint8_t value) {
             // CHR bank mode
             regs->chr_bank_mode = (value >> 7) & 0x01; // bit 7
         }
+        mapper_mmc3_map_banks(m);
     } 
     else if (addr >= 0xA000 && addr < 0xC000) {
         // odd
@@ -187,14 +216,15 @@ void mapper_mmc3_cpu_write(Mapper *m, uint16_t addr, uint8_t value) {
             regs->prg_ram_protect = (value >> 6) & 0x01; // bit 6
             // PRG RAM enable
             regs->prg_ram_enable = (value >> 7) & 0x01; // bit 7
+            mapper_mmc3_map_banks(m);
         } 
         // even
         else {
             // nametable mirroring
             if (value & 0x01) {
-                m->mirroring = MIRROR_HORIZONTAL;
+                mapper_set_mirroring(m, MIRROR_HORIZONTAL);
             } else {
-                m->mirroring = MIRROR_VERTICAL;
+                mapper_set_mirroring(m, MIRROR_VERTICAL);
             }
         }
     } 
@@ -225,233 +255,6 @@ void mapper_mmc3_cpu_write(Mapper *m, uint16_t addr, uint8_t value) {
     }
 }
 
-uint8_t mapper_mmc3_ppu_read(Mapper *m, uint16_t addr) {  
-    regs_mmc3 *regs = (regs_mmc3 *)m->regs;
-
-    if (regs->chr_bank_mode == 0) {
-        // two 2KB banks at 0x0000-0x0FFF, four 1KB banks at 0x1000-0x1FFF
-        if (addr >= 0x0000 && addr < 0x0800) {
-            // first 2KB bank 
-            uint8_t bank = regs->R0 & 0xFE; 
-            uint16_t offset = addr - 0x0000;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;  
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        } 
-        else if (addr >= 0x0800 && addr < 0x1000) {
-            // second 2KB bank 
-            uint8_t bank = regs->R1 & 0xFE;  
-            uint16_t offset = addr - 0x0800;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;  
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        } 
-        else if (addr >= 0x1000 && addr < 0x1400) {
-            // first 1KB bank
-            uint8_t bank = regs->R2;
-            uint16_t offset = addr - 0x1000;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        } 
-        else if (addr >= 0x1400 && addr < 0x1800) {
-            // second 1KB bank
-            uint8_t bank = regs->R3;
-            uint16_t offset = addr - 0x1400;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        } 
-        else if (addr >= 0x1800 && addr < 0x1C00) {
-            // third 1KB bank
-            uint8_t bank = regs->R4;
-            uint16_t offset = addr - 0x1800;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        }
-        else if (addr >= 0x1C00 && addr < 0x2000) {
-            // fourth 1KB bank
-            uint8_t bank = regs->R5;
-            uint16_t offset = addr - 0x1C00;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        }
-        return 0;
-    } else {
-        // four 1KB banks at 0x0000-0x0FFF, two 2KB banks at 0x1000-0x1FFF
-        if (addr >= 0x0000 && addr < 0x0400) {
-            // first 1KB bank
-            uint8_t bank = regs->R2;
-            uint16_t offset = addr - 0x0000;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        } 
-        else if (addr >= 0x0400 && addr < 0x0800) {
-            // second 1KB bank
-            uint8_t bank = regs->R3;
-            uint16_t offset = addr - 0x0400;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        } 
-        else if (addr >= 0x0800 && addr < 0x0C00) {
-            // third 1KB bank
-            uint8_t bank = regs->R4;
-            uint16_t offset = addr - 0x0800;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        } 
-        else if (addr >= 0x0C00 && addr < 0x1000) {
-            // fourth 1KB bank
-            uint8_t bank = regs->R5;
-            uint16_t offset = addr - 0x0C00;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        } 
-        else if (addr >= 0x1000 && addr < 0x1800) {
-            // first 2KB bank
-            uint8_t bank = regs->R0 & 0xFE;
-            uint16_t offset = addr - 0x1000;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        }
-        else if (addr >= 0x1800 && addr < 0x2000) {
-            // second 2KB bank
-            uint8_t bank = regs->R1 & 0xFE;
-            uint16_t offset = addr - 0x1800;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            return m->cart->chr_rom[chr_addr];
-        }
-        return 0;
-    }
-    return 0;
-}
-
-void mapper_mmc3_ppu_write(Mapper *m, uint16_t addr, uint8_t value) {    
-    regs_mmc3 *regs = (regs_mmc3 *)m->regs;
-
-    if (regs->chr_bank_mode == 0) {
-        // two 2KB banks at 0x0000-0x0FFF, four 1KB banks at 0x1000-0x1FFF
-        if (addr >= 0x0000 && addr < 0x0800) {
-            // first 2KB bank
-            uint8_t bank = regs->R0 & 0xFE; 
-            uint16_t offset = addr - 0x0000;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;  
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        } 
-        else if (addr >= 0x0800 && addr < 0x1000) {
-            // second 2KB bank
-            uint8_t bank = regs->R1 & 0xFE;
-            uint16_t offset = addr - 0x0800;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        } 
-        else if (addr >= 0x1000 && addr < 0x1400) {
-            // first 1KB bank
-            uint8_t bank = regs->R2;
-            uint16_t offset = addr - 0x1000;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        } 
-        else if (addr >= 0x1400 && addr < 0x1800) {
-            // second 1KB bank
-            uint8_t bank = regs->R3;
-            uint16_t offset = addr - 0x1400;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        } 
-        else if (addr >= 0x1800 && addr < 0x1C00) {
-            // third 1KB bank
-            uint8_t bank = regs->R4;
-            uint16_t offset = addr - 0x1800;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        }
-        else if (addr >= 0x1C00 && addr < 0x2000) {
-            // fourth 1KB bank
-            uint8_t bank = regs->R5;
-            uint16_t offset = addr - 0x1C00;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        }
-    } else {
-        // four 1KB banks at 0x0000-0x0FFF, two 2KB banks at 0x1000-0x1FFF
-        if (addr >= 0x0000 && addr < 0x0400) {
-            // first 1KB bank
-            uint8_t bank = regs->R2;
-            uint16_t offset = addr - 0x0000;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        } 
-        else if (addr >= 0x0400 && addr < 0x0800) {
-            // second 1KB bank
-            uint8_t bank = regs->R3;
-            uint16_t offset = addr - 0x0400;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        } 
-        else if (addr >= 0x0800 && addr < 0x0C00) {
-            // third 1KB bank
-            uint8_t bank = regs->R4;
-            uint16_t offset = addr - 0x0800;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        } 
-        else if (addr >= 0x0C00 && addr < 0x1000) {
-            // fourth 1KB bank
-            uint8_t bank = regs->R5;
-            uint16_t offset = addr - 0x0C00;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        } 
-        else if (addr >= 0x1000 && addr < 0x1800) {
-            // first 2KB bank
-            uint8_t bank = regs->R0 & 0xFE;
-            uint16_t offset = addr - 0x1000;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        }
-        else if (addr >= 0x1800 && addr < 0x2000) {
-            // second 2KB bank
-            uint8_t bank = regs->R1 & 0xFE;
-            uint16_t offset = addr - 0x1800;
-            uint32_t chr_addr = (bank * MMC3_CHR_BANK_SIZE_1K) + offset;
-            chr_addr = chr_addr % m->cart->chr_size;
-            m->cart->chr_rom[chr_addr] = value;
-            return;
-        }
-    }
-}
-
 void mapper_mmc3_irq_clock(Mapper *m) {
     regs_mmc3 *regs = (regs_mmc3 *)m->regs; 
 
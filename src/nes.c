@@ -2,47 +2,88 @@
 #include "../include/log.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-NES *nes = NULL; 
+int debug_enable = 0;
 
-void nes_init(char *rom_filename, char *save_filename, int display_flag) {
-    nes = (NES *)malloc(sizeof(NES)); 
+NES *nes_create(Cartridge *cart);
+static void sync_ppu(NES *nes);
+
+NES *nes_init(char *rom_filename, char *save_filename) {
+    printf("Initializing NES System...\n");
+
+    // load cartridge (before CPU init, since CPU reads reset vector from ROM)
+    Cartridge *cart = cart_init(rom_filename, save_filename);
+    return nes_create(cart);
+}
+
+NES *nes_init_shared(NES *source) {
+    printf("Initializing NES System (shared cartridge)...\n");
+
+    // new cartridge that shares the ROM data of the source console
+    Cartridge *cart = cart_share(source->mapper->cart);
+    return nes_create(cart);
+}
+
+NES *nes_create(Cartridge *cart) {
+    NES *nes = (NES *)malloc(sizeof(NES)); 
     if (nes == NULL) {
         fprintf(stderr, "Memory allocation for NES instance failed!\n");
         exit(1);
     }
-    printf("Initializing NES System...\n");
 
     // initialize Memory first (before CPU needs to read reset vector)
     memset(nes->ram, 0, RAM_SIZE);
     memset(nes->vram, 0, VRAM_SIZE);
 
-    // load cartridge and mapper (before CPU init, since CPU reads reset vector from ROM)
-    Cartridge *cart = cart_init(rom_filename, save_filename);
-    nes->mapper = mapper_init(cart);
+    nes->cycles = 0;
+    nes->next_event = 0;
+    nes->deadline = UINT64_MAX;
+    nes->idle_skip = 1;
+    nes->rgba_frame = NULL;
+    nes->rgba_frame_cycles = 0;
+    nes->breakpoint = 0;
+    nes->breakpoint_set = 0;
+    nes->at_breakpoint = 0;
+
+    // load mapper
+    nes->mapper = mapper_init(cart, nes->vram);
+
+    // internal RAM is mirrored every 2KB across 0x0000-0x1FFF, map it directly into the CPU pages
+    for (int i = 0; i < 0x2000 / CPU_PAGE_SIZE; i++) {
+        uint8_t *page = nes->ram + (i * CPU_PAGE_SIZE) % RAM_SIZE;
+        nes->mapper->cpu_read_map[i] = page;
+        nes->mapper->cpu_write_map[i] = page;
+    }
 
     // initialize CPU (now it can read the reset vector)
-    nes->cpu = cpu_init();
+    nes->cpu = cpu_init(nes);
 
     // initialize PPU
-    nes->ppu = ppu_init();
+    nes->ppu = ppu_init(nes);
 
     // initialize APU
-    nes->apu = apu_init();
+    nes->apu = apu_init(nes);
 
     // initialize controllers
     nes->controller1 = cntrl_init();
     nes->controller2 = cntrl_init();
 
-    // initialize display
-    nes->display = window_init(display_flag); // pass display flag for debug display
+    // nothing is due until the PPU reaches its first event
+    nes->deadline = UINT64_MAX;
+    nes_schedule(nes);
+
+    return nes;
 }
 
-void nes_free() {
+void nes_free(NES *nes) {
     if (nes) {
         if (nes->cpu) {
             cpu_free(nes->cpu);
         }
+        if (nes->rgba_frame) {
+            free(nes->rgba_frame);
+        }
         if (nes->ppu) {
             ppu_free(nes->ppu);
         }
@@ -61,50 +102,109 @@ void nes_free() {
         if (nes->mapper) {
             mapper_free(nes->mapper);   
         }
-        if (nes->display) {
-            free_display(nes->display);
-        }
         
         free(nes);
-        
-        nes = NULL;
     }
 }
 
-int nes_cycle(uint32_t *last_time, int debug_enable) {
+// runs one CPU instruction (or OAM DMA step) and the PPU dots that go with it
+// returns 1 if the PPU completed a frame
+static inline int nes_step(NES *nes, CPU *cpu, PPU *ppu) {
     // run cpu cycle (unless DMA in progress)
-    if (nes->ppu->oam_dma_transfer == 0) {
-        cpu_run_cycle(nes->cpu);
+    if (ppu->oam_dma_transfer == 0) {
+        cpu_run_cycle(cpu);
     } else {
-        ppu_oam_dma_transfer(nes->ppu);
-        nes->cpu->cycles = 2; // CPU is stalled for 514 cycles during OAM DMA (so 2 per transfer step)
-        nes->ppu->oam_dma_cycle++;
-        if (nes->ppu->oam_dma_cycle >= 256) {
-            nes->ppu->oam_dma_transfer = 0; // DMA complete
-            nes->ppu->oam_dma_cycle = 0;
-            nes->ppu->oam_dma_page = 0x00;
+        sync_ppu(nes); // OAM changes under the PPU
+        ppu_oam_dma_transfer(ppu);
+        cpu->cycles = 2; // CPU is stalled for 514 cycles during OAM DMA (so 2 per transfer step)
+        ppu->oam_dma_cycle++;
+        if (ppu->oam_dma_cycle >= 256) {
+            ppu->oam_dma_transfer = 0; // DMA complete
+            ppu->oam_dma_cycle = 0;
+            ppu->oam_dma_page = 0x00;
         }
     }
 
-    // run PPU (3 * cycles completed by CPU)
-    for (int i = 0; i < 3 * nes->cpu->cycles; i++) {
-        int frame_complete = ppu_run_cycle(nes->ppu);
-        if (frame_complete) {
-            // calculate FPS    
-            uint32_t curr_time = SDL_GetTicks();
-            if (nes->ppu->frames > 10) {
-                double elapsed = (double)(curr_time - *last_time) / 1000.0;
-                nes->ppu->FPS = nes->ppu->frames / elapsed;
-                nes->ppu->frames = 0;
-                *last_time = SDL_GetTicks();
-            }
+    return nes_tick(nes, cpu->cycles);
+}
+
+// The CPU runs freely and the rest of the console catches up only when it has to: when the CPU
+// accesses the PPU or the mapper (see sync_ppu), and once nes->cycles reaches next_event.
+// next_event is the earliest of the next PPU event (mapper IRQ clock, vblank NMI, end of frame),
+// the next DMC sample fetch, the end of the current run, and right now while an interrupt or an
+// OAM DMA is waiting, so the run loop checks all of them with a single compare after each
+// instruction.
+int nes_run_events(NES *nes) {
+    int frame_complete = ppu_catch_up(nes->ppu, nes->cycles);
+    apu_catch_up(nes->apu, nes->cycles);
+    nes_schedule(nes);
+    return frame_complete;
+}
+
+void nes_schedule(NES *nes) {
+    uint64_t next = ppu_next_event(nes->ppu);
+    if (nes->deadline < next) {
+        next = nes->deadline;
+    }
+    uint64_t apu_event = apu_next_event(nes->apu);
+    if (apu_event < next) {
+        next = apu_event;
+    }
+
+    // interrupts only become pending during a catch-up, or when RTI, CLI or PLP unmask IRQs that
+    // were held while the I flag was set
+    int irq = (nes->mapper->irq == 1 || nes->apu->irq == 1) && !(nes->cpu->P & FLAG_INT);
+    int interrupt = (nes->ppu->nmi == 1 || irq) && nes->cpu->service_int == 0;
+    if (interrupt || nes->ppu->oam_dma_transfer) {
+        next = 0;
+    }
+
+    nes->next_event = next;
+}
 
-            // render display
-            render_display(nes->display);
+// Skips whole iterations of an idle loop that has just closed (see cpu_idle_check), called by
+// the instruction that closes it. Each iteration takes the given number of cycles and repeats
+// the last one until something it reads can change: an event is due (a catch-up that may raise
+// an interrupt, the end of the run) or, for loops polling PPUSTATUS, one of its flags changes.
+// Every instruction boundary that is skipped comes before that cycle, so nes->cycles lands
+// exactly where running the iterations would have left it.
+void nes_idle_skip(NES *nes, uint64_t iteration, int reads_status) {
+    PPU *ppu = nes->ppu;
+
+    // the skipped iterations would only have synced the PPU, they do not need the rest of
+    // the line in lockstep
+    ppu_sync(ppu);
+    ppu->line_fallback = 0;
+    nes_schedule(nes);
+
+    uint64_t until = nes->next_event;
+    if (reads_status) {
+        // the loop has to have read the status the PPU still holds
+        if (ppu->PPUSTATUS != ppu->last_status) {
+            return;
         }
+        until = ppu_status_stable_until(ppu, until);
+    }
+
+    uint64_t end = nes->cycles + nes->cpu->cycles; // end of the closing instruction
+    if (end + iteration >= until) {
+        return;
     }
+    nes->cycles += (until - 1 - end) / iteration * iteration;
+}
+
+// brings the PPU up to the current cycle before anything reads or changes its state
+static void sync_ppu(NES *nes) {
+    ppu_sync(nes->ppu);
+    nes_schedule(nes);
+}
 
-    // APU cycle is called by the audio callback function
+int nes_cycle(NES *nes) {
+    int frame_complete = nes_step(nes, nes->cpu, nes->ppu);
+    sync_ppu(nes); // single stepping shows the PPU as of this instruction
+
+    // stepping onto the breakpoint counts as stopping there, so the next run steps past it
+    nes->at_breakpoint = nes->breakpoint_set && nes->cpu->PC == nes->breakpoint;
 
     // display register values if in debug mode
     if (debug_enable) {
@@ -114,18 +214,120 @@ int nes_cycle(uint32_t *last_time, int debug_enable) {
             nes->cpu->Y, 
             nes->cpu->PC, 
             nes->cpu->S, 
-            nes->cpu->P);
+            cpu_get_status(nes->cpu));
         DEBUG_MSG_PPU("PPU Registers: PPUCTRL=%02X PPUMASK=%02X PPUSTATUS=%02X",
             nes->ppu->PPUCTRL,
             nes->ppu->PPUMASK,
             nes->ppu->PPUSTATUS);
     }
 
-    return 1;
+    return frame_complete;
 }
 
+// runs instructions until a frame completes, nes->cycles reaches cycle or the breakpoint hits
+static int nes_run(NES *nes, uint64_t cycle) {
+    CPU *cpu = nes->cpu;
+    PPU *ppu = nes->ppu;
+
+    while (nes->cycles < cycle) {
+        // the CPU runs batches of instructions on its own, except while a breakpoint
+        // has to be checked before every instruction or an OAM DMA is stalling it
+        if (!nes->breakpoint_set && ppu->oam_dma_transfer == 0) {
+            if (cpu_run(cpu, cycle)) {
+                return NES_RUN_FRAME;
+            }
+            continue;
+        }
+
+        // stop before executing the instruction at the breakpoint
+        // (resuming from a breakpoint runs that instruction)
+        if (nes->breakpoint_set && cpu->PC == nes->breakpoint && !nes->at_breakpoint) {
+            nes->at_breakpoint = 1;
+            return NES_RUN_BREAKPOINT;
+        }
+        nes->at_breakpoint = 0;
+
+        if (nes_step(nes, cpu, ppu)) {
+            return NES_RUN_FRAME;
+        }
+    }
 
-uint8_t nes_cpu_read(uint16_t address) {
+    return NES_RUN_DEADLINE;
+}
+
+int nes_run_until(NES *nes, uint64_t cycle) {
+    int reason = nes_run(nes, cycle);
+    nes->deadline = UINT64_MAX; // cpu_run folds its deadline into the schedule
+
+    // callers see the PPU as of the last instruction that ran, this is not a CPU access
+    // so the rest of the line can still be batched
+    ppu_sync(nes->ppu);
+    nes->ppu->line_fallback = 0;
+    nes_schedule(nes);
+    apu_catch_up(nes->apu, nes->cycles); // queue the samples up to here
+    return reason;
+}
+
+int nes_run_frame(NES *nes) {
+    return nes_run_until(nes, UINT64_MAX);
+}
+
+void nes_set_dot_accurate(NES *nes, int enable) {
+    ppu_sync(nes->ppu);
+    nes->ppu->dot_accurate = enable;
+    nes->ppu->line_fallback = 0;
+    nes_schedule(nes);
+}
+
+void nes_set_idle_skip(NES *nes, int enable) {
+    nes->idle_skip = enable;
+}
+
+void nes_set_breakpoint(NES *nes, uint16_t address) {
+    nes->breakpoint = address;
+    nes->breakpoint_set = 1;
+}
+
+void nes_clear_breakpoint(NES *nes) {
+    nes->breakpoint_set = 0;
+    nes->at_breakpoint = 0;
+}
+
+const uint32_t *nes_get_framebuffer(NES *nes) {
+    // convert lazily, at most once per point in emulated time
+    if (!nes->rgba_frame) {
+        nes->rgba_frame = (uint32_t *)malloc(sizeof(uint32_t) * NES_WIDTH * NES_HEIGHT);
+        if (!nes->rgba_frame) {
+            FATAL_ERROR("NES", "Framebuffer allocation failed");
+        }
+    } else if (nes->rgba_frame_cycles == nes->cycles) {
+        return nes->rgba_frame;
+    }
+
+    ppu_convert_frame(nes->ppu, nes->rgba_frame, PIXEL_FORMAT_RGBA8888);
+    nes->rgba_frame_cycles = nes->cycles;
+    return nes->rgba_frame;
+}
+
+const uint8_t *nes_get_indexed_framebuffer(NES *nes) {
+    return nes->ppu->frame_buffer;
+}
+
+void nes_convert_framebuffer(NES *nes, uint32_t *dst, int format) {
+    ppu_convert_frame(nes->ppu, dst, format);
+}
+
+int nes_read_audio(NES *nes, int16_t *buffer, int samples) {
+    return apu_read_samples(nes->apu, buffer, samples);
+}
+
+void nes_set_controller(NES *nes, int port, uint8_t button_state) {
+    CNTRL *cntrl = (port == 0) ? nes->controller1 : nes->controller2;
+    cntrl->button_state = button_state;
+}
+
+// slow path for pages without a direct pointer (I/O registers and anything the mapper handles itself)
+uint8_t nes_cpu_read_slow(NES *nes, uint16_t address) {
     // fixed address space
     if (address < 0x6000) {
         // internal RAM and Mirrors
@@ -137,13 +339,17 @@ uint8_t nes_cpu_read(uint16_t address) {
         else if (address >= 0x2000 && address < 0x4000) {
             uint16_t reg_addr = 0x2000 + (address % 8);
             // ppu register read
+            sync_ppu(nes);
             return ppu_register_read(nes->ppu, reg_addr);
         } 
         // APU registers and IO
         else if (address >= 0x4015 && address <= 0x4017) {
             // apu register read
             if (address == 0x4015) { // only readable APU register
-                return apu_register_read(nes->apu, address);
+                apu_catch_up(nes->apu, nes->cycles);
+                uint8_t status = apu_register_read(nes->apu, address);
+                nes_schedule(nes); // acknowledging the frame IRQ lets the next one be scheduled
+                return status;
             }
             // controller 1
             else if (address == 0x4016) {  
@@ -170,7 +376,7 @@ uint8_t nes_cpu_read(uint16_t address) {
     return 0;
 }
 
-void nes_cpu_write(uint16_t address, uint8_t value) {
+void nes_cpu_write_slow(NES *nes, uint16_t address, uint8_t value) {
     // fixed address space
     if (address < 0x6000) {
         // internal RAM and Mirrors
@@ -183,13 +389,16 @@ void nes_cpu_write(uint16_t address, uint8_t value) {
         else if (address >= 0x2000 && address < 0x4000) {
             uint16_t reg_addr = 0x2000 + (address % 8);
             // ppu register write
+            sync_ppu(nes);
             ppu_register_write(nes->ppu, reg_addr, value);
             return;
         } 
         // APU and IO registers
         else if ((address >= 0x4000 && address <= 0x4013) || (address >= 0x4015 && address <= 0x4017)) {
-            // apu register write
+            // apu register write (takes effect at this cycle)
+            apu_catch_up(nes->apu, nes->cycles);
             apu_register_write(nes->apu, address, value);
+            nes_schedule(nes); // the DMC may have a new fetch or dropped its IRQ
             // controller 1
             if (address == 0x4016) {  
                 // controller write
@@ -208,12 +417,14 @@ void nes_cpu_write(uint16_t address, uint8_t value) {
             nes->ppu->oam_dma_transfer = 1;
             nes->ppu->oam_dma_page = value;
             nes->ppu->oam_dma_cycle = 0;
+            nes->next_event = 0; // the run loop hands the transfer to nes_step
             return;
         }
     } 
     // cartridge space (mapped by the mapper)
     else if (address >= 0x6000 && address <= CPU_MEMORY_SIZE) {
-        // mapper cpu write
+        // mapper cpu write (may switch CHR banks or mirroring under the PPU)
+        sync_ppu(nes);
         nes->mapper->cpu_write(nes->mapper, address, value);
         return;
     } 
@@ -222,49 +433,3 @@ void nes_cpu_write(uint16_t address, uint8_t value) {
         return; // open bus (not addressable)
     }
 }
-
-uint8_t nes_ppu_read(uint16_t address) {
-    // pattern tables (handled by the mapper)
-    if (address < 0x2000) {
-        return nes->mapper->ppu_read(nes->mapper, address);
-    }
-    // nametables and mirrors 
-    else if (address >= 0x2000 && address < 0x3F00) {
-        uint16_t addr_wrapped = 0x2000 + (address % 0x1000); // wrap to 0x2000-0x2FFF
-        uint16_t mirrored_addr = nes->mapper->mirror_nametable(nes->mapper, addr_wrapped);
-        uint16_t vram_index = (mirrored_addr - 0x2000) % VRAM_SIZE; // subtract base and ensure within 2KB bounds
-        return nes->vram[vram_index];
-    }
-    // pallette RAM and mirrors 
-    else if (address >= 0x3F00 && address <= PPU_MEMORY_SIZE) {
-        return 0; // handled internally by PPU 
-    }
-    // unmapped addresses
-    else {
-        return 0; // open bus (not addressable)
-    }
-}
-
-void nes_ppu_write(uint16_t address, uint8_t value) {
-    // pattern tables (handled by the mapper)
-    if (address < 0x2000) {
-        nes->mapper->ppu_write(nes->mapper, address, value);
-        return;
-    }
-    // nametables and mirrors 
-    else if (address >= 0x2000 && address < 0x3F00) {
-        uint16_t addr_wrapped = 0x2000 + (address % 0x1000); // wrap to 0x2000-0x2FFF
-        uint16_t mirrored_addr = nes->mapper->mirror_nametable(nes->mapper, addr_wrapped);
-        uint16_t vram_index = (mirrored_addr - 0x2000) % VRAM_SIZE; // subtract base and ensure within 2KB bounds
-        nes->vram[vram_index] = value;
-        return;
-    }
-    // pallette RAM and mirrors 
-    else if (address >= 0x3F00 && address <= PPU_MEMORY_SIZE) {
-        return; // handled internally by PPU 
-    }
-    // unmapped addresses
-    else {
-        return; // open bus (not addressable)
-    }
-}
\ No newline at end of file
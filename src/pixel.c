@@ -0,0 +1,171 @@
+#include <stdint.h>
+#include "../include/ppu.h"
+#include "../include/pixel.h"
+
+// the AVX2 kernel is compiled with a target attribute, so the rest of the core keeps the default -march
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXEL_X86
+#include <immintrin.h>
+#endif
+
+// channels that are not emphasized are dimmed to ~81.6% (fixed point, /256)
+#define EMPHASIS_ATTENUATION    209
+
+typedef void (*PixelKernel)(const uint8_t *src, uint32_t *dst, int count, const uint32_t *lut);
+
+void convert_scalar(const uint8_t *src, uint32_t *dst, int count, const uint32_t *lut);
+#ifdef PIXEL_X86
+void convert_avx2(const uint8_t *src, uint32_t *dst, int count, const uint32_t *lut);
+#endif
+void build_lut(uint32_t *lut, int format, int emphasis);
+
+static const char *kernel_names[PIXEL_KERNEL_COUNT] = { "scalar", "avx2" };
+
+static PixelKernel kernels[PIXEL_KERNEL_COUNT] = {
+    convert_scalar,
+#ifdef PIXEL_X86
+    convert_avx2,
+#else
+    convert_scalar,
+#endif
+};
+
+// lookup tables for every format and emphasis setting, built once by pixel_init
+static uint32_t luts[PIXEL_FORMAT_COUNT][PIXEL_EMPHASIS_COUNT][PIXEL_LUT_SIZE];
+static int pixel_ready = 0;
+static int active_kernel = PIXEL_KERNEL_SCALAR;
+
+void pixel_init() {
+    if (pixel_ready) {
+        return;
+    }
+
+    for (int format = 0; format < PIXEL_FORMAT_COUNT; format++) {
+        for (int emphasis = 0; emphasis < PIXEL_EMPHASIS_COUNT; emphasis++) {
+            build_lut(luts[format][emphasis], format, emphasis);
+        }
+    }
+
+    // prefer the widest kernel the CPU supports
+    active_kernel = PIXEL_KERNEL_SCALAR;
+    for (int kernel = PIXEL_KERNEL_COUNT - 1; kernel > PIXEL_KERNEL_SCALAR; kernel--) {
+        if (pixel_kernel_supported(kernel)) {
+            active_kernel = kernel;
+            break;
+        }
+    }
+
+    pixel_ready = 1;
+}
+
+const uint32_t *pixel_lut(int format, int emphasis) {
+    if (format < 0 || format >= PIXEL_FORMAT_COUNT) {
+        format = PIXEL_FORMAT_RGBA8888;
+    }
+    return luts[format][emphasis & (PIXEL_EMPHASIS_COUNT - 1)];
+}
+
+void pixel_convert(const uint8_t *src, uint32_t *dst, int count, const uint32_t *lut) {
+    kernels[active_kernel](src, dst, count, lut);
+}
+
+int pixel_kernel_supported(int kernel) {
+    switch (kernel) {
+        case PIXEL_KERNEL_SCALAR:
+            return 1;
+#ifdef PIXEL_X86
+        case PIXEL_KERNEL_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return 0;
+    }
+}
+
+int pixel_set_kernel(int kernel) {
+    if (!pixel_kernel_supported(kernel)) {
+        return 0;
+    }
+    active_kernel = kernel;
+    return 1;
+}
+
+int pixel_get_kernel() {
+    return active_kernel;
+}
+
+const char *pixel_kernel_name(int kernel) {
+    if (kernel < 0 || kernel >= PIXEL_KERNEL_COUNT) {
+        return "unknown";
+    }
+    return kernel_names[kernel];
+}
+
+// ====================== Kernels ======================
+
+void convert_scalar(const uint8_t *src, uint32_t *dst, int count, const uint32_t *lut) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = lut[src[i] & (PIXEL_LUT_SIZE - 1)];
+    }
+}
+
+#ifdef PIXEL_X86
+__attribute__((target("avx2")))
+void convert_avx2(const uint8_t *src, uint32_t *dst, int count, const uint32_t *lut) {
+    const __m256i index_mask = _mm256_set1_epi32(PIXEL_LUT_SIZE - 1);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        // widen 8 indices to 32 bits and gather their table entries, twice per iteration to overlap the gathers
+        __m256i index0 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i)));
+        __m256i index1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i + 8)));
+        index0 = _mm256_and_si256(index0, index_mask);
+        index1 = _mm256_and_si256(index1, index_mask);
+        __m256i pixels0 = _mm256_i32gather_epi32((const int *)lut, index0, 4);
+        __m256i pixels1 = _mm256_i32gather_epi32((const int *)lut, index1, 4);
+        _mm256_storeu_si256((__m256i *)(dst + i), pixels0);
+        _mm256_storeu_si256((__m256i *)(dst + i + 8), pixels1);
+    }
+
+    convert_scalar(src + i, dst + i, count - i, lut);
+}
+#endif
+
+// ====================== Lookup Tables ======================
+
+void build_lut(uint32_t *lut, int format, int emphasis) {
+    for (int i = 0; i < PIXEL_LUT_SIZE; i++) {
+        // greyscale keeps only the luminance bits of the index, like the PPU does (the grey column)
+        int index = i & PIXEL_COLOR_MASK;
+        if (i & PIXEL_GREYSCALE) {
+            index &= 0x30;
+        }
+        PaletteColor color = nes_palette[index];
+
+        // emphasis bits (red, green, blue from bit 0) dim the other two channels
+        if (emphasis) {
+            if (!(emphasis & (PPUMASK_R >> 5))) {
+                color.r = color.r * EMPHASIS_ATTENUATION / 256;
+            }
+            if (!(emphasis & (PPUMASK_G >> 5))) {
+                color.g = color.g * EMPHASIS_ATTENUATION / 256;
+            }
+            if (!(emphasis & (PPUMASK_B >> 5))) {
+                color.b = color.b * EMPHASIS_ATTENUATION / 256;
+            }
+        }
+
+        switch (format) {
+            case PIXEL_FORMAT_ARGB8888:
+                lut[i] = (0xFFu << 24) | (color.r << 16) | (color.g << 8) | color.b;
+                break;
+            case PIXEL_FORMAT_BGRA8888:
+                lut[i] = ((uint32_t)color.b << 24) | (color.g << 16) | (color.r << 8) | 0xFF;
+                break;
+            default: // PIXEL_FORMAT_RGBA8888
+                lut[i] = ((uint32_t)color.r << 24) | (color.g << 16) | (color.b << 8) | 0xFF;
+                break;
+        }
+    }
+}
@@ -5,12 +5,27 @@
 #include "../include/ppu.h"
 #include "../include/log.h"
 #include "../include/cpu.h"
-
-uint32_t calculate_pixel_color(PPU *ppu, int x, int y);
-uint32_t get_background_pixel(PPU *ppu, int *bg_transparent);
-uint32_t get_sprite_pixel(PPU *ppu, int x, int y, int *sprite_hit, int bg_transparent);
-
-PPU *ppu_init() {
+#include "../include/pixel.h"
+
+#define NO_SPRITE_PIXEL     0xFF // get_sprite_pixel: no opaque sprite pixel, the background shows
+#define NO_PIXEL_BLACK      0x0F // color index for black (rendering disabled, lines never drawn)
+
+uint8_t calculate_pixel_color(PPU *ppu, int x);
+uint8_t get_background_pixel(PPU *ppu, int *bg_transparent);
+uint8_t get_sprite_pixel(PPU *ppu, int *sprite_hit, int bg_transparent);
+void evaluate_sprites(PPU *ppu, int y);
+uint16_t reverse_pixels(uint16_t row);
+int run_all_dots(PPU *ppu, int dots);
+int dots_to_event(PPU *ppu);
+int dots_until(PPU *ppu, int last);
+int dots_to_dot(PPU *ppu, int scanline, int cycle);
+static inline void background_step(PPU *ppu, int phase, int rendering);
+void increment_scroll_x(PPU *ppu);
+void increment_scroll_y(PPU *ppu);
+void copy_scroll_x(PPU *ppu);
+void copy_scroll_y(PPU *ppu);
+
+PPU *ppu_init(NES *nes) {
     printf("Initializing PPU...");
 
     struct PPU *ppu = (struct PPU *)malloc(sizeof(struct PPU));
@@ -18,11 +33,16 @@ PPU *ppu_init() {
         printf("\tFAILED\n");
         FATAL_ERROR("PPU", "PPU memory allocation failed");
     }
+    ppu->nes = nes;
 
     // Initialize PPU memory 
     memset(ppu->oam, 0, OAM_SIZE);
     memset(ppu->palette_ram, 0, PALETTE_SIZE);
-    memset(ppu->frame_buffer, 0, NES_WIDTH * NES_HEIGHT);
+    memset(ppu->frame_buffer, NO_PIXEL_BLACK, NES_WIDTH * NES_HEIGHT);
+    memset(ppu->line_emphasis, 0, NES_HEIGHT);
+
+    // frame conversion tables and kernel (shared by all consoles)
+    pixel_init();
 
     // Set up register
     ppu->PPUCTRL = 0;
@@ -40,25 +60,36 @@ PPU *ppu_init() {
 
     ppu->bg_next_tile_id = 0x00;
     ppu->bg_next_tile_attrib = 0x00;
-    ppu->bg_next_tile_lsb = 0x00;
-    ppu->bg_next_tile_msb = 0x00;
-    ppu->bg_shifter_pattern_lo = 0x0000;
-    ppu->bg_shifter_pattern_hi = 0x0000;
+    ppu->bg_next_tile_row = 0x0000;
+    ppu->bg_shifter_pattern = 0x00000000;
     ppu->bg_shifter_attrib_lo = 0x0000;
     ppu->bg_shifter_attrib_hi = 0x0000;
 
+    memset(ppu->secondary_oam, 0xFF, SECONDARY_OAM_SIZE);
+    ppu->sprite_count = 0;
+    ppu->sprite_zero_selected = 0;
+
     ppu->w = 0;
     ppu->data_buffer = 0;
+    ppu->last_status = 0;
 
     ppu->nmi = 0;
 
+    // power up at the first dot of scanline 0
+    ppu->cycle = 0;
+    ppu->scanline = 0;
+
     ppu->oam_dma_transfer = 0; 
     ppu->oam_dma_page = 0x00; 
     ppu->oam_dma_cycle = 0; 
 
     // initialize frame counter
     ppu->frames = 0;
-    ppu->FPS = 0;
+
+    // dots are batched per line unless dot-accurate stepping is requested
+    ppu->dot_accurate = 0;
+    ppu->dot_clock = 0;
+    ppu->line_fallback = 0;
 
 
     printf("\tDONE\n");
@@ -71,6 +102,7 @@ void ppu_free(PPU *ppu) {
 
 int ppu_run_cycle(PPU *ppu) {
     int frame_complete = 0;
+    int rendering = ppu->PPUMASK & (PPUMASK_b | PPUMASK_s);
 
     // ============ Pre render scanline ============
     // scan line -1 (261)
@@ -94,109 +126,26 @@ int ppu_run_cycle(PPU *ppu) {
 
         // cycles 1-256 & 321-336: background fetching and shifter updates
         if ((ppu->cycle >= 3 && ppu->cycle <= 257) || (ppu->cycle >= 321 && ppu->cycle <= 338)) {
-
-            // update shifters if rendering is enabled
-            if (ppu->PPUMASK & (PPUMASK_b | PPUMASK_s)) {
-                ppu->bg_shifter_pattern_lo <<= 1;
-                ppu->bg_shifter_pattern_hi <<= 1;
-                ppu->bg_shifter_attrib_lo <<= 1;
-                ppu->bg_shifter_attrib_hi <<= 1; 
-            }
-
-            switch ((ppu->cycle - 1) % 8) {
-                case 0: {
-                    // load shifters
-                    ppu->bg_shifter_pattern_lo = (ppu->bg_shifter_pattern_lo & 0xFF00) | ppu->bg_next_tile_lsb;
-                    ppu->bg_shifter_pattern_hi = (ppu->bg_shifter_pattern_hi & 0xFF00) | ppu->bg_next_tile_msb;
-                    ppu->bg_shifter_attrib_lo  = (ppu->bg_shifter_attrib_lo & 0xFF00) | ((ppu->bg_next_tile_attrib & 0b01) ? 0xFF : 0x00);
-		            ppu->bg_shifter_attrib_hi  = (ppu->bg_shifter_attrib_hi & 0xFF00) | ((ppu->bg_next_tile_attrib & 0b10) ? 0xFF : 0x00);
-
-                    // fetch next tile id
-                    uint16_t v_addr = 0x2000 | (ppu->v & 0x0FFF);
-                    ppu->bg_next_tile_id = nes_ppu_read(v_addr);
-                    break; 
-                }
-                case 2: {
-                    // fetch attribute byte
-                    uint16_t v_addr = 0x23C0 | (ppu->v & 0x0C00) | ((ppu->v >> 4) & 0x38) | ((ppu->v >> 2) & 0x07);
-                    uint8_t attribute_byte = nes_ppu_read(v_addr);
-
-                    // extract palette bits based on coarse X and Y
-                    uint8_t shift = ((ppu->v >> 4) & 4) | (ppu->v & 2);
-                    ppu->bg_next_tile_attrib = (attribute_byte >> shift) & 0b11;
-                    break;
-                }
-                case 4: {
-                    // fetch low byte of tile bitmap
-                    uint16_t fine_y = (ppu->v >> 12) & 0x7;
-                    uint16_t base_table_addr = (ppu->PPUCTRL & PPUCNTRL_B) ? 0x1000 : 0x0000;
-                    uint16_t tile_addr = base_table_addr + (ppu->bg_next_tile_id * 16) + fine_y;
-                    ppu->bg_next_tile_lsb = nes_ppu_read(tile_addr);
-                    break;
-                }
-                case 6: {
-                    // fetch high byte of tile bitmap
-                    uint16_t fine_y = (ppu->v >> 12) & 0x7;
-                    uint16_t base_table_addr = (ppu->PPUCTRL & PPUCNTRL_B) ? 0x1000 : 0x0000;
-                    uint16_t tile_addr = base_table_addr + (ppu->bg_next_tile_id * 16) + fine_y + 8;
-                    ppu->bg_next_tile_msb = nes_ppu_read(tile_addr);
-                    break;
-                }
-                case 7: {
-                    // increment horizontal position in v
-                    if (ppu->PPUMASK & (PPUMASK_b | PPUMASK_s)) {
-                        if ((ppu->v & 0x001F) == 31) {
-                            ppu->v &= ~0x001F;          // coarse X = 0
-                            ppu->v ^= 0x0400;           // switch horizontal nametable
-                        } else {
-                            ppu->v += 1;                 // increment coarse X
-                        }
-                    }
-                }
-            }
+            background_step(ppu, (ppu->cycle - 1) % 8, rendering);
         }
 
         if (ppu->cycle == 256) {
             // increment vertical position in v
-            if (ppu->PPUMASK & (PPUMASK_b | PPUMASK_s)) {
-                if ((ppu->v & 0x7000) != 0x7000) {
-                    ppu->v += 0x1000; // increment fine Y
-                } else {
-                    ppu->v &= ~0x7000; // fine Y = 0
-                    uint16_t coarse_y = (ppu->v & 0x03E0) >> 5;
-                    if (coarse_y == 29) {
-                        coarse_y = 0;
-                        ppu->v ^= 0x0800; // switch vertical nametable
-                    } else if (coarse_y == 31) {
-                        coarse_y = 0; // wrap around
-                    } else {
-                        coarse_y += 1; // increment coarse Y
-                    }
-                    ppu->v = (ppu->v & ~0x03E0) | (coarse_y << 5);
-                }
+            if (rendering) {
+                increment_scroll_y(ppu);
             }
         }
 
         if (ppu->cycle == 257) {
             // copy horizontal bits from t to v
-            if (ppu->PPUMASK & (PPUMASK_b | PPUMASK_s)) {
-                ppu->v = (ppu->v & 0xFBE0) | (ppu->t & 0x041F);
+            if (rendering) {
+                copy_scroll_x(ppu);
             }
         }
 
         // Sprite evaluation for next scanline
         if (ppu->cycle == 257) {
-            int sprite_count = 0;
-            for (int i = 0; i < 64; i++) {
-                int diff = ppu->scanline - ppu->oam[i*4];
-                int height = (ppu->PPUCTRL & PPUCNTRL_H) ? 16 : 8;
-                if (diff >= 0 && diff < height) {
-                    sprite_count++;
-                }
-            }
-            if (sprite_count > 8) {
-                ppu->PPUSTATUS |= PPUSTATUS_O;
-            }
+            evaluate_sprites(ppu, ppu->scanline);
         }
 
         // OAMADDR reset
@@ -207,14 +156,14 @@ int ppu_run_cycle(PPU *ppu) {
         if (ppu->cycle == 338 || ppu->cycle == 340) {
             // fetch next tile id (odd frame skip)
             uint16_t v_addr = 0x2000 | (ppu->v & 0x0FFF);
-            ppu->bg_next_tile_id = nes_ppu_read(v_addr);
+            ppu->bg_next_tile_id = nes_ppu_read(ppu->nes, v_addr);
         }
 
         if (ppu->scanline == -1 && ppu->cycle >= 280 && ppu->cycle < 305)
 		{
             // copy vertical bits from t to v during pre-render scanline
-            if (ppu->PPUMASK & (PPUMASK_b | PPUMASK_s)) {
-                ppu->v = (ppu->v & 0x041F) | (ppu->t & 0xFBE0);
+            if (rendering) {
+                copy_scroll_y(ppu);
             }
 		}
 
@@ -222,14 +171,17 @@ int ppu_run_cycle(PPU *ppu) {
         if (ppu->scanline >= 1 && ppu->cycle >= 1 && ppu->cycle <= 256) {
             int x = ppu->cycle - 1;
             int y = ppu->scanline - 1;
-            ppu->frame_buffer[y * 256 + x] = calculate_pixel_color(ppu, x, y);
+            if (x == 0) {
+                ppu->line_emphasis[y] = ppu->PPUMASK >> 5;
+            }
+            ppu->frame_buffer[y * 256 + x] = calculate_pixel_color(ppu, x);
         }
 
         // MMC3 IRQ clocking
-        if (ppu->PPUMASK & (PPUMASK_b | PPUMASK_s)) { // check if rendering enabled
+        if (rendering) { // check if rendering enabled
             if (ppu->cycle == 260) {
-                if (nes->mapper->irq_clock) {
-                    nes->mapper->irq_clock(nes->mapper);
+                if (ppu->nes->mapper->irq_clock) {
+                    ppu->nes->mapper->irq_clock(ppu->nes->mapper);
                 }
             }
         }
@@ -272,12 +224,413 @@ int ppu_run_cycle(PPU *ppu) {
     return frame_complete;
 }
 
-uint32_t calculate_pixel_color(PPU *ppu, int x, int y) {
+// Runs dots ppu->cycle to last of the pre-render or a visible line (scanline -1 to 239) in one
+// call. Gives the same result as ppu_run_cycle for each of those dots as long as nothing else
+// touches the PPU in between, which is what ppu_catch_up guarantees for the spans it hands over.
+void ppu_run_line(PPU *ppu, int last) {
+    int rendering = ppu->PPUMASK & (PPUMASK_b | PPUMASK_s);
+    int scanline = ppu->scanline;
+    int cycle = ppu->cycle;
+
+    // dot 0 is idle (and skipped on line 0)
+    if (cycle == 0) {
+        cycle = 1;
+    }
+
+    if (scanline == -1 && cycle == 1) {
+        ppu->PPUSTATUS &= ~(PPUSTATUS_V | PPUSTATUS_S | PPUSTATUS_O);
+    }
+
+    // dots 1-256: background fetches and pixels (pixels of line y are drawn during scanline y + 1)
+    uint8_t *row = NULL;
+    if (scanline >= 1) {
+        row = &ppu->frame_buffer[(scanline - 1) * NES_WIDTH];
+        if (cycle == 1) {
+            ppu->line_emphasis[scanline - 1] = ppu->PPUMASK >> 5;
+        }
+    }
+
+    int increment_y = rendering && cycle <= 256 && last >= 256;
+    int visible_last = (last < 256) ? last : 256;
+    for (; cycle <= visible_last; cycle++) {
+        if (cycle >= 3) {
+            background_step(ppu, (cycle - 1) & 7, rendering);
+        }
+        if (row) {
+            row[cycle - 1] = calculate_pixel_color(ppu, cycle - 1);
+        }
+    }
+    if (increment_y) {
+        increment_scroll_y(ppu); // dot 256
+    }
+
+    // dots 257-340: sprite evaluation, scroll copies, mapper IRQ and the next line's first two tiles
+    if (cycle <= last) {
+        if (cycle == 257) {
+            background_step(ppu, 0, rendering);
+            if (rendering) {
+                copy_scroll_x(ppu);
+            }
+            evaluate_sprites(ppu, scanline);
+        }
+        if (cycle <= 320) {
+            ppu->OAMADDR = 0;
+        }
+        if (rendering && scanline == -1 && cycle <= 304 && last >= 280) {
+            copy_scroll_y(ppu);
+        }
+        if (rendering && cycle <= 260 && last >= 260 && ppu->nes->mapper->irq_clock) {
+            ppu->nes->mapper->irq_clock(ppu->nes->mapper);
+        }
+
+        int fetch_first = (cycle > 321) ? cycle : 321;
+        int fetch_last = (last < 338) ? last : 338;
+        for (int c = fetch_first; c <= fetch_last; c++) {
+            background_step(ppu, (c - 1) & 7, rendering);
+        }
+
+        if ((cycle <= 338 && last >= 338) || last == 340) {
+            uint16_t v_addr = 0x2000 | (ppu->v & 0x0FFF);
+            ppu->bg_next_tile_id = nes_ppu_read(ppu->nes, v_addr);
+        }
+    }
+
+    ppu->cycle = last + 1;
+    if (ppu->cycle > 340) {
+        ppu->cycle = 0;
+        ppu->scanline++;
+    }
+}
+
+// Runs up to *dots dots (counted like ppu_run_cycle calls) and subtracts the ones it ran. Jumps
+// straight between the phases of the frame: pre-render and visible lines run as spans through
+// ppu_run_line, the post-render and vblank lines are skipped in one step except for the vblank
+// dot. Stops early right after the dot that completes a frame (PPU_RUN_FRAME) or raises the
+// vblank NMI (PPU_RUN_NMI), otherwise returns PPU_RUN_DONE once all dots ran.
+int ppu_run_dots(PPU *ppu, int *dots) {
+    while (*dots > 0) {
+        // pre-render and visible lines: the rest of the line or as many dots as are left
+        if (ppu->scanline <= 239) {
+            int skip = (ppu->scanline == 0 && ppu->cycle == 0); // dot 0 is skipped on line 0
+            int last = ppu->cycle + *dots - 1 + skip;
+            if (last > 340) {
+                last = 340;
+            }
+            *dots -= dots_until(ppu, last);
+            ppu_run_line(ppu, last);
+            continue;
+        }
+
+        // vblank flag and NMI on dot 1 of line 241
+        if (ppu->scanline == 241 && ppu->cycle <= 1) {
+            int nmi = ppu->nmi;
+            ppu_run_cycle(ppu);
+            (*dots)--;
+            if (!nmi && ppu->nmi) {
+                return PPU_RUN_NMI;
+            }
+            continue;
+        }
+
+        // idle dots: line 240 up to line 241, or the vblank lines up to the end of the frame
+        int last_line = (ppu->scanline == 240) ? 240 : 260;
+        int idle = (last_line - ppu->scanline) * 341 + 341 - ppu->cycle;
+        if (*dots < idle) {
+            int position = ppu->cycle + *dots;
+            ppu->scanline += position / 341;
+            ppu->cycle = position % 341;
+            *dots = 0;
+            break;
+        }
+
+        *dots -= idle;
+        ppu->cycle = 0;
+        ppu->scanline = last_line + 1;
+        if (ppu->scanline >= 261) {
+            ppu->scanline = -1; // pre-render scanline
+            ppu->frames++;
+            return PPU_RUN_FRAME;
+        }
+    }
+
+    return PPU_RUN_DONE;
+}
+
+// Runs the dots owed up to CPU cycle (3 per cycle) in batches through ppu_run_dots, each ending on
+// the next dot whose effects the CPU sees without touching the PPU (mapper IRQ on dot 260, vblank
+// NMI, end of frame) or at the end of a rendered line. Dots short of the next batch stay owed until
+// a later catch-up or ppu_sync. Unless dot_accurate is set, the scheduler only calls this once
+// ppu_next_event is due. Returns 1 if a frame was completed.
+int ppu_catch_up(PPU *ppu, uint64_t cycle) {
+    int frame_complete = 0;
+    int dots = (int)(3 * cycle - ppu->dot_clock);
+
+    if (ppu->dot_accurate) {
+        ppu->dot_clock += dots;
+        for (; dots > 0; dots--) {
+            frame_complete |= ppu_run_cycle(ppu);
+        }
+        return frame_complete;
+    }
+
+    // the rest of a line that was synced mid-line runs in lockstep with the CPU
+    if (ppu->line_fallback) {
+        int line_dots = dots_until(ppu, 340);
+        int lockstep = (dots < line_dots) ? dots : line_dots;
+        dots -= lockstep;
+        ppu->dot_clock += lockstep;
+        frame_complete |= run_all_dots(ppu, lockstep);
+        if (ppu->cycle == 0) {
+            ppu->line_fallback = 0;
+        }
+    }
+
+    while (1) {
+        int span = dots_to_event(ppu);
+        if (dots < span) {
+            break;
+        }
+        dots -= span;
+        ppu->dot_clock += span;
+        frame_complete |= run_all_dots(ppu, span);
+    }
+
+    return frame_complete;
+}
+
+// CPU cycle at which ppu_catch_up has the next batch to run, which is the next instruction
+// while stepping dot by dot or in lockstep
+uint64_t ppu_next_event(PPU *ppu) {
+    if (ppu->dot_accurate || ppu->line_fallback) {
+        return ppu->nes->cycles + 1;
+    }
+    return (ppu->dot_clock + dots_to_event(ppu) + 2) / 3;
+}
+
+// Runs the owed dots so the PPU is exactly where stepping it after every instruction would have
+// left it. A sync that lands mid-line switches the rest of that line to lockstep.
+void ppu_sync(PPU *ppu) {
+    // owed dots never reach the next event dot
+    uint64_t target = 3 * ppu->nes->cycles;
+    run_all_dots(ppu, (int)(target - ppu->dot_clock));
+    ppu->dot_clock = target;
+
+    if (ppu->cycle != 0 && !ppu->dot_accurate) {
+        ppu->line_fallback = 1;
+    }
+}
+
+// First CPU cycle at which a PPUSTATUS read may no longer return the current value, or until if
+// that comes first, for a PPU that has just been synced and whose registers and OAM are not
+// written in the meantime: the vblank flag is set on dot 1 of line 241 and all flags are cleared
+// on dot 1 of the pre-render line, sprite 0 hit can only be set on the lines around sprite 0
+// and sprite overflow only by the evaluation (dot 257) of a line with more than 8 sprites.
+uint64_t ppu_status_stable_until(PPU *ppu, uint64_t until) {
+    if (until <= ppu->nes->cycles) {
+        return until;
+    }
+
+    // reads at CPU cycle t see the dots before dot clock 3 * t
+    uint64_t limit = 3 * (until - 1) - ppu->dot_clock;
+    int dots = (limit < 262 * 341) ? (int)limit : 262 * 341;
+
+    int vblank = dots_to_dot(ppu, 241, 1);
+    int clear = dots_to_dot(ppu, -1, 1);
+    dots = (vblank < dots) ? vblank : dots;
+    dots = (clear < dots) ? clear : dots;
+
+    int sprite_height = (ppu->PPUCTRL & PPUCNTRL_H) ? 16 : 8;
+
+    // sprite 0 hit needs both background and sprites and can land on lines oam[0] + 1 to
+    // oam[0] + sprite_height, with a line of margin on either side
+    int both = PPUMASK_b | PPUMASK_s;
+    if (!(ppu->PPUSTATUS & PPUSTATUS_S) && (ppu->PPUMASK & both) == both && ppu->scanline <= 239) {
+        int first = ppu->oam[0];
+        int last = first + sprite_height + 1;
+        if (ppu->scanline >= first && ppu->scanline <= last) {
+            return ppu->nes->cycles;
+        }
+        if (ppu->scanline < first && first <= 239) {
+            int hit = dots_to_dot(ppu, first, 0);
+            dots = (hit < dots) ? hit : dots;
+        }
+    }
+
+    // sprite overflow is set by the evaluation of any line with more than 8 sprites on it,
+    // only the evaluations before the bound so far matter
+    if (!(ppu->PPUSTATUS & PPUSTATUS_O)) {
+        int first = (ppu->cycle <= 257) ? ppu->scanline : ppu->scanline + 1;
+        for (int y = (first < 0) ? 0 : first; y <= 239; y++) {
+            int evaluation = dots_to_dot(ppu, y, 257);
+            if (evaluation >= dots) {
+                break;
+            }
+            int in_range = 0;
+            for (int i = 0; i < 64; i++) {
+                int diff = y - ppu->oam[i * 4];
+                in_range += (diff >= 0 && diff < sprite_height);
+            }
+            if (in_range > MAX_LINE_SPRITES) {
+                dots = evaluation;
+                break;
+            }
+        }
+    }
+
+    uint64_t stable = (ppu->dot_clock + dots) / 3 + 1;
+    return (stable < until) ? stable : until;
+}
+
+// number of dots before dot cycle of the given line is run, counting from the current dot and
+// wrapping into the next frame if that dot has passed (one less than the exact count when dot 0
+// of line 0 is skipped on the way, so never more than the exact count)
+int dots_to_dot(PPU *ppu, int scanline, int cycle) {
+    int current = (ppu->scanline + 1) * 341 + ppu->cycle;
+    int target = (scanline + 1) * 341 + cycle;
+    if (target < current) {
+        target += 262 * 341;
+    }
+    return (target > current) ? target - current - 1 : 0;
+}
+
+// runs ppu_run_dots until all dots ran, returns 1 if a frame was completed
+int run_all_dots(PPU *ppu, int dots) {
+    int frame_complete = 0;
+    while (dots > 0) {
+        if (ppu_run_dots(ppu, &dots) == PPU_RUN_FRAME) {
+            frame_complete = 1;
+        }
+    }
+    return frame_complete;
+}
+
+// number of dots up to and including the next event dot (mapper IRQ clock on rendered lines,
+// vblank NMI, end of frame) or the end of the current rendered line
+int dots_to_event(PPU *ppu) {
+    if (ppu->scanline <= 239) {
+        if (ppu->nes->mapper->irq_clock && ppu->cycle <= 260) {
+            return dots_until(ppu, 260);
+        }
+        return dots_until(ppu, 340);
+    }
+    if (ppu->scanline == 240) {
+        return 341 - ppu->cycle + 2; // through dot 1 of line 241
+    }
+    if (ppu->scanline == 241 && ppu->cycle <= 1) {
+        return 2 - ppu->cycle;
+    }
+    return (260 - ppu->scanline) * 341 + 341 - ppu->cycle;
+}
+
+// number of ppu_run_cycle calls it takes to run up to and including dot last of the current line
+int dots_until(PPU *ppu, int last) {
+    int dots = last - ppu->cycle + 1;
+    if (ppu->scanline == 0 && ppu->cycle == 0) {
+        dots--; // dot 0 is skipped on line 0
+    }
+    return dots;
+}
+
+// background shifters and fetches for dots 3-257 and 321-338, phase is (cycle - 1) % 8
+static inline void background_step(PPU *ppu, int phase, int rendering) {
+    // update shifters if rendering is enabled
+    if (rendering) {
+        ppu->bg_shifter_pattern <<= 2;
+        ppu->bg_shifter_attrib_lo <<= 1;
+        ppu->bg_shifter_attrib_hi <<= 1; 
+    }
+
+    switch (phase) {
+        case 0: {
+            // load shifters
+            ppu->bg_shifter_pattern = (ppu->bg_shifter_pattern & 0xFFFF0000) | ppu->bg_next_tile_row;
+            ppu->bg_shifter_attrib_lo  = (ppu->bg_shifter_attrib_lo & 0xFF00) | ((ppu->bg_next_tile_attrib & 0b01) ? 0xFF : 0x00);
+            ppu->bg_shifter_attrib_hi  = (ppu->bg_shifter_attrib_hi & 0xFF00) | ((ppu->bg_next_tile_attrib & 0b10) ? 0xFF : 0x00);
+
+            // fetch next tile id
+            uint16_t v_addr = 0x2000 | (ppu->v & 0x0FFF);
+            ppu->bg_next_tile_id = nes_ppu_read(ppu->nes, v_addr);
+            break; 
+        }
+        case 2: {
+            // fetch attribute byte
+            uint16_t v_addr = 0x23C0 | (ppu->v & 0x0C00) | ((ppu->v >> 4) & 0x38) | ((ppu->v >> 2) & 0x07);
+            uint8_t attribute_byte = nes_ppu_read(ppu->nes, v_addr);
+
+            // extract palette bits based on coarse X and Y
+            uint8_t shift = ((ppu->v >> 4) & 4) | (ppu->v & 2);
+            ppu->bg_next_tile_attrib = (attribute_byte >> shift) & 0b11;
+            break;
+        }
+        case 4: {
+            // fetch low bitplane of tile bitmap (pre-decoded by the tile cache)
+            uint16_t fine_y = (ppu->v >> 12) & 0x7;
+            uint16_t base_table_addr = (ppu->PPUCTRL & PPUCNTRL_B) ? 0x1000 : 0x0000;
+            uint16_t tile_addr = base_table_addr + (ppu->bg_next_tile_id * 16) + fine_y;
+            ppu->bg_next_tile_row = nes_ppu_read_tile_row(ppu->nes, tile_addr) & TILE_ROW_PLANE0;
+            break;
+        }
+        case 6: {
+            // fetch high bitplane of tile bitmap (kept as a separate fetch so mid-tile bank and
+            // PPUCTRL changes land on the same dot as on hardware)
+            uint16_t fine_y = (ppu->v >> 12) & 0x7;
+            uint16_t base_table_addr = (ppu->PPUCTRL & PPUCNTRL_B) ? 0x1000 : 0x0000;
+            uint16_t tile_addr = base_table_addr + (ppu->bg_next_tile_id * 16) + fine_y;
+            ppu->bg_next_tile_row |= nes_ppu_read_tile_row(ppu->nes, tile_addr) & TILE_ROW_PLANE1;
+            break;
+        }
+        case 7: {
+            // increment horizontal position in v
+            if (rendering) {
+                increment_scroll_x(ppu);
+            }
+        }
+    }
+}
+
+void increment_scroll_x(PPU *ppu) {
+    if ((ppu->v & 0x001F) == 31) {
+        ppu->v &= ~0x001F;          // coarse X = 0
+        ppu->v ^= 0x0400;           // switch horizontal nametable
+    } else {
+        ppu->v += 1;                 // increment coarse X
+    }
+}
+
+void increment_scroll_y(PPU *ppu) {
+    if ((ppu->v & 0x7000) != 0x7000) {
+        ppu->v += 0x1000; // increment fine Y
+    } else {
+        ppu->v &= ~0x7000; // fine Y = 0
+        uint16_t coarse_y = (ppu->v & 0x03E0) >> 5;
+        if (coarse_y == 29) {
+            coarse_y = 0;
+            ppu->v ^= 0x0800; // switch vertical nametable
+        } else if (coarse_y == 31) {
+            coarse_y = 0; // wrap around
+        } else {
+            coarse_y += 1; // increment coarse Y
+        }
+        ppu->v = (ppu->v & ~0x03E0) | (coarse_y << 5);
+    }
+}
+
+// copy horizontal bits from t to v
+void copy_scroll_x(PPU *ppu) {
+    ppu->v = (ppu->v & 0xFBE0) | (ppu->t & 0x041F);
+}
+
+// copy vertical bits from t to v
+void copy_scroll_y(PPU *ppu) {
+    ppu->v = (ppu->v & 0x041F) | (ppu->t & 0xFBE0);
+}
+
+uint8_t calculate_pixel_color(PPU *ppu, int x) {
     int sprite_hit = 0;
     int bg_transparent = 0;
 
-    uint32_t bg_color = get_background_pixel(ppu, &bg_transparent);
-    uint32_t sprite_color = get_sprite_pixel(ppu, x, y, &sprite_hit, bg_transparent);
+    uint8_t bg_color = get_background_pixel(ppu, &bg_transparent);
+    uint8_t sprite_color = get_sprite_pixel(ppu, &sprite_hit, bg_transparent);
 
     // handle sprite 0 hit logic
     if (sprite_hit) {
@@ -292,22 +645,26 @@ uint32_t calculate_pixel_color(PPU *ppu, int x, int y) {
         }
     }
 
-    return sprite_color != 0 ? sprite_color : bg_color;
+    uint8_t pixel = sprite_color != NO_SPRITE_PIXEL ? sprite_color : bg_color;
+
+    // greyscale applies to every pixel (resolved when the frame is converted)
+    if (ppu->PPUMASK & PPUMASK_Gr) {
+        pixel |= PIXEL_GREYSCALE;
+    }
+    return pixel;
 }
 
-uint32_t get_background_pixel(PPU *ppu, int *bg_transparent) {
+uint8_t get_background_pixel(PPU *ppu, int *bg_transparent) {
     if (!(ppu->PPUMASK & PPUMASK_b)) {
         // background rendering is disabled
-        return 0x000000FF;
+        return NO_PIXEL_BLACK;
     }
 
     // get the bit corresponding to the current fine x scroll
     uint16_t bit_mux = 0x8000 >> ppu->x;
 
-    // extract the two bits for the pixel from the pattern shifters
-    uint8_t p0_pixel = (ppu->bg_shifter_pattern_lo & bit_mux) ? 1 : 0;
-    uint8_t p1_pixel = (ppu->bg_shifter_pattern_hi & bit_mux) ? 1 : 0;
-    uint8_t bg_pixel = (p1_pixel << 1) | p0_pixel;
+    // extract the two bits for the pixel from the pattern shifter
+    uint8_t bg_pixel = (ppu->bg_shifter_pattern >> (30 - 2 * ppu->x)) & 0x03;
 
     // extract the two bits for the palette from the attribute shifters
     uint8_t bg_pal0 = (ppu->bg_shifter_attrib_lo & bit_mux) ? 1 : 0;
@@ -319,53 +676,58 @@ uint32_t get_background_pixel(PPU *ppu, int *bg_transparent) {
     if (bg_pixel != 0) {
         color_id = ppu->palette_ram[(bg_palette << 2) + bg_pixel] & 0x3F;
     } else {
-        color_id = ppu->palette_ram[0]; // background color
+        color_id = ppu->palette_ram[0] & 0x3F; // background color
         *bg_transparent = 1;
     }
 
-    SDL_Color sdl_bg_color = nes_palette[color_id];
-    return (sdl_bg_color.r << 24) | (sdl_bg_color.g << 16) | (sdl_bg_color.b << 8) | 0xFF;
+    return color_id;
 }
 
-uint32_t get_sprite_pixel(PPU *ppu, int x, int y, int *sprite_hit, int bg_transparent) {    
-    if (!(ppu->PPUMASK & PPUMASK_s)) {
-        // sprite rendering is disabled
-        return 0x00000000; // transparent
-    }
+// selects the sprites on row y (up to 8) into secondary OAM, sets sprite overflow and
+// prefetches their pattern rows into the sprite shifters
+void evaluate_sprites(PPU *ppu, int y) {
+    int sprite_height = (ppu->PPUCTRL & PPUCNTRL_H) ? 16 : 8;
+    int in_range = 0;
 
-    uint32_t sprite_color = 0x00000000; // black 
+    memset(ppu->secondary_oam, 0xFF, SECONDARY_OAM_SIZE);
+    ppu->sprite_count = 0;
+    ppu->sprite_zero_selected = 0;
 
-    // loop through all 64 sprites in OAM
     for (int i = 0; i < 64; i++) {
-        int base = i * 4;
-        uint8_t sprite_y = ppu->oam[base]; // Y position of sprite
-        uint8_t tile_index = ppu->oam[base + 1]; // tile index
-        uint8_t attr = ppu->oam[base + 2]; // attributes
-        uint8_t sprite_x = ppu->oam[base + 3]; // X position of sprite
-
-        // calculate height based on mode
-        int sprite_height = (ppu->PPUCTRL & PPUCNTRL_H) ? 16 : 8; 
-
-        // check if this sprite is visible at (x, y)
-        if (x < sprite_x || x >= sprite_x + 8 || y < sprite_y || y >= sprite_y + sprite_height) {
-            // skip to next sprite
+        int diff = y - ppu->oam[i * 4];
+        if (diff < 0 || diff >= sprite_height) {
             continue;
         }
 
-        // calculate pixel within sprite
-        int sx = x - sprite_x;
-        int sy = y - sprite_y;  
-
-        // handle horizontal flipping
-        if (attr & 0x40) { 
-            sx = 7 - sx;
+        in_range++;
+        if (ppu->sprite_count < MAX_LINE_SPRITES) {
+            if (i == 0) {
+                ppu->sprite_zero_selected = 1;
+            }
+            memcpy(&ppu->secondary_oam[ppu->sprite_count * 4], &ppu->oam[i * 4], 4);
+            ppu->sprite_count++;
         }
+    }
+
+    if (in_range > MAX_LINE_SPRITES) {
+        ppu->PPUSTATUS |= PPUSTATUS_O;
+    }
+
+    // fetch the pattern row of each selected sprite
+    for (int i = 0; i < ppu->sprite_count; i++) {
+        uint8_t sprite_y = ppu->secondary_oam[i * 4]; // Y position of sprite
+        uint8_t tile_index = ppu->secondary_oam[i * 4 + 1]; // tile index
+        uint8_t attr = ppu->secondary_oam[i * 4 + 2]; // attributes
+        uint8_t sprite_x = ppu->secondary_oam[i * 4 + 3]; // X position of sprite
+
+        // row within sprite
+        int sy = y - sprite_y;
+
         // handle vertical flipping
         if (attr & 0x80) {
             sy = sprite_height - 1 - sy;
         }
 
-        // fetch tile data
         uint16_t tile_addr;
         if (sprite_height == 8) {
             uint16_t pattern_table = (ppu->PPUCTRL & PPUCNTRL_S) ? 0x1000 : 0x0000;
@@ -382,55 +744,88 @@ uint32_t get_sprite_pixel(PPU *ppu, int x, int y, int *sprite_hit, int bg_transp
             }
         }
 
-        // get the two bitplanes for the pixel
-        uint8_t plane0 = nes_ppu_read((tile_addr + sy) & 0x1FFF);
-        uint8_t plane1 = nes_ppu_read((tile_addr + sy + 8) & 0x1FFF);
+        uint16_t row = nes_ppu_read_tile_row(ppu->nes, (tile_addr + sy) & 0x1FFF);
 
-        // extract pixel color
-        int bit = 7 - sx;
-        uint8_t p0 = (plane0 >> bit) & 1;
-        uint8_t p1 = (plane1 >> bit) & 1;
-        uint8_t color_id = (p1 << 1) | p0;
+        // handle horizontal flipping (shifters always shift out the leftmost pixel first)
+        if (attr & 0x40) {
+            row = reverse_pixels(row);
+        }
+
+        ppu->sprite_shifter_pattern[i] = row;
+        ppu->sprite_attrib[i] = attr;
+        ppu->sprite_x_counter[i] = sprite_x;
+    }
+}
+
+// reverses the order of the 8 2-bit pixels in a decoded row
+uint16_t reverse_pixels(uint16_t row) {
+    row = (row >> 8) | (row << 8);
+    row = ((row & 0xF0F0) >> 4) | ((row & 0x0F0F) << 4);
+    row = ((row & 0xCCCC) >> 2) | ((row & 0x3333) << 2);
+    return row;
+}
 
-        // skip transparent pixels
-        if (color_id == 0) {
+uint8_t get_sprite_pixel(PPU *ppu, int *sprite_hit, int bg_transparent) {    
+    uint8_t color_id = 0;
+    int sprite = -1;
+
+    // advance the sprite shifters, the first opaque sprite in secondary OAM (lowest OAM index) wins
+    for (int i = 0; i < ppu->sprite_count; i++) {
+        if (ppu->sprite_x_counter[i] > 0) {
+            ppu->sprite_x_counter[i]--; // sprite has not started yet
             continue;
         }
 
-        // handle sprite 0 hit logic 
-        if (i == 0 && !bg_transparent) {
-            *sprite_hit = 1;
+        if (sprite < 0) {
+            uint8_t pixel = ppu->sprite_shifter_pattern[i] >> 14;
+            if (pixel != 0) {
+                color_id = pixel;
+                sprite = i;
+            }
         }
 
-        // get palette color
-        uint8_t palette_index = 0x10 + ((attr & 0x03) << 2) + color_id;
-        uint16_t palette_addr = palette_index & 0x1F;
-        SDL_Color color = nes_palette[ppu->palette_ram[palette_addr] & 0x3F];
+        ppu->sprite_shifter_pattern[i] <<= 2;
+    }
 
-        // apply grayscale if needed
-        if (ppu->PPUMASK & PPUMASK_Gr) {
-            uint8_t gray = (color.r + color.g + color.b) / 3;
-            color.r = color.g = color.b = gray;
-        }
+    if (!(ppu->PPUMASK & PPUMASK_s) || sprite < 0) {
+        // sprite rendering is disabled or no opaque sprite at this pixel
+        return NO_SPRITE_PIXEL;
+    }
 
-        // get sprite color and handle priority
-        if (attr & 0x20) {
-            // behind of background
-            if (bg_transparent) {
-                // background pixel is transparent
-                sprite_color = (color.r << 24) | (color.g << 16) | (color.b << 8) | 0xFF;
-                break; // first sprite is rendered
-            } else {
-                return 0x00000000; // background pixel is opaque, sprite not rendered
-            }
-        } else {
-            // in front of background
-            sprite_color = (color.r << 24) | (color.g << 16) | (color.b << 8) | 0xFF;
-            break; // first sprite is rendered
-        }      
+    uint8_t attr = ppu->sprite_attrib[sprite];
+
+    // handle sprite 0 hit logic 
+    if (sprite == 0 && ppu->sprite_zero_selected && !bg_transparent) {
+        *sprite_hit = 1;
+    }
+
+    // get palette color
+    uint8_t palette_index = 0x10 + ((attr & 0x03) << 2) + color_id;
+    uint16_t palette_addr = palette_index & 0x1F;
+    uint8_t pixel = ppu->palette_ram[palette_addr] & PIXEL_COLOR_MASK;
+
+    // handle priority
+    if ((attr & 0x20) && !bg_transparent) {
+        return NO_SPRITE_PIXEL; // behind an opaque background pixel, sprite not rendered
     }
 
-    return sprite_color;
+    return pixel;
+}
+
+// converts the indexed framebuffer to NES_WIDTH * NES_HEIGHT packed 32-bit pixels in the given PIXEL_FORMAT_*
+void ppu_convert_frame(PPU *ppu, uint32_t *dst, int format) {
+    // emphasis is tracked per line, convert each run of lines that share it in one call
+    int y = 0;
+    while (y < NES_HEIGHT) {
+        int emphasis = ppu->line_emphasis[y];
+        int lines = 1;
+        while (y + lines < NES_HEIGHT && ppu->line_emphasis[y + lines] == emphasis) {
+            lines++;
+        }
+
+        pixel_convert(&ppu->frame_buffer[y * NES_WIDTH], &dst[y * NES_WIDTH], lines * NES_WIDTH, pixel_lut(format, emphasis));
+        y += lines;
+    }
 }
 
 uint8_t ppu_register_read(PPU *ppu, uint16_t reg) {
@@ -455,6 +850,7 @@ uint8_t ppu_register_read(PPU *ppu, uint16_t reg) {
             // this is done when the state of w may not be known 
             ppu->PPUSTATUS &= ~PPUSTATUS_V; // clear VBlank
             ppu->w = 0; // clear w register
+            ppu->last_status = status;
             return status;
         }
         
@@ -490,12 +886,12 @@ uint8_t ppu_register_read(PPU *ppu, uint16_t reg) {
                 if ((mirrored_addr & 0x13) == 0x10) {
                     mirrored_addr &= ~0x10;
                 }
-                ppu->data_buffer = nes_ppu_read((ppu->v & 0x2FFF)); // fill buffer with normal VRAM read
+                ppu->data_buffer = nes_ppu_read(ppu->nes, (ppu->v & 0x2FFF)); // fill buffer with normal VRAM read
                 ppu->PPUDATA = ppu->palette_ram[mirrored_addr];
             } else { // Normal VRAM read
                 // buffer data reads for one extra cycle
                 ppu->PPUDATA = ppu->data_buffer;
-                ppu->data_buffer = nes_ppu_read(ppu->v);
+                ppu->data_buffer = nes_ppu_read(ppu->nes, ppu->v);
             }
 
             // Increase address after read
@@ -605,7 +1001,7 @@ void ppu_register_write(PPU *ppu, uint16_t reg, uint8_t value) {
                 uint16_t palette_addr = palette_offset;
                 ppu->palette_ram[palette_addr] = value;
             } else { // Write to VRAM
-                nes_ppu_write(ppu->v, value);
+                nes_ppu_write(ppu->nes, ppu->v, value);
             }
 
             // Auto increment address after write based on PPUCTRL setting
@@ -624,11 +1020,11 @@ void ppu_register_write(PPU *ppu, uint16_t reg, uint8_t value) {
 
 void ppu_oam_dma_transfer(PPU *ppu) {
     uint16_t address = ppu->oam_dma_page << 8;
-    uint8_t byte = nes_cpu_read(address | (uint16_t)ppu->oam_dma_cycle);
+    uint8_t byte = nes_cpu_read(ppu->nes, address | (uint16_t)ppu->oam_dma_cycle);
     ppu->oam[(ppu->OAMADDR + ppu->oam_dma_cycle) % 256] = byte;
 }
 
-SDL_Color nes_palette[64] = {
+PaletteColor nes_palette[64] = {
     {124,124,124,255}, {0,0,252,255},   {0,0,188,255},   {68,40,188,255},
     {148,0,132,255},   {168,0,32,255},  {168,16,0,255},  {136,20,0,255},
     {80,48,0,255},     {0,120,0,255},   {0,104,0,255},   {0,88,0,255},